@@ -0,0 +1,78 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __KM_BLKDEV_H
+#define __KM_BLKDEV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "jerryscript.h"
+
+/**
+ * Block device ioctl operations (same as the `ioctl()` of JS block devices)
+ */
+#define KM_BLKDEV_IOCTL_INIT 1
+#define KM_BLKDEV_IOCTL_SHUTDOWN 2
+#define KM_BLKDEV_IOCTL_SYNC 3
+#define KM_BLKDEV_IOCTL_BLOCK_COUNT 4
+#define KM_BLKDEV_IOCTL_BLOCK_SIZE 5
+#define KM_BLKDEV_IOCTL_BLOCK_ERASE 6
+#define KM_BLKDEV_IOCTL_BUFFER_SIZE 7
+
+typedef struct km_blkdev_s km_blkdev_t;
+
+/**
+ * Native block device operations. `read` and `write` access `size` bytes
+ * starting at `offset` in `block`; the range may span consecutive blocks.
+ * All functions return a negative error code on failure.
+ */
+typedef struct {
+  int (*read)(km_blkdev_t *blkdev, uint32_t block, uint32_t offset,
+              uint8_t *buffer, size_t size);
+  int (*write)(km_blkdev_t *blkdev, uint32_t block, uint32_t offset,
+               const uint8_t *buffer, size_t size);
+  int (*ioctl)(km_blkdev_t *blkdev, int op, int arg);
+} km_blkdev_ops_t;
+
+/**
+ * Native block devices embed this as their first member and are allocated
+ * with malloc(). They are freed together with the JS object they are
+ * attached to.
+ */
+struct km_blkdev_s {
+  const km_blkdev_ops_t *ops;
+};
+
+extern const jerry_object_native_info_t km_blkdev_native_info;
+
+/**
+ * Attach a native block device to a JS block device object
+ */
+void km_blkdev_attach(jerry_value_t obj, km_blkdev_t *blkdev);
+
+/**
+ * Get the native block device of a JS object, or NULL for block devices
+ * implemented in JS.
+ */
+km_blkdev_t *km_blkdev_get(jerry_value_t obj);
+
+#endif /* __KM_BLKDEV_H */
@@ -25,7 +25,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "gpio.h"
 #include "jerryscript.h"
+#include "ringbuffer.h"
 #include "utils.h"
 
 typedef struct km_io_loop_s km_io_loop_t;
@@ -37,16 +39,36 @@ typedef struct km_io_watch_handle_s km_io_watch_handle_t;
 typedef struct km_io_uart_handle_s km_io_uart_handle_t;
 typedef struct km_io_idle_handle_s km_io_idle_handle_t;
 typedef struct km_io_stream_handle_s km_io_stream_handle_t;
+typedef struct km_io_spi_handle_s km_io_spi_handle_t;
+typedef struct km_io_sampler_handle_s km_io_sampler_handle_t;
 
 /* handle flags */
 
 #define KM_IO_FLAG_ACTIVE 0x01
 #define KM_IO_FLAG_CLOSING 0x02
+#define KM_IO_FLAG_INTERNAL 0x04  // owned by native code, not found by id
 
 #define KM_IO_SET_FLAG_ON(field, flag) ((field) |= (flag))
 #define KM_IO_SET_FLAG_OFF(field, flag) ((field) &= ~(flag))
 #define KM_IO_HAS_FLAG(field, flag) ((field) & (flag))
 
+/* timer scheduler */
+
+#define KM_IO_TIMER_HEAP_INIT_SIZE 16
+#define KM_IO_TIMER_INDEX_SIZE 64  // must be power of 2
+#define KM_IO_TIMER_NOT_QUEUED -1
+#define KM_IO_TIMER_EXPIRED -2
+
+/* GPIO interrupt event queues */
+
+#define KM_IO_GPIO_MAX 32
+#define KM_IO_GPIO_QUEUE_SIZE 16  // must be power of 2
+#define KM_IO_IRQ_QUEUE_SIZE 256  // must be power of 2
+
+/* maximum sleep time of the tickless loop (msec) */
+
+#define KM_IO_MAX_WAIT_TIME 1000
+
 /* general handle types */
 
 typedef enum km_io_type {
@@ -55,7 +77,9 @@ typedef enum km_io_type {
   KM_IO_WATCH,
   KM_IO_UART,
   KM_IO_IDLE,
-  KM_IO_STREAM
+  KM_IO_STREAM,
+  KM_IO_SPI,
+  KM_IO_SAMPLER
 } km_io_type_t;
 
 typedef void (*km_io_close_cb)(km_io_handle_t *);
@@ -80,6 +104,8 @@ struct km_io_timer_handle_s {
   uint64_t interval;
   bool repeat;
   uint32_t tag;  // for application use
+  int32_t heap_index;  // position in the deadline heap
+  km_io_timer_handle_t *index_next;  // chain in the id index bucket
 };
 
 /* TTY handle types */
@@ -113,19 +139,55 @@ struct km_io_watch_handle_s {
   uint8_t val;
   km_io_watch_cb watch_cb;
   jerry_value_t watch_js_cb;
+  bool irq;               // edges are captured by GPIO interrupt
+  uint32_t tail;          // read position in the pin's event queue
+  bool pending;           // an edge is waiting for the debounce delay
+  uint8_t pending_val;    // pin level after the last edge
+  uint32_t pending_time;  // usec timestamp of the last edge
+  uint32_t overflow;      // number of edges lost by queue overflow
 };
 
+typedef struct {
+  uint32_t time;   // usec timestamp of the edge
+  uint8_t events;  // KM_IO_WATCH_MODE_FALLING and/or KM_IO_WATCH_MODE_RISING
+  uint8_t level;   // pin level read in the interrupt
+  uint8_t pin;
+} km_io_gpio_event_t;
+
+typedef struct {
+  uint32_t head;  // written only by the interrupt handler
+  km_io_gpio_event_t events[KM_IO_GPIO_QUEUE_SIZE];
+  uint8_t watch_count;
+} km_io_gpio_queue_t;
+
+/* called in the loop with the events queued by the GPIO interrupt */
+typedef void (*km_io_gpio_irq_cb)(km_io_gpio_event_t *events, uint32_t count);
+
 /* UART handle type */
 
 typedef int (*km_io_uart_available_cb)(km_io_uart_handle_t *);
+typedef uint8_t *(*km_io_uart_alloc_cb)(km_io_uart_handle_t *, size_t);
 typedef void (*km_io_uart_read_cb)(km_io_uart_handle_t *, uint8_t *, size_t);
+typedef void (*km_io_uart_drain_cb)(km_io_uart_handle_t *);
 
 struct km_io_uart_handle_s {
   km_io_handle_t base;
   uint8_t port;
   km_io_uart_available_cb available_cb;
+  km_io_uart_alloc_cb alloc_cb;  // optional, returns a buffer to read into
   km_io_uart_read_cb read_cb;
   jerry_value_t read_js_cb;
+  uint32_t batch_size;     // read when this many bytes are available
+  uint32_t batch_timeout;  // or when no more bytes arrived for this msec
+  uint32_t batch_length;   // bytes available at the last check
+  uint64_t batch_time;     // msec when batch_length was changed
+  uint8_t *tx_buffer;
+  ringbuffer_t tx_ringbuffer;  // queue of bytes to transmit
+  uint32_t tx_sending;     // bytes being written by km_uart_write_async()
+  uint32_t tx_high_water;  // emit drain after the queue exceeded this
+  bool tx_need_drain;
+  km_io_uart_drain_cb drain_cb;
+  jerry_value_t drain_js_cb;
 };
 
 /* idle handle types */
@@ -150,17 +212,74 @@ struct km_io_stream_handle_s {
   km_io_stream_read_cb read_cb;
 };
 
+/* SPI handle type */
+
+typedef void (*km_io_spi_cb)(km_io_spi_handle_t *, int);
+typedef void (*km_io_spi_cleanup_cb)(km_io_spi_handle_t *);
+
+struct km_io_spi_handle_s {
+  km_io_handle_t base;
+  uint8_t bus;
+  km_io_spi_cb transfer_cb;  // called in the loop when the transfer is done
+  km_io_spi_cleanup_cb cleanup_cb;  // frees the handle on cleanup, if set
+                                    // (instead of free)
+};
+
+/* sampler handle type */
+
+typedef void (*km_io_sampler_cb)(km_io_sampler_handle_t *, uint32_t);
+typedef void (*km_io_sampler_cleanup_cb)(km_io_sampler_handle_t *);
+
+struct km_io_sampler_handle_s {
+  km_io_handle_t base;
+  uint16_t *buffer;       // ring of block_count blocks
+  uint32_t block_size;    // samples per block
+  uint32_t block_count;   // blocks in the ring
+  uint32_t wait_time;     // msec the loop may sleep while sampling
+  uint32_t pos;           // sample index to write next, updated by producer
+  uint32_t reserved;      // total blocks reserved, updated by producer
+  uint32_t head;          // total blocks filled, updated by producer
+  uint32_t tail;          // total blocks delivered, updated by the loop
+  uint32_t overflow;      // total samples dropped, updated by producer
+  uint32_t generation;    // incremented on each start
+  km_io_sampler_cb block_cb;  // called in the loop with the block index
+  km_io_sampler_cleanup_cb cleanup_cb;  // frees the handle on cleanup, if
+                                        // set (instead of free)
+};
+
 /* loop type */
 
+typedef struct {
+  uint64_t iterations;
+  uint64_t idle_time;   // usec spent waiting for events
+  uint64_t start_time;  // usec when the stats were reset
+} km_io_loop_stats_t;
+
 struct km_io_loop_s {
   bool stop_flag;
+  bool tickless;
   uint64_t time;
-  km_list_t timer_handles;
+  km_io_loop_stats_t stats;
+  km_io_timer_handle_t **timer_heap;  // min-heap ordered by clamped_timeout
+  uint32_t timer_heap_size;
+  uint32_t timer_heap_capacity;
+  km_io_timer_handle_t *timer_index[KM_IO_TIMER_INDEX_SIZE];  // id -> handle
+  uint32_t timer_count;
+  km_list_t timer_expired;
   km_list_t tty_handles;
   km_list_t watch_handles;
+  km_io_gpio_queue_t *gpio_queues[KM_IO_GPIO_MAX];
+  uint8_t gpio_irq_events[KM_IO_GPIO_MAX];  // events for gpio_irq_cb
+  km_io_gpio_irq_cb gpio_irq_cb;
+  km_io_gpio_event_t irq_events[KM_IO_IRQ_QUEUE_SIZE];
+  uint32_t irq_head;  // written only by the interrupt handler
+  uint32_t irq_tail;  // written only by the loop
+  uint32_t irq_overflow[KM_IO_GPIO_MAX];  // events dropped on a full queue
   km_list_t uart_handles;
   km_list_t idle_handles;
   km_list_t stream_handles;
+  km_list_t spi_handles;  // handles with a transfer in progress
+  km_list_t sampler_handles;
   km_list_t closing_handles;
 };
 
@@ -169,6 +288,10 @@ struct km_io_loop_s {
 void km_io_init();
 void km_io_cleanup();
 void km_io_run(bool infinite);
+void km_io_set_tickless(bool tickless);
+bool km_io_get_tickless();
+km_io_loop_stats_t *km_io_get_stats();
+void km_io_reset_stats();
 
 /* general handle functions */
 
@@ -179,8 +302,8 @@ km_io_handle_t *km_io_handle_get_by_id(uint32_t id, km_list_t *handle_list);
 /* timer functions */
 
 void km_io_timer_init(km_io_timer_handle_t *timer);
-void km_io_timer_start(km_io_timer_handle_t *timer, km_io_timer_cb timer_cb,
-                       uint64_t interval, bool repeat);
+int km_io_timer_start(km_io_timer_handle_t *timer, km_io_timer_cb timer_cb,
+                      uint64_t interval, bool repeat);
 void km_io_timer_stop(km_io_timer_handle_t *timer);
 km_io_timer_handle_t *km_io_timer_get_by_id(uint32_t id);
 void km_io_timer_cleanup();
@@ -201,13 +324,27 @@ void km_io_watch_stop(km_io_watch_handle_t *watch);
 km_io_watch_handle_t *km_io_watch_get_by_id(uint32_t id);
 void km_io_watch_cleanup();
 
+/* GPIO interrupt functions */
+
+void km_io_gpio_irq_set_callback(km_io_gpio_irq_cb cb);
+int km_io_gpio_irq_attach(uint8_t pin, uint8_t events);
+int km_io_gpio_irq_detach(uint8_t pin);
+void km_io_gpio_irq_disable();
+uint32_t km_io_gpio_irq_overflow(uint8_t pin);
+
 /* UART function */
 
 void km_io_uart_init(km_io_uart_handle_t *uart);
 void km_io_uart_read_start(km_io_uart_handle_t *uart, uint8_t port,
                            km_io_uart_available_cb available_cb,
                            km_io_uart_read_cb read_cb);
+void km_io_uart_set_batch(km_io_uart_handle_t *uart, uint32_t size,
+                          uint32_t timeout, km_io_uart_alloc_cb alloc_cb);
 void km_io_uart_read_stop(km_io_uart_handle_t *uart);
+int km_io_uart_write_start(km_io_uart_handle_t *uart, uint32_t size,
+                           uint32_t high_water, km_io_uart_drain_cb drain_cb);
+int km_io_uart_write(km_io_uart_handle_t *uart, uint8_t *buf, size_t len);
+void km_io_uart_flush(km_io_uart_handle_t *uart);
 km_io_uart_handle_t *km_io_uart_get_by_id(uint32_t id);
 void km_io_uart_cleanup();
 
@@ -228,6 +365,30 @@ void km_io_stream_read_start(km_io_stream_handle_t *stream,
                              km_io_stream_read_cb read_cb);
 void km_io_stream_read_stop(km_io_stream_handle_t *stream);
 void km_io_stream_cleanup();
+
+/* SPI functions */
+
+void km_io_spi_init(km_io_spi_handle_t *spi);
+int km_io_spi_transfer(km_io_spi_handle_t *spi, uint8_t bus,
+                       const uint8_t *tx_buf, uint8_t *rx_buf, size_t len,
+                       km_io_spi_cb transfer_cb);
+bool km_io_spi_is_busy(km_io_spi_handle_t *spi);
+void km_io_spi_cleanup();
+
+/* sampler functions */
+
+void km_io_sampler_init(km_io_sampler_handle_t *sampler);
+void km_io_sampler_start(km_io_sampler_handle_t *sampler, uint16_t *buffer,
+                         uint32_t block_size, uint32_t block_count,
+                         uint32_t wait_time, km_io_sampler_cb block_cb);
+void km_io_sampler_stop(km_io_sampler_handle_t *sampler);
+bool km_io_sampler_put(km_io_sampler_handle_t *sampler, const uint16_t *buf,
+                       size_t len);
+uint16_t *km_io_sampler_reserve(km_io_sampler_handle_t *sampler);
+void km_io_sampler_commit(km_io_sampler_handle_t *sampler);
+void km_io_sampler_drop(km_io_sampler_handle_t *sampler, size_t len);
+km_io_sampler_handle_t *km_io_sampler_get_by_id(uint32_t id);
+void km_io_sampler_cleanup();
 // int km_io_stream_is_readable(km_io_stream_handle_t *stream);
 // int km_io_stream_read(km_io_stream_handle_t *stream);
 // void km_io_stream_push(km_io_stream_handle_t *stream, uint8_t *buffer, size_t
@@ -48,6 +48,8 @@
 #define MSTR_DETACH_INTERRUPT "detachInterrupt"
 #define MSTR_ENABLE_INTERRUPTS "enableInterrupts"
 #define MSTR_DISABLE_INTERRUPTS "disableInterrupts"
+#define MSTR_INTERRUPT_OVERFLOW "interruptOverflow"
+#define MSTR_BATCH "batch"
 #define MSTR_PULSE_READ "pulseRead"
 #define MSTR_TIMEOUT "timeout"
 #define MSTR_START_STATE "startState"
@@ -90,6 +92,12 @@
 #define MSTR_PLATFORM "platform"
 #define MSTR_VERSION "version"
 #define MSTR_MEMORY_USAGE "memoryUsage"
+#define MSTR_LOOP_STATS "loopStats"
+#define MSTR_SET_TICKLESS "setTickless"
+#define MSTR_TICKLESS "tickless"
+#define MSTR_ITERATIONS "iterations"
+#define MSTR_IDLE_TIME "idleTime"
+#define MSTR_LOOP_TIME "loopTime"
 #define MSTR_BINDING "binding"
 #define MSTR_BUILTIN_MODULES "builtin_modules"
 #define MSTR_GET_BUILTIN_MODULE "getBuiltinModule"
@@ -22,8 +22,20 @@
 #ifndef __KM_ADC_H
 #define __KM_ADC_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#define KM_ADC_CAPTURE_BITS 12
+#define KM_ADC_CAPTURE_PIN_MIN 26  // ADC inputs of rp2 (emulated on linux)
+#define KM_ADC_CAPTURE_PIN_MAX 30
+
+/**
+ * Called from an interrupt handler (or a thread) when a capture buffer is
+ * filled. filled is NULL if the data were discarded. Returns the buffer to
+ * fill after the one being filled now, or NULL to discard that data.
+ */
+typedef uint16_t *(*km_adc_capture_cb)(uint16_t *filled, void *arg);
+
 /**
  * Initialize all ADC channels when system started
  */
@@ -50,6 +62,43 @@ int km_adc_setup(uint8_t pin);
  */
 double km_adc_read(uint8_t adcIndex);
 
+/**
+ * Read a raw value from a ADC channel. It can be called from an interrupt
+ * handler.
+ *
+ * @param ADC index (output of km_adc_setup).
+ * @return Return a value read between 0 and 65535.
+ */
+uint16_t km_adc_read_u16(uint8_t adcIndex);
+
+/**
+ * Start free-running capture of ADC channels in round-robin order into
+ * buffers of block_size samples, double-buffered: buf0 is filled first,
+ * then buf1, then the buffers returned by capture_cb. Samples are raw
+ * conversion results of KM_ADC_CAPTURE_BITS bits, interleaved in ascending
+ * order of channels.
+ *
+ * @param channels ADC indexes (output of km_adc_setup) in ascending order.
+ * @param count Number of channels.
+ * @param rate Frames (one sample of every channel) per second.
+ * @param block_size Samples per buffer. Must be a multiple of count.
+ * @param buf0
+ * @param buf1
+ * @param capture_cb
+ * @param arg Argument passed to capture_cb.
+ * @return Returns 0 on success or minus value (err) on failure.
+ */
+int km_adc_capture_start(const uint8_t *channels, uint8_t count, uint32_t rate,
+                         size_t block_size, uint16_t *buf0, uint16_t *buf1,
+                         km_adc_capture_cb capture_cb, void *arg);
+
+/**
+ * Stop the capture. capture_cb is not called after this returns.
+ *
+ * @return Returns 0 on success or minus value (err) on failure.
+ */
+int km_adc_capture_stop();
+
 /**
  * Close the ADC channel
  *
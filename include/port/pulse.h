@@ -0,0 +1,90 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __KM_PULSE_H
+#define __KM_PULSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Pulse engines capture the durations of the levels of a pin, or generate
+ * a waveform from durations, in the background with hardware timing.
+ * Durations are in microseconds.
+ */
+
+#define KM_PULSE_MAX 4          // engine ids are less than this
+#define KM_PULSE_NO_STATE 255  // start_state to start with the current level
+
+/**
+ * Initialize all pulse engines when system started
+ */
+void km_pulse_init();
+
+/**
+ * Stop all pulse engines when system cleanup
+ */
+void km_pulse_cleanup();
+
+/**
+ * Start to capture the durations of the levels of a pin into buf.
+ *
+ * @param pin Pin number.
+ * @param start_state Wait for this level to start, or KM_PULSE_NO_STATE.
+ * @param buf Buffer for the durations.
+ * @param length Number of durations to capture.
+ * @param timeout Capture ends when a level lasts longer than this (usec).
+ * @return Returns engine id on success or minus value (err) on failure.
+ */
+int km_pulse_capture_start(uint8_t pin, uint8_t start_state, uint32_t *buf,
+                           size_t length, uint32_t timeout);
+
+/**
+ * Start to generate a waveform. The pin is set to start_state, and toggled
+ * after each duration in buf.
+ *
+ * @param pin Pin number.
+ * @param start_state Initial level of the pin.
+ * @param buf Durations of the levels, 2 usec or more.
+ * @param length Number of durations.
+ * @return Returns engine id on success or minus value (err) on failure.
+ */
+int km_pulse_generate_start(uint8_t pin, uint8_t start_state,
+                            const uint32_t *buf, size_t length);
+
+/**
+ * Check if an engine is done.
+ *
+ * @param id Engine id.
+ * @return Returns EBUSY while running, otherwise the number of durations
+ * captured or generated. Captured durations are ready in the buffer.
+ */
+int km_pulse_status(uint8_t id);
+
+/**
+ * Stop an engine and release it. The pin keeps its last level.
+ *
+ * @param id Engine id.
+ * @return Returns 0 on success or minus value (err) on failure.
+ */
+int km_pulse_stop(uint8_t id);
+
+#endif /* __KM_PULSE_H */
@@ -0,0 +1,62 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __KM_SAMPLER_H
+#define __KM_SAMPLER_H
+
+#include <stdint.h>
+
+/**
+ * Tick callback of a sampling timer. It is called from an interrupt handler
+ * or a timer thread, so it must not call JerryScript APIs.
+ */
+typedef void (*km_sampler_tick_cb)(void *arg);
+
+/**
+ * Initialize all sampling timers when system started
+ */
+void km_sampler_init();
+
+/**
+ * Stop all sampling timers when system cleanup
+ */
+void km_sampler_cleanup();
+
+/**
+ * Start a hardware (or precise) timer calling tick_cb at a fixed rate.
+ *
+ * @param period_us Interval between ticks in microseconds.
+ * @param tick_cb
+ * @param arg Argument passed to tick_cb.
+ * @return Returns timer id on success or minus value (err) on failure.
+ */
+int km_sampler_start(uint32_t period_us, km_sampler_tick_cb tick_cb,
+                     void *arg);
+
+/**
+ * Stop the timer. tick_cb is not called after this returns.
+ *
+ * @param id Timer id (output of km_sampler_start).
+ * @return Returns 0 on success or minus value (err) on failure.
+ */
+int km_sampler_stop(uint8_t id);
+
+#endif /* __KM_SAMPLER_H */
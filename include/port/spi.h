@@ -116,6 +116,28 @@ int km_spi_send(uint8_t bus, uint8_t *buf, size_t len, uint32_t timeout);
 int km_spi_recv(uint8_t bus, uint8_t send_byte, uint8_t *buf, size_t len,
                 uint32_t timeout);
 
+/**
+ * Start sending and receiving data in background (e.g. by DMA). The buffers
+ * must be kept until km_spi_transfer_busy() returns false. Targets without
+ * background transfer support complete the transfer before returning.
+ *
+ * @param bus
+ * @param tx_buf Data to send, or NULL to send 0xFF bytes
+ * @param rx_buf Buffer for received data, or NULL to discard them
+ * @param len
+ * @return 0 if the transfer is started, or minus value (err) on failure.
+ */
+int km_spi_transfer_async(uint8_t bus, const uint8_t *tx_buf, uint8_t *rx_buf,
+                          size_t len);
+
+/**
+ * Check whether a transfer started by km_spi_transfer_async() is in progress.
+ *
+ * @param bus
+ * @return true if the transfer is not completed yet.
+ */
+bool km_spi_transfer_busy(uint8_t bus);
+
 /**
  * Set SPI baudrate - change the clock frequency
  *
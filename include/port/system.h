@@ -69,6 +69,14 @@ uint64_t km_micro_gettime(void);
  */
 void km_micro_delay(uint32_t usec);
 
+/**
+ * Wait for an event (interrupt, incoming data) or until the timeout elapsed.
+ * Used by the event loop to sleep when nothing is due. It may return early.
+ *
+ * @param {uint32_t} timeout in milliseconds
+ */
+void km_wait_for_event(uint32_t timeout);
+
 /**
  * check script running mode - skipping or running user script
  */
@@ -22,6 +22,7 @@
 #ifndef __KM_UART_H
 #define __KM_UART_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -45,6 +46,13 @@ typedef struct {
   int8_t rts;
 } km_uart_pins_t;
 
+typedef struct {
+  uint32_t size;        // size of the read buffer
+  uint32_t length;      // bytes in the read buffer
+  uint32_t high_water;  // maximum bytes reached in the read buffer
+  uint32_t overflow;    // bytes dropped because the read buffer was full
+} km_uart_stats_t;
+
 /**
  * Return default UART pins. -1 means there is no default value on that pin.
  */
@@ -69,7 +77,7 @@ void km_uart_cleanup();
  * @param parity
  * @param stop stopbits 1 or 2
  * @param flow
- * @param buffer_size The size of read buffer
+ * @param buffer_size The size of read buffer (may be rounded up)
  * @param pins pin numbers for the Tx/Rx/CTS/RTS
  * @return Positive number if successfully setup, negative otherwise.
  */
@@ -88,6 +96,25 @@ int km_uart_setup(uint8_t port, uint32_t baudrate, uint8_t bits,
  */
 int km_uart_write(uint8_t port, uint8_t *buf, size_t len);
 
+/**
+ * Start writing a given buffer to the port in background (e.g. by DMA). The
+ * buffer must be kept until km_uart_write_busy() returns false.
+ *
+ * @param port
+ * @param buf
+ * @param len
+ * @return 0 if the write is started, negative otherwise.
+ */
+int km_uart_write_async(uint8_t port, uint8_t *buf, size_t len);
+
+/**
+ * Check whether a write started by km_uart_write_async() is in progress.
+ *
+ * @param port
+ * @return true if in progress.
+ */
+bool km_uart_write_busy(uint8_t port);
+
 /**
  * Check the number of bytes available to read.
  *
@@ -106,6 +133,16 @@ uint32_t km_uart_available(uint8_t port);
  */
 uint32_t km_uart_read(uint8_t port, uint8_t *buf, size_t len);
 
+/**
+ * Get the statistics of the read buffer.
+ *
+ * @param port
+ * @param stats
+ * @param reset reset high_water and overflow after reading them.
+ * @return 0 on success, negative otherwise.
+ */
+int km_uart_get_stats(uint8_t port, km_uart_stats_t *stats, bool reset);
+
 /**
  * Close the UART port
  *
@@ -6,12 +6,15 @@
 typedef struct {
   uint8_t *buf;
   uint32_t length;
+  uint32_t mask;  // length - 1 if length is a power of 2, otherwise 0
   uint32_t r_ptr;
   uint32_t w_ptr;
 } ringbuffer_t;
 
 /**
- * Initialize a ringbuffer with a given alocated buffer.
+ * Initialize a ringbuffer with a given alocated buffer. A power of 2 length
+ * is recommended for faster index arithmetic. One byte of the buffer is
+ * always kept empty, so the ringbuffer can hold up to (len - 1) bytes.
  *
  * @param ringbuffer
  * @param pbuf pointer to internal buffer
@@ -53,7 +56,8 @@ uint32_t ringbuffer_freespace(ringbuffer_t *ringbuffer);
 void ringbuffer_read(ringbuffer_t *ringbuffer, uint8_t *buf, uint32_t len);
 
 /**
- * Write into data from the ring buffer.
+ * Write into data from the ring buffer. Unread data are overwritten if
+ * there is not enough free space.
  *
  * @param ringbuffer
  * @param buf data to write.
@@ -98,4 +102,33 @@ void ringbuffer_flush(ringbuffer_t *ringbuffer, uint32_t len);
  */
 int ringbuffer_find(ringbuffer_t *ringbuffer, uint8_t ch);
 
+/**
+ * Get the contiguous region of data to read, without copying. Call
+ * ringbuffer_flush() to consume the data after using the region.
+ *
+ * @param ringbuffer
+ * @param region pointer to store the start address of the region.
+ * @return length of the region. Less than ringbuffer_length() if the data is
+ * wrapped around the end of the buffer.
+ */
+uint32_t ringbuffer_peek(ringbuffer_t *ringbuffer, uint8_t **region);
+
+/**
+ * Get the contiguous region of free space to write in place. Call
+ * ringbuffer_commit() to make the written data readable.
+ *
+ * @param ringbuffer
+ * @param region pointer to store the start address of the region.
+ * @return length of the region.
+ */
+uint32_t ringbuffer_reserve(ringbuffer_t *ringbuffer, uint8_t **region);
+
+/**
+ * Commit data written in the region returned by ringbuffer_reserve().
+ *
+ * @param ringbuffer
+ * @param len length of data written, not greater than the region.
+ */
+void ringbuffer_commit(ringbuffer_t *ringbuffer, uint32_t len);
+
 #endif /* __RINGBUFFER_H */
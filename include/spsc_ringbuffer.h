@@ -0,0 +1,130 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __SPSC_RINGBUFFER_H
+#define __SPSC_RINGBUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Lock-free ring buffer for a single producer (e.g. an interrupt handler or
+ * the other core) and a single consumer. Only the producer may call the
+ * write functions and only the consumer may call the read functions. Unlike
+ * ringbuffer_t, data that do not fit are dropped and counted, not
+ * overwritten.
+ */
+typedef struct {
+  uint8_t *buf;
+  uint32_t size;        // power of 2
+  uint32_t mask;        // size - 1
+  uint32_t head;        // total bytes written, updated by the producer
+  uint32_t tail;        // total bytes read, updated by the consumer
+  uint32_t overflow;    // total bytes dropped, updated by the producer
+  uint32_t high_water;  // maximum length reached, updated by the producer
+} spsc_ringbuffer_t;
+
+/**
+ * Initialize a ring buffer with a given allocated buffer.
+ *
+ * @param ringbuffer
+ * @param buf pointer to internal buffer
+ * @param size size of internal buffer. Must be a power of 2.
+ */
+void spsc_ringbuffer_init(spsc_ringbuffer_t *ringbuffer, uint8_t *buf,
+                          uint32_t size);
+
+/**
+ * Return the length of data in the ring buffer. Can be called from both
+ * sides.
+ *
+ * @param ringbuffer
+ * @return length of data
+ */
+uint32_t spsc_ringbuffer_length(spsc_ringbuffer_t *ringbuffer);
+
+/**
+ * [Producer] Write a byte.
+ *
+ * @param ringbuffer
+ * @param ch
+ * @return false if dropped because the ring buffer is full.
+ */
+bool spsc_ringbuffer_put(spsc_ringbuffer_t *ringbuffer, uint8_t ch);
+
+/**
+ * [Producer] Write data. Bytes that do not fit are dropped.
+ *
+ * @param ringbuffer
+ * @param buf data to write.
+ * @param len size of data to write.
+ * @return the number of bytes written.
+ */
+uint32_t spsc_ringbuffer_write(spsc_ringbuffer_t *ringbuffer,
+                               const uint8_t *buf, uint32_t len);
+
+/**
+ * [Consumer] Read out data.
+ *
+ * @param ringbuffer
+ * @param buf buffer to store data read.
+ * @param len maximum length to read.
+ * @return the number of bytes read.
+ */
+uint32_t spsc_ringbuffer_read(spsc_ringbuffer_t *ringbuffer, uint8_t *buf,
+                              uint32_t len);
+
+/**
+ * [Consumer] Get the contiguous region of data to read in place. Call
+ * spsc_ringbuffer_flush() after using the region.
+ *
+ * @param ringbuffer
+ * @param region pointer to store the start address of the region.
+ * @return length of the region.
+ */
+uint32_t spsc_ringbuffer_peek(spsc_ringbuffer_t *ringbuffer,
+                              uint8_t **region);
+
+/**
+ * [Consumer] Discard data.
+ *
+ * @param ringbuffer
+ * @param len length of data to discard.
+ */
+void spsc_ringbuffer_flush(spsc_ringbuffer_t *ringbuffer, uint32_t len);
+
+/**
+ * Return the total number of bytes dropped.
+ */
+uint32_t spsc_ringbuffer_overflow(spsc_ringbuffer_t *ringbuffer);
+
+/**
+ * Return the maximum length of data reached.
+ */
+uint32_t spsc_ringbuffer_high_water(spsc_ringbuffer_t *ringbuffer);
+
+/**
+ * Reset the overflow and high water statistics. Updates by the producer at
+ * the same time may be lost.
+ */
+void spsc_ringbuffer_reset_stats(spsc_ringbuffer_t *ringbuffer);
+
+#endif /* __SPSC_RINGBUFFER_H */
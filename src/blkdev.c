@@ -0,0 +1,44 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "blkdev.h"
+
+#include <stdlib.h>
+
+static void blkdev_freecb(void *handle,
+                          struct jerry_object_native_info_t *info_p) {
+  free(handle);
+}
+
+const jerry_object_native_info_t km_blkdev_native_info = {
+    .free_cb = blkdev_freecb};
+
+void km_blkdev_attach(jerry_value_t obj, km_blkdev_t *blkdev) {
+  jerry_object_set_native_ptr(obj, &km_blkdev_native_info, blkdev);
+}
+
+km_blkdev_t *km_blkdev_get(jerry_value_t obj) {
+  if (!jerry_value_is_object(obj)) {
+    return NULL;
+  }
+  return (km_blkdev_t *)jerry_object_get_native_ptr(obj,
+                                                    &km_blkdev_native_info);
+}
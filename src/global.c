@@ -220,7 +220,7 @@ JERRYXX_FUN(pulse_read_fn) {
   JERRYXX_CHECK_ARG_NUMBER(1, "count");
   JERRYXX_CHECK_ARG_OBJECT_OPT(2, "options");
   uint8_t pin = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
-  uint8_t count = (uint8_t)JERRYXX_GET_ARG_NUMBER(1);
+  uint32_t count = (uint32_t)JERRYXX_GET_ARG_NUMBER(1);
   uint32_t timeout = 1000000U;  // default is 1s
   uint8_t state = 255;          // 255 means undefined.
   uint8_t mode = 255;           // 255 means undefined.
@@ -228,7 +228,10 @@ JERRYXX_FUN(pulse_read_fn) {
   uint8_t trigger_start_state = 0;  // default is LOW
   size_t trigger_len = 0;
   uint32_t *trigger_buf = NULL;
-  uint32_t *buf = malloc(count * 4);
+  uint32_t *buf = malloc((count > 0 ? count : 1) * 4);
+  if (buf == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
 
   // read options
   if (JERRYXX_HAS_ARG(2)) {
@@ -420,80 +423,163 @@ static void register_global_digital_io() {
 /****************************************************************************/
 
 static jerry_value_t irq_js_cb[GPIO_MAX];
+static bool irq_batch[GPIO_MAX];
 
-static void irq_cb(uint8_t pin, km_gpio_io_mode_t mode) {
-  jerry_value_t cb = irq_js_cb[pin];
-  if (jerry_value_is_function(cb)) {
-    jerry_value_t this_val = jerry_undefined();
-    jerry_value_t arg_pin = jerry_number(pin);
-    jerry_value_t arg_mode = jerry_number(mode);
-    jerry_value_t args_p[2] = {arg_pin, arg_mode};
-    jerry_value_t ret_val = jerry_call(cb, this_val, args_p, 2);
-    if (jerry_value_is_error(ret_val)) {
-      // print error
-      jerryxx_print_error(ret_val, true);
+static void irq_call(jerry_value_t cb, jerry_value_t *args_p, int args_cnt) {
+  jerry_value_t this_val = jerry_undefined();
+  jerry_value_t ret_val = jerry_call(cb, this_val, args_p, args_cnt);
+  if (jerry_value_is_error(ret_val)) {
+    // print error
+    jerryxx_print_error(ret_val, true);
+  }
+  jerry_value_free(ret_val);
+  jerry_value_free(this_val);
+}
+
+/**
+ * Call the batch callback of the pin with the events of the pin in `events`
+ * as (pin, modes: Uint8Array, times: Uint32Array).
+ */
+static void irq_batch_call(uint8_t pin, km_io_gpio_event_t *events,
+                           uint32_t count, uint32_t pin_count) {
+  jerry_value_t modes = jerry_typedarray(JERRY_TYPEDARRAY_UINT8, pin_count);
+  jerry_value_t times = jerry_typedarray(JERRY_TYPEDARRAY_UINT32, pin_count);
+  jerry_length_t modes_offset = 0, times_offset = 0, length = 0;
+  jerry_value_t modes_buffer =
+      jerry_typedarray_buffer(modes, &modes_offset, &length);
+  jerry_value_t times_buffer =
+      jerry_typedarray_buffer(times, &times_offset, &length);
+  uint8_t *modes_p = jerry_arraybuffer_data(modes_buffer) + modes_offset;
+  uint32_t *times_p =
+      (uint32_t *)(jerry_arraybuffer_data(times_buffer) + times_offset);
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < count && n < pin_count; i++) {
+    if (events[i].pin == pin) {
+      modes_p[n] = events[i].events;
+      times_p[n] = events[i].time;
+      n++;
+    }
+  }
+  jerry_value_free(modes_buffer);
+  jerry_value_free(times_buffer);
+  jerry_value_t cb = jerry_value_copy(irq_js_cb[pin]);
+  jerry_value_t arg_pin = jerry_number(pin);
+  jerry_value_t args_p[3] = {arg_pin, modes, times};
+  irq_call(cb, args_p, 3);
+  jerry_value_free(arg_pin);
+  jerry_value_free(modes);
+  jerry_value_free(times);
+  jerry_value_free(cb);
+}
+
+/**
+ * Called in the loop with a batch of events queued by the GPIO interrupt.
+ * A per-event callback is called as (pin, mode, time) in the order of the
+ * events, then each batch callback is called once with all of its events.
+ */
+static void irq_cb(km_io_gpio_event_t *events, uint32_t count) {
+  uint32_t batch_count[GPIO_MAX] = {0};
+  for (uint32_t i = 0; i < count; i++) {
+    uint8_t pin = events[i].pin;
+    if (pin >= GPIO_MAX || !jerry_value_is_function(irq_js_cb[pin])) {
+      continue;  // detached
     }
+    if (irq_batch[pin]) {
+      batch_count[pin]++;
+      continue;
+    }
+    // the callback may detach itself
+    jerry_value_t cb = jerry_value_copy(irq_js_cb[pin]);
+    jerry_value_t arg_pin = jerry_number(pin);
+    jerry_value_t arg_mode = jerry_number(events[i].events);
+    jerry_value_t arg_time = jerry_number(events[i].time);
+    jerry_value_t args_p[3] = {arg_pin, arg_mode, arg_time};
+    irq_call(cb, args_p, 3);
     jerry_value_free(arg_pin);
     jerry_value_free(arg_mode);
-    jerry_value_free(ret_val);
-    jerry_value_free(this_val);
+    jerry_value_free(arg_time);
+    jerry_value_free(cb);
+  }
+  for (uint8_t pin = 0; pin < GPIO_MAX; pin++) {
+    if (batch_count[pin] > 0 && irq_batch[pin] &&
+        jerry_value_is_function(irq_js_cb[pin])) {
+      irq_batch_call(pin, events, count, batch_count[pin]);
+    }
   }
-  jerry_value_free(cb);
 }
 
 JERRYXX_FUN(attach_interrupt_fn) {
   JERRYXX_CHECK_ARG_NUMBER(0, "pin");
   JERRYXX_CHECK_ARG_FUNCTION(1, "callback");
   JERRYXX_CHECK_ARG_NUMBER_OPT(2, "events");
+  JERRYXX_CHECK_ARG_OBJECT_OPT(3, "options");
   uint8_t pin = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
   jerry_value_t callback = JERRYXX_GET_ARG(1);
   km_io_watch_mode_t events =
       JERRYXX_GET_ARG_NUMBER_OPT(2, KM_IO_WATCH_MODE_CHANGE);
+  bool batch = false;
+  if (JERRYXX_HAS_ARG(3)) {
+    batch = jerryxx_get_property_boolean(JERRYXX_GET_ARG(3), MSTR_BATCH,
+                                         false);
+  }
   if ((events & KM_IO_WATCH_MODE_CHANGE) == 0) {
     char errmsg[255];
     sprintf(errmsg,
             "Only RISING, FALLING and CHANGE can be set for interrupt event.");
     return jerry_error_sz(JERRY_ERROR_RANGE, (const char *)errmsg);
   }
-  if (jerry_value_is_function(callback)) {
-    irq_js_cb[pin] = jerry_value_copy(callback);
-    km_gpio_irq_set_callback(irq_cb);
-  }
-  if (km_gpio_irq_attach(pin, events) < 0) {
+  if (pin >= GPIO_MAX || km_io_gpio_irq_attach(pin, events) < 0) {
     char errmsg[255];
     sprintf(errmsg, "The pin \"%d\" can't be used for GPIO", pin);
     return jerry_error_sz(JERRY_ERROR_RANGE, (const char *)errmsg);
   }
+  jerry_value_free(irq_js_cb[pin]);
+  irq_js_cb[pin] = jerry_value_copy(callback);
+  irq_batch[pin] = batch;
+  km_io_gpio_irq_set_callback(irq_cb);
   return jerry_undefined();
 }
 
 JERRYXX_FUN(detach_interrupt_fn) {
   JERRYXX_CHECK_ARG_NUMBER(0, "pin");
   uint8_t pin = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
-  if (km_gpio_irq_detach(pin) < 0) {
+  if (pin >= GPIO_MAX || km_io_gpio_irq_detach(pin) < 0) {
     char errmsg[255];
     sprintf(errmsg, "The pin \"%d\" can't be used for GPIO", pin);
     return jerry_error_sz(JERRY_ERROR_RANGE, (const char *)errmsg);
   }
-  km_gpio_irq_detach(pin);
   jerry_value_free(irq_js_cb[pin]);
   irq_js_cb[pin] = 0;
+  irq_batch[pin] = false;
   return jerry_undefined();
 }
 
+/**
+ * Return the number of interrupt events of the pin dropped because the
+ * event queue was full.
+ */
+JERRYXX_FUN(interrupt_overflow_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "pin");
+  uint8_t pin = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
+  return jerry_number(km_io_gpio_irq_overflow(pin));
+}
+
 JERRYXX_FUN(enable_interrupts_fn) {
-  km_gpio_irq_set_callback(irq_cb);
+  km_io_gpio_irq_set_callback(irq_cb);
   km_gpio_irq_enable();
   return jerry_undefined();
 }
 
 JERRYXX_FUN(disable_interrupts_fn) {
-  km_gpio_irq_set_callback(NULL);
-  km_gpio_irq_disable();
+  km_io_gpio_irq_disable();
   return jerry_undefined();
 }
 
 static void register_global_interrupts() {
+  for (int i = 0; i < GPIO_MAX; i++) {
+    irq_js_cb[i] = 0;
+    irq_batch[i] = false;
+  }
   jerry_value_t global = jerry_current_realm();
   jerryxx_set_property_function(global, MSTR_ATTACH_INTERRUPT,
                                 attach_interrupt_fn);
@@ -503,6 +589,8 @@ static void register_global_interrupts() {
                                 enable_interrupts_fn);
   jerryxx_set_property_function(global, MSTR_DISABLE_INTERRUPTS,
                                 disable_interrupts_fn);
+  jerryxx_set_property_function(global, MSTR_INTERRUPT_OVERFLOW,
+                                interrupt_overflow_fn);
   jerry_value_free(global);
 }
 
@@ -544,9 +632,17 @@ JERRYXX_FUN(set_timeout_fn) {
   jerry_value_t callback = JERRYXX_GET_ARG(0);
   uint64_t delay = (uint64_t)JERRYXX_GET_ARG_NUMBER(1);
   km_io_timer_handle_t *timer = malloc(sizeof(km_io_timer_handle_t));
+  if (timer == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
   km_io_timer_init(timer);
   timer->timer_js_cb = jerry_value_copy(callback);
-  km_io_timer_start(timer, set_timer_cb, delay, false);
+  int ret = km_io_timer_start(timer, set_timer_cb, delay, false);
+  if (ret < 0) {
+    jerry_value_free(timer->timer_js_cb);
+    free(timer);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
   return jerry_number(timer->base.id);
 }
 
@@ -556,9 +652,17 @@ JERRYXX_FUN(set_interval_fn) {
   jerry_value_t callback = JERRYXX_GET_ARG(0);
   uint64_t delay = (uint64_t)JERRYXX_GET_ARG_NUMBER(1);
   km_io_timer_handle_t *timer = malloc(sizeof(km_io_timer_handle_t));
+  if (timer == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
   km_io_timer_init(timer);
   timer->timer_js_cb = jerry_value_copy(callback);
-  km_io_timer_start(timer, set_timer_cb, delay, true);
+  int ret = km_io_timer_start(timer, set_timer_cb, delay, true);
+  if (ret < 0) {
+    jerry_value_free(timer->timer_js_cb);
+    free(timer);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
   return jerry_number(timer->base.id);
 }
 
@@ -703,9 +807,21 @@ JERRYXX_FUN(tone_fn) {
     // setup timer for duration
     if (duration > 0) {
       km_io_timer_handle_t *timer = malloc(sizeof(km_io_timer_handle_t));
-      km_io_timer_init(timer);
-      timer->tag = pin;
-      km_io_timer_start(timer, tone_timeout_cb, duration, false);
+      int ret = ENOMEM;
+      if (timer != NULL) {
+        km_io_timer_init(timer);
+        KM_IO_SET_FLAG_ON(timer->base.flags, KM_IO_FLAG_INTERNAL);
+        timer->tag = pin;
+        ret = km_io_timer_start(timer, tone_timeout_cb, duration, false);
+      }
+      if (ret < 0) {
+        free(timer);
+        km_pwm_stop(pin);
+        if (inversion >= 0) {
+          km_pwm_stop(inversion);
+        }
+        return jerry_exception_value(create_system_error(ret), true);
+      }
     }
     return jerry_undefined();
   }
@@ -862,6 +978,39 @@ JERRYXX_FUN(process_memory_usage_fn) {
   return jerry_undefined();
 }
 
+/**
+ * process.loopStats([reset]) function
+ * Return the event loop statistics (times in milliseconds)
+ */
+JERRYXX_FUN(process_loop_stats_fn) {
+  JERRYXX_CHECK_ARG_BOOLEAN_OPT(0, "reset");
+  bool reset = JERRYXX_GET_ARG_BOOLEAN_OPT(0, false);
+  km_io_loop_stats_t *stats = km_io_get_stats();
+  uint64_t now = km_micro_gettime();
+  jerry_value_t obj = jerry_object();
+  jerryxx_set_property_number(obj, MSTR_ITERATIONS, stats->iterations);
+  jerryxx_set_property_number(obj, MSTR_IDLE_TIME, stats->idle_time / 1000.0);
+  jerryxx_set_property_number(obj, MSTR_LOOP_TIME,
+                              (now - stats->start_time) / 1000.0);
+  jerry_value_t tickless = jerry_boolean(km_io_get_tickless());
+  jerryxx_set_property(obj, MSTR_TICKLESS, tickless);
+  jerry_value_free(tickless);
+  if (reset) {
+    km_io_reset_stats();
+  }
+  return obj;
+}
+
+/**
+ * process.setTickless(enable) function
+ * Let the event loop sleep until the next timer or interrupt
+ */
+JERRYXX_FUN(process_set_tickless_fn) {
+  JERRYXX_CHECK_ARG_BOOLEAN(0, "enable");
+  km_io_set_tickless(JERRYXX_GET_ARG_BOOLEAN(0));
+  return jerry_undefined();
+}
+
 // process.stdin getter
 JERRYXX_FUN(process_stdin_getter_fn) {
   jerry_value_t stream = jerryxx_call_require("stream");
@@ -907,6 +1056,10 @@ static void register_global_process_object() {
   jerryxx_set_property_string(process, MSTR_VERSION, KALUMA_VERSION);
   jerryxx_set_property_function(process, MSTR_MEMORY_USAGE,
                                 process_memory_usage_fn);
+  jerryxx_set_property_function(process, MSTR_LOOP_STATS,
+                                process_loop_stats_fn);
+  jerryxx_set_property_function(process, MSTR_SET_TICKLESS,
+                                process_set_tickless_fn);
 
   // add `process.binding` function and it's properties
   jerry_value_t binding_fn = jerry_function_external(process_binding_fn);
@@ -25,8 +25,10 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "err.h"
 #include "gpio.h"
 #include "system.h"
+#include "spi.h"
 #include "tty.h"
 #include "uart.h"
 
@@ -38,8 +40,12 @@ static void km_io_timer_run();
 static void km_io_tty_run();
 static void km_io_watch_run();
 static void km_io_uart_run();
+static uint32_t km_io_uart_get_wait_time(uint32_t wait);
 static void km_io_idle_run();
-static void km_io_idle_run();
+static void km_io_spi_run();
+static void km_io_sampler_run();
+static bool km_io_watch_is_polling();
+static void km_io_gpio_irq_run();
 
 /* general handle functions */
 
@@ -85,13 +91,32 @@ static void km_io_handle_closing() {
 
 void km_io_init() {
   loop.stop_flag = false;
+  loop.tickless = false;
   km_io_update_time();
+  km_io_reset_stats();
   km_list_init(&loop.tty_handles);
-  km_list_init(&loop.timer_handles);
+  loop.timer_heap = NULL;
+  loop.timer_heap_size = 0;
+  loop.timer_heap_capacity = 0;
+  loop.timer_count = 0;
+  for (int i = 0; i < KM_IO_TIMER_INDEX_SIZE; i++) {
+    loop.timer_index[i] = NULL;
+  }
+  km_list_init(&loop.timer_expired);
   km_list_init(&loop.watch_handles);
+  for (int i = 0; i < KM_IO_GPIO_MAX; i++) {
+    loop.gpio_queues[i] = NULL;
+    loop.gpio_irq_events[i] = 0;
+    loop.irq_overflow[i] = 0;
+  }
+  loop.gpio_irq_cb = NULL;
+  loop.irq_head = 0;
+  loop.irq_tail = 0;
   km_list_init(&loop.uart_handles);
   km_list_init(&loop.idle_handles);
   km_list_init(&loop.stream_handles);
+  km_list_init(&loop.spi_handles);
+  km_list_init(&loop.sampler_handles);
   km_list_init(&loop.closing_handles);
 }
 
@@ -102,87 +127,302 @@ void km_io_cleanup() {
   // km_io_idle_cleanup();
   // Do not cleanup tty I/O to keep terminal communication
   km_io_stream_cleanup();
+  km_io_spi_cleanup();
+  km_io_sampler_cleanup();
+}
+
+void km_io_set_tickless(bool tickless) { loop.tickless = tickless; }
+
+bool km_io_get_tickless() { return loop.tickless; }
+
+km_io_loop_stats_t *km_io_get_stats() { return &loop.stats; }
+
+void km_io_reset_stats() {
+  loop.stats.iterations = 0;
+  loop.stats.idle_time = 0;
+  loop.stats.start_time = km_micro_gettime();
+}
+
+/**
+ * Return how long the loop can sleep (msec) until the next event is due.
+ * Polled GPIO watches (level modes or waiting for debounce) and pending
+ * closes keep the loop spinning.
+ */
+static uint32_t km_io_get_wait_time() {
+  if (km_io_watch_is_polling() || loop.closing_handles.head != NULL ||
+      loop.timer_expired.head != NULL ||
+      __atomic_load_n(&loop.irq_head, __ATOMIC_ACQUIRE) != loop.irq_tail) {
+    return 0;
+  }
+  uint64_t wait = KM_IO_MAX_WAIT_TIME;
+  if (loop.timer_heap_size > 0) {
+    // a timer fires when clamped_timeout < loop.time
+    uint64_t deadline = loop.timer_heap[0]->clamped_timeout + 1;
+    uint64_t now = km_gettime();
+    if (deadline <= now) {
+      return 0;
+    }
+    if (deadline - now < wait) {
+      wait = deadline - now;
+    }
+  }
+  if (loop.spi_handles.head != NULL && wait > 1) {
+    wait = 1;  // check transfer completion
+  }
+  km_io_sampler_handle_t *sampler =
+      (km_io_sampler_handle_t *)loop.sampler_handles.head;
+  while (sampler != NULL) {
+    if (sampler->wait_time < wait) {
+      wait = sampler->wait_time;  // check filled blocks
+    }
+    sampler = (km_io_sampler_handle_t *)((km_list_node_t *)sampler)->next;
+  }
+  return km_io_uart_get_wait_time((uint32_t)wait);
+}
+
+static void km_io_wait() {
+  // idle handles do not keep the loop awake, but run them once more so that
+  // jobs queued by the later phases are not delayed by the sleep.
+  km_io_idle_run();
+  uint32_t wait = km_io_get_wait_time();
+  if (wait > 0) {
+    uint64_t start = km_micro_gettime();
+    km_wait_for_event(wait);
+    loop.stats.idle_time += km_micro_gettime() - start;
+  }
 }
 
 void km_io_run(bool infinite) {
   while (loop.stop_flag == false) {
+    loop.stats.iterations++;
     km_io_update_time();
     km_io_timer_run();
     km_io_tty_run();
     km_io_watch_run();
+    km_io_gpio_irq_run();
     km_io_uart_run();
+    km_io_spi_run();
+    km_io_sampler_run();
     km_io_idle_run();
     km_io_handle_closing();
     km_custom_infinite_loop();
 
     // quite if there no IO handles
     if (!infinite) {
-      if (loop.timer_handles.head == NULL && loop.watch_handles.head == NULL &&
-          loop.uart_handles.head == NULL && loop.closing_handles.head == NULL) {
+      if (loop.timer_count == 0 && loop.watch_handles.head == NULL &&
+          loop.uart_handles.head == NULL && loop.spi_handles.head == NULL &&
+          loop.sampler_handles.head == NULL &&
+          loop.closing_handles.head == NULL) {
         loop.stop_flag = true;
       }
     }
+
+    // sleep until the next timer or an interrupt in tickless mode
+    if (loop.tickless && loop.stop_flag == false) {
+      km_io_wait();
+    }
   }
 }
 
 /* timer functions */
 
-uint32_t timer_count = 0;
+static bool km_io_timer_before(km_io_timer_handle_t *a,
+                               km_io_timer_handle_t *b) {
+  if (a->clamped_timeout == b->clamped_timeout) {
+    return a->base.id < b->base.id;  // keep start order for same deadline
+  }
+  return a->clamped_timeout < b->clamped_timeout;
+}
+
+static void km_io_timer_heap_set(uint32_t idx, km_io_timer_handle_t *timer) {
+  loop.timer_heap[idx] = timer;
+  timer->heap_index = (int32_t)idx;
+}
+
+static void km_io_timer_heap_up(uint32_t idx) {
+  km_io_timer_handle_t *timer = loop.timer_heap[idx];
+  while (idx > 0) {
+    uint32_t parent = (idx - 1) / 2;
+    if (!km_io_timer_before(timer, loop.timer_heap[parent])) break;
+    km_io_timer_heap_set(idx, loop.timer_heap[parent]);
+    idx = parent;
+  }
+  km_io_timer_heap_set(idx, timer);
+}
+
+static void km_io_timer_heap_down(uint32_t idx) {
+  km_io_timer_handle_t *timer = loop.timer_heap[idx];
+  uint32_t size = loop.timer_heap_size;
+  while (true) {
+    uint32_t child = idx * 2 + 1;
+    if (child >= size) break;
+    if (child + 1 < size &&
+        km_io_timer_before(loop.timer_heap[child + 1],
+                           loop.timer_heap[child])) {
+      child++;
+    }
+    if (!km_io_timer_before(loop.timer_heap[child], timer)) break;
+    km_io_timer_heap_set(idx, loop.timer_heap[child]);
+    idx = child;
+  }
+  km_io_timer_heap_set(idx, timer);
+}
+
+static int km_io_timer_heap_push(km_io_timer_handle_t *timer) {
+  if (loop.timer_heap_size == loop.timer_heap_capacity) {
+    uint32_t capacity = loop.timer_heap_capacity > 0
+                            ? loop.timer_heap_capacity * 2
+                            : KM_IO_TIMER_HEAP_INIT_SIZE;
+    km_io_timer_handle_t **heap =
+        realloc(loop.timer_heap, capacity * sizeof(km_io_timer_handle_t *));
+    if (heap == NULL) {
+      timer->heap_index = KM_IO_TIMER_NOT_QUEUED;
+      return ENOMEM;
+    }
+    loop.timer_heap = heap;
+    loop.timer_heap_capacity = capacity;
+  }
+  loop.timer_heap[loop.timer_heap_size] = timer;
+  loop.timer_heap_size++;
+  km_io_timer_heap_up(loop.timer_heap_size - 1);
+  return 0;
+}
+
+static void km_io_timer_heap_remove(km_io_timer_handle_t *timer) {
+  uint32_t idx = (uint32_t)timer->heap_index;
+  timer->heap_index = KM_IO_TIMER_NOT_QUEUED;
+  loop.timer_heap_size--;
+  if (idx < loop.timer_heap_size) {
+    km_io_timer_heap_set(idx, loop.timer_heap[loop.timer_heap_size]);
+    if (idx > 0 && km_io_timer_before(loop.timer_heap[idx],
+                                      loop.timer_heap[(idx - 1) / 2])) {
+      km_io_timer_heap_up(idx);
+    } else {
+      km_io_timer_heap_down(idx);
+    }
+  }
+}
+
+static void km_io_timer_index_add(km_io_timer_handle_t *timer) {
+  uint32_t bucket = timer->base.id & (KM_IO_TIMER_INDEX_SIZE - 1);
+  timer->index_next = loop.timer_index[bucket];
+  loop.timer_index[bucket] = timer;
+  loop.timer_count++;
+}
+
+static void km_io_timer_index_remove(km_io_timer_handle_t *timer) {
+  uint32_t bucket = timer->base.id & (KM_IO_TIMER_INDEX_SIZE - 1);
+  km_io_timer_handle_t **link = &loop.timer_index[bucket];
+  while (*link != NULL) {
+    if (*link == timer) {
+      *link = timer->index_next;
+      timer->index_next = NULL;
+      loop.timer_count--;
+      return;
+    }
+    link = &(*link)->index_next;
+  }
+}
 
 void km_io_timer_init(km_io_timer_handle_t *timer) {
   km_io_handle_init((km_io_handle_t *)timer, KM_IO_TIMER);
   timer->timer_cb = NULL;
+  timer->heap_index = KM_IO_TIMER_NOT_QUEUED;
+  timer->index_next = NULL;
 }
 
-void km_io_timer_start(km_io_timer_handle_t *timer, km_io_timer_cb timer_cb,
-                       uint64_t interval, bool repeat) {
-  KM_IO_SET_FLAG_ON(timer->base.flags, KM_IO_FLAG_ACTIVE);
+/**
+ * Start the timer. Return 0 on success or ENOMEM if the timer heap could
+ * not grow, in which case the timer is left stopped.
+ */
+int km_io_timer_start(km_io_timer_handle_t *timer, km_io_timer_cb timer_cb,
+                      uint64_t interval, bool repeat) {
   timer->timer_cb = timer_cb;
   timer->clamped_timeout = loop.time + interval;
   timer->interval = interval;
   timer->repeat = repeat;
-  km_list_append(&loop.timer_handles, (km_list_node_t *)timer);
+  int ret = km_io_timer_heap_push(timer);
+  if (ret < 0) {
+    return ret;
+  }
+  KM_IO_SET_FLAG_ON(timer->base.flags, KM_IO_FLAG_ACTIVE);
+  km_io_timer_index_add(timer);
+  return 0;
 }
 
 void km_io_timer_stop(km_io_timer_handle_t *timer) {
   KM_IO_SET_FLAG_OFF(timer->base.flags, KM_IO_FLAG_ACTIVE);
-  km_list_remove(&loop.timer_handles, (km_list_node_t *)timer);
+  if (timer->heap_index >= 0) {
+    km_io_timer_heap_remove(timer);
+  } else if (timer->heap_index == KM_IO_TIMER_EXPIRED) {
+    km_list_remove(&loop.timer_expired, (km_list_node_t *)timer);
+    timer->heap_index = KM_IO_TIMER_NOT_QUEUED;
+  }
+  km_io_timer_index_remove(timer);
 }
 
+/**
+ * Return the timer of setTimeout()/setInterval() with the id. Internal
+ * timers (KM_IO_FLAG_INTERNAL) are not returned.
+ */
 km_io_timer_handle_t *km_io_timer_get_by_id(uint32_t id) {
-  return (km_io_timer_handle_t *)km_io_handle_get_by_id(id,
-                                                        &loop.timer_handles);
+  km_io_timer_handle_t *timer =
+      loop.timer_index[id & (KM_IO_TIMER_INDEX_SIZE - 1)];
+  while (timer != NULL) {
+    if (timer->base.id == id) {
+      if (KM_IO_HAS_FLAG(timer->base.flags, KM_IO_FLAG_INTERNAL)) {
+        return NULL;
+      }
+      return timer;
+    }
+    timer = timer->index_next;
+  }
+  return NULL;
 }
 
 void km_io_timer_cleanup() {
-  km_io_timer_handle_t *handle =
-      (km_io_timer_handle_t *)loop.timer_handles.head;
-  while (handle != NULL) {
-    km_io_timer_handle_t *next =
-        (km_io_timer_handle_t *)((km_list_node_t *)handle)->next;
-    free(handle);
-    handle = next;
+  for (int i = 0; i < KM_IO_TIMER_INDEX_SIZE; i++) {
+    km_io_timer_handle_t *handle = loop.timer_index[i];
+    while (handle != NULL) {
+      km_io_timer_handle_t *next = handle->index_next;
+      free(handle);
+      handle = next;
+    }
+    loop.timer_index[i] = NULL;
   }
-  km_list_init(&loop.timer_handles);
+  free(loop.timer_heap);
+  loop.timer_heap = NULL;
+  loop.timer_heap_size = 0;
+  loop.timer_heap_capacity = 0;
+  loop.timer_count = 0;
+  km_list_init(&loop.timer_expired);
 }
 
 static void km_io_timer_run() {
-  km_io_timer_handle_t *handle =
-      (km_io_timer_handle_t *)loop.timer_handles.head;
-  while (handle != NULL) {
-    if (KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) {
-      if (handle->clamped_timeout < loop.time) {
-        if (handle->repeat) {
-          handle->clamped_timeout = handle->clamped_timeout + handle->interval;
-        } else {
-          KM_IO_SET_FLAG_OFF(handle->base.flags, KM_IO_FLAG_ACTIVE);
-        }
-        if (handle->timer_cb) {
-          handle->timer_cb(handle);
-        }
-      }
+  /* move all expired timers out of the heap first, so a repeating timer
+     which is still behind the clock fires only once per iteration */
+  while (loop.timer_heap_size > 0 &&
+         loop.timer_heap[0]->clamped_timeout < loop.time) {
+    km_io_timer_handle_t *handle = loop.timer_heap[0];
+    km_io_timer_heap_remove(handle);
+    handle->heap_index = KM_IO_TIMER_EXPIRED;
+    km_list_append(&loop.timer_expired, (km_list_node_t *)handle);
+  }
+  while (loop.timer_expired.head != NULL) {
+    km_io_timer_handle_t *handle =
+        (km_io_timer_handle_t *)loop.timer_expired.head;
+    km_list_remove(&loop.timer_expired, (km_list_node_t *)handle);
+    handle->heap_index = KM_IO_TIMER_NOT_QUEUED;
+    if (handle->repeat) {
+      handle->clamped_timeout = handle->clamped_timeout + handle->interval;
+      // can't fail: the slot was released when the timer expired
+      km_io_timer_heap_push(handle);
+    } else {
+      KM_IO_SET_FLAG_OFF(handle->base.flags, KM_IO_FLAG_ACTIVE);
+    }
+    if (handle->timer_cb) {
+      handle->timer_cb(handle);
     }
-    handle = (km_io_timer_handle_t *)((km_list_node_t *)handle)->next;
   }
 }
 
@@ -233,11 +473,166 @@ static void km_io_tty_run() {
   }
 }
 
+/* GPIO interrupt functions */
+
+/**
+ * Called in the GPIO interrupt. Push the timestamped edge into the pin's
+ * event queue for the watches, and into the application event queue
+ * (attachInterrupt) which is delivered to gpio_irq_cb in the loop. The
+ * application queue is bounded: when it is full the edge is dropped and
+ * counted in irq_overflow, so the events already queued keep their order.
+ */
+static void km_io_gpio_irq_handler(uint8_t pin, km_gpio_io_mode_t mode) {
+  uint8_t events = (uint8_t)mode;
+  if (pin >= KM_IO_GPIO_MAX) {
+    return;
+  }
+  uint32_t time = (uint32_t)km_micro_gettime();
+  uint8_t level = (uint8_t)km_gpio_read(pin);
+  km_io_gpio_queue_t *queue = loop.gpio_queues[pin];
+  if (queue != NULL && (events & KM_IO_WATCH_MODE_CHANGE)) {
+    uint32_t head = queue->head;
+    km_io_gpio_event_t *event =
+        &queue->events[head & (KM_IO_GPIO_QUEUE_SIZE - 1)];
+    event->time = time;
+    event->events = events & KM_IO_WATCH_MODE_CHANGE;
+    event->level = level;
+    event->pin = pin;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  }
+  if (loop.gpio_irq_cb != NULL && (events & loop.gpio_irq_events[pin])) {
+    uint32_t head = loop.irq_head;
+    uint32_t tail = __atomic_load_n(&loop.irq_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= KM_IO_IRQ_QUEUE_SIZE) {
+      __atomic_store_n(&loop.irq_overflow[pin], loop.irq_overflow[pin] + 1,
+                       __ATOMIC_RELAXED);
+      return;
+    }
+    km_io_gpio_event_t *event =
+        &loop.irq_events[head & (KM_IO_IRQ_QUEUE_SIZE - 1)];
+    event->time = time;
+    event->events = events & loop.gpio_irq_events[pin];
+    event->level = level;
+    event->pin = pin;
+    __atomic_store_n(&loop.irq_head, head + 1, __ATOMIC_RELEASE);
+  }
+}
+
+/**
+ * Enable the interrupt events of the pin requested by the watches and the
+ * application callback.
+ */
+static int km_io_gpio_irq_update(uint8_t pin) {
+  uint8_t events = loop.gpio_irq_events[pin];
+  if (loop.gpio_queues[pin] != NULL) {
+    events |= KM_IO_WATCH_MODE_CHANGE;
+  }
+  km_gpio_irq_detach(pin);
+  if (events) {
+    km_gpio_irq_set_callback(km_io_gpio_irq_handler);
+    return km_gpio_irq_attach(pin, events);
+  }
+  return 0;
+}
+
+void km_io_gpio_irq_set_callback(km_io_gpio_irq_cb cb) {
+  loop.gpio_irq_cb = cb;
+}
+
+int km_io_gpio_irq_attach(uint8_t pin, uint8_t events) {
+  if (pin >= KM_IO_GPIO_MAX) {
+    return km_gpio_irq_attach(pin, events);
+  }
+  loop.gpio_irq_events[pin] = events;
+  return km_io_gpio_irq_update(pin);
+}
+
+int km_io_gpio_irq_detach(uint8_t pin) {
+  if (pin >= KM_IO_GPIO_MAX) {
+    return km_gpio_irq_detach(pin);
+  }
+  loop.gpio_irq_events[pin] = 0;
+  return km_io_gpio_irq_update(pin);
+}
+
+/**
+ * Return the number of events of the pin dropped by the full event queue
+ * since the loop was initialized.
+ */
+uint32_t km_io_gpio_irq_overflow(uint8_t pin) {
+  if (pin >= KM_IO_GPIO_MAX) {
+    return 0;
+  }
+  return __atomic_load_n(&loop.irq_overflow[pin], __ATOMIC_RELAXED);
+}
+
+/**
+ * Deliver the queued application events to gpio_irq_cb in batches of
+ * contiguous slots. Only the events queued before this call are delivered,
+ * so a fast interrupt source can't keep the loop here forever.
+ */
+static void km_io_gpio_irq_run() {
+  uint32_t head = __atomic_load_n(&loop.irq_head, __ATOMIC_ACQUIRE);
+  while (loop.irq_tail != head) {
+    uint32_t index = loop.irq_tail & (KM_IO_IRQ_QUEUE_SIZE - 1);
+    uint32_t count = head - loop.irq_tail;
+    if (count > KM_IO_IRQ_QUEUE_SIZE - index) {
+      count = KM_IO_IRQ_QUEUE_SIZE - index;  // up to the end of the ring
+    }
+    if (loop.gpio_irq_cb != NULL) {
+      loop.gpio_irq_cb(&loop.irq_events[index], count);
+    }
+    // free the slots after the callback so they are not overwritten meanwhile
+    __atomic_store_n(&loop.irq_tail, loop.irq_tail + count, __ATOMIC_RELEASE);
+  }
+}
+
+void km_io_gpio_irq_disable() {
+  loop.gpio_irq_cb = NULL;
+  for (int i = 0; i < KM_IO_GPIO_MAX; i++) {
+    if (loop.gpio_queues[i] != NULL) {
+      return;  // keep interrupts for the GPIO watches
+    }
+  }
+  km_gpio_irq_disable();
+}
+
+static km_io_gpio_queue_t *km_io_gpio_queue_open(uint8_t pin) {
+  km_io_gpio_queue_t *queue = loop.gpio_queues[pin];
+  if (queue == NULL) {
+    queue = malloc(sizeof(km_io_gpio_queue_t));
+    if (queue == NULL) {
+      return NULL;
+    }
+    queue->head = 0;
+    queue->watch_count = 0;
+    loop.gpio_queues[pin] = queue;
+    if (km_io_gpio_irq_update(pin) < 0) {
+      loop.gpio_queues[pin] = NULL;
+      km_io_gpio_irq_update(pin);
+      free(queue);
+      return NULL;
+    }
+  }
+  queue->watch_count++;
+  return queue;
+}
+
+static void km_io_gpio_queue_close(uint8_t pin) {
+  km_io_gpio_queue_t *queue = loop.gpio_queues[pin];
+  if (queue != NULL && --queue->watch_count == 0) {
+    loop.gpio_queues[pin] = NULL;
+    km_io_gpio_irq_update(pin);
+    free(queue);
+  }
+}
+
 /* GPIO watch functions */
 
 void km_io_watch_init(km_io_watch_handle_t *watch) {
   km_io_handle_init((km_io_handle_t *)watch, KM_IO_WATCH);
   watch->watch_cb = NULL;
+  watch->irq = false;
 }
 
 void km_io_watch_start(km_io_watch_handle_t *watch, km_io_watch_cb watch_cb,
@@ -251,12 +646,27 @@ void km_io_watch_start(km_io_watch_handle_t *watch, km_io_watch_cb watch_cb,
   watch->debounce_delay = debounce;
   watch->last_val = (uint8_t)km_gpio_read(watch->pin);
   watch->val = (uint8_t)km_gpio_read(watch->pin);
+  watch->irq = false;
+  watch->pending = false;
+  watch->overflow = 0;
+  // edge watches are driven by interrupt, level watches are polled
+  if ((mode & KM_IO_WATCH_MODE_CHANGE) && pin < KM_IO_GPIO_MAX) {
+    km_io_gpio_queue_t *queue = km_io_gpio_queue_open(pin);
+    if (queue != NULL) {
+      watch->irq = true;
+      watch->tail = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    }
+  }
   km_list_append(&loop.watch_handles, (km_list_node_t *)watch);
 }
 
 void km_io_watch_stop(km_io_watch_handle_t *watch) {
   KM_IO_SET_FLAG_OFF(watch->base.flags, KM_IO_FLAG_ACTIVE);
   km_list_remove(&loop.watch_handles, (km_list_node_t *)watch);
+  if (watch->irq) {
+    watch->irq = false;
+    km_io_gpio_queue_close(watch->pin);
+  }
 }
 
 km_io_watch_handle_t *km_io_watch_get_by_id(uint32_t id) {
@@ -274,50 +684,139 @@ void km_io_watch_cleanup() {
     handle = next;
   }
   km_list_init(&loop.watch_handles);
+  for (int i = 0; i < KM_IO_GPIO_MAX; i++) {
+    loop.gpio_irq_events[i] = 0;
+    if (loop.gpio_queues[i] != NULL) {
+      km_io_gpio_queue_t *queue = loop.gpio_queues[i];
+      loop.gpio_queues[i] = NULL;
+      km_gpio_irq_detach(i);
+      free(queue);
+    }
+  }
+  loop.gpio_irq_cb = NULL;
+  loop.irq_tail = loop.irq_head;  // drop undelivered events
 }
 
-static void km_io_watch_run() {
+/**
+ * Return true if any watch needs to be checked in every loop iteration
+ */
+static bool km_io_watch_is_polling() {
   km_io_watch_handle_t *handle =
       (km_io_watch_handle_t *)loop.watch_handles.head;
   while (handle != NULL) {
-    if (KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) {
-      uint8_t reading = (uint8_t)km_gpio_read(handle->pin);
-      if (handle->last_val != reading) { /* changed by noise or pressing */
-        handle->debounce_time = km_gettime();
+    if (!handle->irq || handle->pending) {
+      return true;
+    }
+    handle = (km_io_watch_handle_t *)((km_list_node_t *)handle)->next;
+  }
+  return false;
+}
+
+static void km_io_watch_change(km_io_watch_handle_t *handle, uint8_t val) {
+  if (val == handle->val) {
+    return;
+  }
+  handle->val = val;
+  switch (handle->mode) {
+    case KM_IO_WATCH_MODE_CHANGE:
+      if (handle->watch_cb) {
+        handle->watch_cb(handle);
       }
-      /* debounce delay elapsed */
-      uint32_t elapsed_time = km_gettime() - handle->debounce_time;
-      if ((handle->watch_cb) &&
-          (((handle->mode == KM_IO_WATCH_MODE_LOW_LEVEL) && (reading == 0)) ||
-           ((handle->mode == KM_IO_WATCH_MODE_HIGH_LEVEL) && (reading == 1)))) {
+      break;
+    case KM_IO_WATCH_MODE_RISING:
+      if (handle->val == 1 && handle->watch_cb) {
         handle->watch_cb(handle);
-      } else if (handle->debounce_time > 0 &&
-                 elapsed_time >= handle->debounce_delay) {
-        if (reading != handle->val) {
-          handle->val = reading;
-          switch (handle->mode) {
-            case KM_IO_WATCH_MODE_CHANGE:
-              if (handle->watch_cb) {
-                handle->watch_cb(handle);
-              }
-              break;
-            case KM_IO_WATCH_MODE_RISING:
-              if (handle->val == 1 && handle->watch_cb) {
-                handle->watch_cb(handle);
-              }
-              break;
-            case KM_IO_WATCH_MODE_FALLING:
-              if (handle->val == 0 && handle->watch_cb) {
-                handle->watch_cb(handle);
-              }
-              break;
-            default:
-              break;
-          }
-        }
-        handle->debounce_time = 0;
       }
-      handle->last_val = reading;
+      break;
+    case KM_IO_WATCH_MODE_FALLING:
+      if (handle->val == 0 && handle->watch_cb) {
+        handle->watch_cb(handle);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static void km_io_watch_edge(km_io_watch_handle_t *handle,
+                             km_io_gpio_event_t *event) {
+  uint8_t level = event->level;
+  if (event->events != KM_IO_WATCH_MODE_CHANGE) {
+    level = (event->events & KM_IO_WATCH_MODE_RISING) ? 1 : 0;
+  }
+  if (handle->debounce_delay > 0) {
+    handle->pending = true;
+    handle->pending_val = level;
+    handle->pending_time = event->time;
+  } else {
+    // both edges in a single interrupt: a pulse shorter than the latency
+    if (event->events == KM_IO_WATCH_MODE_CHANGE) {
+      km_io_watch_change(handle, !level);
+      if (!KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) return;
+    }
+    km_io_watch_change(handle, level);
+  }
+}
+
+static void km_io_watch_irq_run(km_io_watch_handle_t *handle) {
+  km_io_gpio_queue_t *queue = loop.gpio_queues[handle->pin];
+  uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  while (handle->tail != head) {
+    if (head - handle->tail > KM_IO_GPIO_QUEUE_SIZE) {
+      // overwritten by the interrupt before being read
+      handle->overflow += head - handle->tail - KM_IO_GPIO_QUEUE_SIZE;
+      handle->tail = head - KM_IO_GPIO_QUEUE_SIZE;
+    }
+    km_io_gpio_event_t event =
+        queue->events[handle->tail & (KM_IO_GPIO_QUEUE_SIZE - 1)];
+    head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (head - handle->tail > KM_IO_GPIO_QUEUE_SIZE) {
+      continue;  // the slot was overwritten while copying
+    }
+    handle->tail++;
+    km_io_watch_edge(handle, &event);
+    if (!KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) {
+      return;  // stopped in the callback
+    }
+  }
+  if (handle->pending) {
+    uint32_t elapsed = (uint32_t)km_micro_gettime() - handle->pending_time;
+    if (elapsed >= handle->debounce_delay * 1000) {
+      handle->pending = false;
+      km_io_watch_change(handle, handle->pending_val);
+    }
+  }
+}
+
+static void km_io_watch_poll_run(km_io_watch_handle_t *handle) {
+  uint8_t reading = (uint8_t)km_gpio_read(handle->pin);
+  if (handle->last_val != reading) { /* changed by noise or pressing */
+    handle->debounce_time = km_gettime();
+  }
+  /* debounce delay elapsed */
+  uint32_t elapsed_time = km_gettime() - handle->debounce_time;
+  if ((handle->watch_cb) &&
+      (((handle->mode == KM_IO_WATCH_MODE_LOW_LEVEL) && (reading == 0)) ||
+       ((handle->mode == KM_IO_WATCH_MODE_HIGH_LEVEL) && (reading == 1)))) {
+    handle->watch_cb(handle);
+  } else if (handle->debounce_time > 0 &&
+             elapsed_time >= handle->debounce_delay) {
+    km_io_watch_change(handle, reading);
+    handle->debounce_time = 0;
+  }
+  handle->last_val = reading;
+}
+
+static void km_io_watch_run() {
+  km_io_watch_handle_t *handle =
+      (km_io_watch_handle_t *)loop.watch_handles.head;
+  while (handle != NULL) {
+    if (KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) {
+      if (handle->irq) {
+        km_io_watch_irq_run(handle);
+      } else {
+        km_io_watch_poll_run(handle);
+      }
     }
     handle = (km_io_watch_handle_t *)((km_list_node_t *)handle)->next;
   }
@@ -327,6 +826,16 @@ static void km_io_watch_run() {
 
 void km_io_uart_init(km_io_uart_handle_t *uart) {
   km_io_handle_init((km_io_handle_t *)uart, KM_IO_UART);
+  uart->alloc_cb = NULL;
+  uart->batch_size = 0;
+  uart->batch_timeout = 0;
+  uart->batch_length = 0;
+  uart->batch_time = 0;
+  uart->tx_buffer = NULL;
+  uart->tx_sending = 0;
+  uart->tx_high_water = 0;
+  uart->tx_need_drain = false;
+  uart->drain_cb = NULL;
 }
 
 void km_io_uart_read_start(km_io_uart_handle_t *uart, uint8_t port,
@@ -339,11 +848,107 @@ void km_io_uart_read_start(km_io_uart_handle_t *uart, uint8_t port,
   km_list_append(&loop.uart_handles, (km_list_node_t *)uart);
 }
 
+/**
+ * Deliver received data in batches of up to `size` bytes. A smaller batch is
+ * delivered when no more bytes arrived for `timeout` msec. If alloc_cb is
+ * given, data is read directly into the buffer it returns.
+ */
+void km_io_uart_set_batch(km_io_uart_handle_t *uart, uint32_t size,
+                          uint32_t timeout, km_io_uart_alloc_cb alloc_cb) {
+  uart->batch_size = size;
+  uart->batch_timeout = timeout;
+  uart->alloc_cb = alloc_cb;
+  uart->batch_length = 0;
+  uart->batch_time = loop.time;
+}
+
 void km_io_uart_read_stop(km_io_uart_handle_t *uart) {
   KM_IO_SET_FLAG_OFF(uart->base.flags, KM_IO_FLAG_ACTIVE);
   km_list_remove(&loop.uart_handles, (km_list_node_t *)uart);
 }
 
+/**
+ * Allocate a transmit queue of `size` bytes. km_io_uart_write() returns 0
+ * when the queue holds `high_water` bytes or more, and drain_cb is called
+ * once the queue becomes empty.
+ */
+int km_io_uart_write_start(km_io_uart_handle_t *uart, uint32_t size,
+                           uint32_t high_water, km_io_uart_drain_cb drain_cb) {
+  uart->tx_buffer = (uint8_t *)malloc(size + 1);
+  if (uart->tx_buffer == NULL) {
+    return ENOMEM;
+  }
+  ringbuffer_init(&uart->tx_ringbuffer, uart->tx_buffer, size + 1);
+  uart->tx_high_water = high_water;
+  uart->drain_cb = drain_cb;
+  return 0;
+}
+
+static void km_io_uart_tx_run(km_io_uart_handle_t *uart) {
+  ringbuffer_t *ringbuffer = &uart->tx_ringbuffer;
+  if (uart->tx_sending > 0) {
+    if (km_uart_write_busy(uart->port)) {
+      return;
+    }
+    ringbuffer_flush(ringbuffer, uart->tx_sending);
+    uart->tx_sending = 0;
+  }
+  uint8_t *region;
+  uint32_t len = ringbuffer_peek(ringbuffer, &region);
+  if (len > 0) {
+    int ret = km_uart_write_async(uart->port, region, len);
+    if (ret == 0) {
+      uart->tx_sending = len;
+    } else if (ret != EBUSY) {  // discard the queue if failed to write
+      ringbuffer_flush(ringbuffer, ringbuffer_length(ringbuffer));
+    }
+  }
+}
+
+/**
+ * Queue data to transmit. This blocks only when the queue is full.
+ *
+ * @return 1 if the queue is below the high water mark, 0 if the caller
+ * should wait for drain_cb, or negative on error.
+ */
+int km_io_uart_write(km_io_uart_handle_t *uart, uint8_t *buf, size_t len) {
+  if (uart->tx_buffer == NULL) {
+    return EINVAL;
+  }
+  ringbuffer_t *ringbuffer = &uart->tx_ringbuffer;
+  while (len > 0) {
+    uint32_t space = ringbuffer_freespace(ringbuffer);
+    if (space == 0) {  // wait until some bytes are written
+      km_io_uart_tx_run(uart);
+      continue;
+    }
+    uint32_t n = (len < space) ? len : space;
+    ringbuffer_write(ringbuffer, buf, n);
+    buf += n;
+    len -= n;
+    if (uart->tx_sending == 0) {
+      km_io_uart_tx_run(uart);
+    }
+  }
+  if (ringbuffer_length(ringbuffer) >= uart->tx_high_water) {
+    uart->tx_need_drain = true;
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * Block until all queued data are written
+ */
+void km_io_uart_flush(km_io_uart_handle_t *uart) {
+  if (uart->tx_buffer == NULL) {
+    return;
+  }
+  while (ringbuffer_length(&uart->tx_ringbuffer) > 0) {
+    km_io_uart_tx_run(uart);
+  }
+}
+
 km_io_uart_handle_t *km_io_uart_get_by_id(uint32_t id) {
   return (km_io_uart_handle_t *)km_io_handle_get_by_id(id, &loop.uart_handles);
 }
@@ -353,22 +958,95 @@ void km_io_uart_cleanup() {
   while (handle != NULL) {
     km_io_uart_handle_t *next =
         (km_io_uart_handle_t *)((km_list_node_t *)handle)->next;
+    if (handle->tx_buffer != NULL) {
+      free(handle->tx_buffer);
+    }
     free(handle);
     handle = next;
   }
   km_list_init(&loop.uart_handles);
 }
 
+/**
+ * Return the number of bytes to read now, or 0 if the batch is not ready yet
+ */
+static int km_io_uart_batch_ready(km_io_uart_handle_t *handle, int len) {
+  if (handle->batch_size == 0) {
+    return len;
+  }
+  if (len != handle->batch_length) {
+    handle->batch_length = len;
+    handle->batch_time = loop.time;
+  }
+  if (len >= handle->batch_size) {
+    return handle->batch_size;
+  }
+  if (loop.time - handle->batch_time >= handle->batch_timeout) {
+    return len;
+  }
+  return 0;
+}
+
+/**
+ * Return msec until the earliest batch timeout or transmit progress check of
+ * the UART handles
+ */
+static uint32_t km_io_uart_get_wait_time(uint32_t wait) {
+  km_io_uart_handle_t *handle = (km_io_uart_handle_t *)loop.uart_handles.head;
+  while (handle != NULL) {
+    if (KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) {
+      if (handle->tx_buffer != NULL &&
+          ringbuffer_length(&handle->tx_ringbuffer) > 0 && wait > 1) {
+        wait = 1;
+      }
+      if (handle->batch_length > 0) {
+        uint64_t deadline = handle->batch_time + handle->batch_timeout;
+        if (deadline <= loop.time) {
+          return 0;
+        }
+        if (deadline - loop.time < wait) {
+          wait = deadline - loop.time;
+        }
+      }
+    }
+    handle = (km_io_uart_handle_t *)((km_list_node_t *)handle)->next;
+  }
+  return wait;
+}
+
 static void km_io_uart_run() {
   km_io_uart_handle_t *handle = (km_io_uart_handle_t *)loop.uart_handles.head;
   while (handle != NULL) {
     if (KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) {
       if (handle->available_cb != NULL && handle->read_cb != NULL) {
-        int len = handle->available_cb(handle);
+        int avail = handle->available_cb(handle);
+        int len = km_io_uart_batch_ready(handle, avail);
         if (len > 0) {
-          uint8_t buf[len];
-          km_uart_read(handle->port, buf, len);
-          handle->read_cb(handle, buf, len);
+          if (handle->alloc_cb != NULL) {
+            uint8_t *buf = handle->alloc_cb(handle, len);
+            if (buf != NULL) {
+              len = km_uart_read(handle->port, buf, len);
+              handle->batch_length = avail - len;
+              handle->batch_time = loop.time;
+              handle->read_cb(handle, buf, len);
+            }
+          } else {
+            uint8_t buf[len];
+            len = km_uart_read(handle->port, buf, len);
+            handle->batch_length = avail - len;
+            handle->batch_time = loop.time;
+            handle->read_cb(handle, buf, len);
+          }
+        }
+      }
+      if (handle->tx_buffer != NULL) {
+        km_io_uart_tx_run(handle);
+        if (handle->tx_need_drain &&
+            ringbuffer_length(&handle->tx_ringbuffer) == 0) {
+          handle->tx_need_drain = false;
+          if (handle->drain_cb != NULL) {
+            handle->drain_cb(handle);
+          }
         }
       }
     }
@@ -477,4 +1155,229 @@ static void km_io_stream_run() {
     handle = (km_io_stream_handle_t *)((km_list_node_t *)handle)->next;
   }
 }
-*/
\ No newline at end of file
+*/
+
+/* SPI functions */
+
+void km_io_spi_init(km_io_spi_handle_t *spi) {
+  km_io_handle_init((km_io_handle_t *)spi, KM_IO_SPI);
+  spi->bus = 0;
+  spi->transfer_cb = NULL;
+  spi->cleanup_cb = NULL;
+}
+
+/**
+ * Start a background transfer. transfer_cb is called in the loop with 0 or
+ * an error code when the transfer is completed. The buffers must be kept
+ * until then.
+ */
+int km_io_spi_transfer(km_io_spi_handle_t *spi, uint8_t bus,
+                       const uint8_t *tx_buf, uint8_t *rx_buf, size_t len,
+                       km_io_spi_cb transfer_cb) {
+  if (KM_IO_HAS_FLAG(spi->base.flags, KM_IO_FLAG_ACTIVE)) {
+    return EBUSY;
+  }
+  int ret = km_spi_transfer_async(bus, tx_buf, rx_buf, len);
+  if (ret < 0) {
+    return ret;
+  }
+  KM_IO_SET_FLAG_ON(spi->base.flags, KM_IO_FLAG_ACTIVE);
+  spi->bus = bus;
+  spi->transfer_cb = transfer_cb;
+  km_list_append(&loop.spi_handles, (km_list_node_t *)spi);
+  return 0;
+}
+
+bool km_io_spi_is_busy(km_io_spi_handle_t *spi) {
+  return KM_IO_HAS_FLAG(spi->base.flags, KM_IO_FLAG_ACTIVE);
+}
+
+void km_io_spi_cleanup() {
+  km_io_spi_handle_t *handle = (km_io_spi_handle_t *)loop.spi_handles.head;
+  while (handle != NULL) {
+    km_io_spi_handle_t *next =
+        (km_io_spi_handle_t *)((km_list_node_t *)handle)->next;
+    // wait so that the buffers can be released
+    while (km_spi_transfer_busy(handle->bus)) {
+    }
+    if (handle->cleanup_cb) {
+      handle->cleanup_cb(handle);
+    } else {
+      free(handle);
+    }
+    handle = next;
+  }
+  km_list_init(&loop.spi_handles);
+}
+
+static void km_io_spi_run() {
+  km_io_spi_handle_t *handle = (km_io_spi_handle_t *)loop.spi_handles.head;
+  while (handle != NULL) {
+    km_io_spi_handle_t *next =
+        (km_io_spi_handle_t *)((km_list_node_t *)handle)->next;
+    if (!km_spi_transfer_busy(handle->bus)) {
+      KM_IO_SET_FLAG_OFF(handle->base.flags, KM_IO_FLAG_ACTIVE);
+      km_list_remove(&loop.spi_handles, (km_list_node_t *)handle);
+      if (handle->transfer_cb) {
+        handle->transfer_cb(handle, 0);
+      }
+    }
+    handle = next;
+  }
+}
+
+/* sampler functions */
+
+void km_io_sampler_init(km_io_sampler_handle_t *sampler) {
+  km_io_handle_init((km_io_handle_t *)sampler, KM_IO_SAMPLER);
+  sampler->buffer = NULL;
+  sampler->block_size = 0;
+  sampler->block_count = 0;
+  sampler->wait_time = KM_IO_MAX_WAIT_TIME;
+  sampler->pos = 0;
+  sampler->reserved = 0;
+  sampler->head = 0;
+  sampler->tail = 0;
+  sampler->overflow = 0;
+  sampler->generation = 0;
+  sampler->block_cb = NULL;
+  sampler->cleanup_cb = NULL;
+}
+
+/**
+ * Start to accept samples into a ring of block_count blocks of block_size
+ * samples. block_cb is called in the loop for each filled block, and the
+ * block is not overwritten until block_cb returns. wait_time limits how
+ * long the loop sleeps, since the producer may not wake it up.
+ */
+void km_io_sampler_start(km_io_sampler_handle_t *sampler, uint16_t *buffer,
+                         uint32_t block_size, uint32_t block_count,
+                         uint32_t wait_time, km_io_sampler_cb block_cb) {
+  KM_IO_SET_FLAG_ON(sampler->base.flags, KM_IO_FLAG_ACTIVE);
+  sampler->buffer = buffer;
+  sampler->block_size = block_size;
+  sampler->block_count = block_count;
+  sampler->wait_time = wait_time;
+  sampler->pos = 0;
+  sampler->reserved = 0;
+  sampler->head = 0;
+  sampler->tail = 0;
+  sampler->overflow = 0;
+  sampler->generation++;
+  sampler->block_cb = block_cb;
+  km_list_append(&loop.sampler_handles, (km_list_node_t *)sampler);
+}
+
+/**
+ * Stop the handle. The producer must be stopped before this is called.
+ */
+void km_io_sampler_stop(km_io_sampler_handle_t *sampler) {
+  KM_IO_SET_FLAG_OFF(sampler->base.flags, KM_IO_FLAG_ACTIVE);
+  km_list_remove(&loop.sampler_handles, (km_list_node_t *)sampler);
+}
+
+/**
+ * [Producer] Write samples, e.g. a frame of all channels, from an interrupt
+ * handler or a thread. A write never crosses a block boundary if block_size
+ * is a multiple of len.
+ *
+ * @return false if dropped because all blocks are waiting for delivery.
+ */
+bool km_io_sampler_put(km_io_sampler_handle_t *sampler, const uint16_t *buf,
+                       size_t len) {
+  uint32_t head = sampler->head;
+  uint32_t tail = __atomic_load_n(&sampler->tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= sampler->block_count) {
+    __atomic_store_n(&sampler->overflow, sampler->overflow + len,
+                     __ATOMIC_RELAXED);
+    return false;
+  }
+  uint32_t pos = sampler->pos;
+  for (size_t i = 0; i < len; i++) {
+    sampler->buffer[pos++] = buf[i];
+  }
+  if (pos % sampler->block_size == 0) {
+    if (pos == sampler->block_size * sampler->block_count) {
+      pos = 0;
+    }
+    __atomic_store_n(&sampler->head, head + 1, __ATOMIC_RELEASE);
+  }
+  sampler->pos = pos;
+  return true;
+}
+
+/**
+ * [Producer] Reserve the next block, for a producer writing into the blocks
+ * by itself (e.g. by DMA) instead of km_io_sampler_put(). Reserved blocks
+ * are filled and committed in order.
+ *
+ * @return the block to fill, or NULL if all blocks are reserved or waiting
+ * for delivery. Then the data should be dropped.
+ */
+uint16_t *km_io_sampler_reserve(km_io_sampler_handle_t *sampler) {
+  uint32_t tail = __atomic_load_n(&sampler->tail, __ATOMIC_ACQUIRE);
+  if (sampler->reserved - tail >= sampler->block_count) {
+    return NULL;
+  }
+  uint32_t block = sampler->reserved % sampler->block_count;
+  sampler->reserved++;
+  return sampler->buffer + block * sampler->block_size;
+}
+
+/**
+ * [Producer] Mark the oldest reserved block as filled.
+ */
+void km_io_sampler_commit(km_io_sampler_handle_t *sampler) {
+  __atomic_store_n(&sampler->head, sampler->head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * [Producer] Count samples dropped because no block was reserved for them.
+ */
+void km_io_sampler_drop(km_io_sampler_handle_t *sampler, size_t len) {
+  __atomic_store_n(&sampler->overflow, sampler->overflow + len,
+                   __ATOMIC_RELAXED);
+}
+
+km_io_sampler_handle_t *km_io_sampler_get_by_id(uint32_t id) {
+  return (km_io_sampler_handle_t *)km_io_handle_get_by_id(
+      id, &loop.sampler_handles);
+}
+
+void km_io_sampler_cleanup() {
+  km_io_sampler_handle_t *handle =
+      (km_io_sampler_handle_t *)loop.sampler_handles.head;
+  while (handle != NULL) {
+    km_io_sampler_handle_t *next =
+        (km_io_sampler_handle_t *)((km_list_node_t *)handle)->next;
+    if (handle->cleanup_cb) {
+      handle->cleanup_cb(handle);
+    } else {
+      free(handle);
+    }
+    handle = next;
+  }
+  km_list_init(&loop.sampler_handles);
+}
+
+static void km_io_sampler_run() {
+  km_io_sampler_handle_t *handle =
+      (km_io_sampler_handle_t *)loop.sampler_handles.head;
+  while (handle != NULL) {
+    km_io_sampler_handle_t *next =
+        (km_io_sampler_handle_t *)((km_list_node_t *)handle)->next;
+    uint32_t generation = handle->generation;
+    uint32_t head = __atomic_load_n(&handle->head, __ATOMIC_ACQUIRE);
+    while (handle->tail != head &&
+           KM_IO_HAS_FLAG(handle->base.flags, KM_IO_FLAG_ACTIVE)) {
+      if (handle->block_cb) {
+        handle->block_cb(handle, handle->tail % handle->block_count);
+      }
+      if (handle->generation != generation) {
+        break;  // restarted in the callback, head and tail were reset
+      }
+      __atomic_store_n(&handle->tail, handle->tail + 1, __ATOMIC_RELEASE);
+    }
+    handle = next;
+  }
+}
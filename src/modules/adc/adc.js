@@ -1,3 +1,6 @@
+const adc_native = process.binding(process.binding.adc);
+const { EventEmitter } = require('events');
+
 function ADC (pin) {
   this.pin = pin;
 }
@@ -6,4 +9,46 @@ ADC.prototype.read = function () {
   return analogRead(this.pin)
 }
 
+/**
+ * Capture ADC pins continuously in the background. Each 'data' event
+ * passes a block of interleaved raw samples (in the order of `pins`) as a
+ * Uint16Array view of the ring buffer, which is valid until the block is
+ * filled again.
+ */
+function ADCCapture (pins, options) {
+  EventEmitter.call(this);
+  let self = this;
+  options = options || {};
+  this._native = new adc_native.ADCCapture(pins, options, function (data, index) {
+    self.emit('data', data, index);
+  });
+  this.pins = this._native.pins;
+  this.buffer = this._native.buffer;
+  this.rate = this._native.rate;
+  this.blockSize = this._native.blockSize;
+  this.blocks = this._native.blocks;
+  this.bits = this._native.bits;
+}
+
+// Inherits from EventEmitter
+ADCCapture.prototype = new EventEmitter();
+ADCCapture.prototype.constructor = ADCCapture;
+
+ADCCapture.prototype.start = function () {
+  this._native.start();
+}
+
+ADCCapture.prototype.stop = function () {
+  this._native.stop();
+}
+
+ADCCapture.prototype.stats = function () {
+  return this._native.stats();
+}
+
+ADCCapture.prototype.close = function () {
+  this._native.close();
+}
+
 exports.ADC = ADC;
+exports.ADCCapture = ADCCapture;
@@ -25,5 +25,17 @@
 #define MSTR_ADC_ADC "ADC"
 #define MSTR_ADC_PIN "pin"
 #define MSTR_ADC_READ "read"
+#define MSTR_ADC_ADC_CAPTURE "ADCCapture"
+#define MSTR_ADC_PINS "pins"
+#define MSTR_ADC_RATE "rate"
+#define MSTR_ADC_BLOCK_SIZE "blockSize"
+#define MSTR_ADC_BLOCKS "blocks"
+#define MSTR_ADC_BITS "bits"
+#define MSTR_ADC_BUFFER "buffer"
+#define MSTR_ADC_START "start"
+#define MSTR_ADC_STOP "stop"
+#define MSTR_ADC_STATS "stats"
+#define MSTR_ADC_CLOSE "close"
+#define MSTR_ADC_OVERFLOW "overflow"
 
 #endif /* __ADC_MAGIC_STRINGS_H */
@@ -0,0 +1,2 @@
+list(APPEND SOURCES ${SRC_DIR}/modules/adc/module_adc.c)
+include_directories(${SRC_DIR}/modules/adc)
@@ -0,0 +1,331 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "adc.h"
+#include "adc_magic_strings.h"
+#include "err.h"
+#include "io.h"
+#include "jerryscript.h"
+#include "jerryxx.h"
+
+#define ADC_CAPTURE_DEFAULT_RATE 10000
+#define ADC_CAPTURE_DEFAULT_BLOCK_SIZE 512
+#define ADC_CAPTURE_DEFAULT_BLOCKS 4
+#define ADC_CAPTURE_MAX_CHANNELS 8
+
+/**
+ * ADC capture io handle. The port fills the blocks of the ring held by an
+ * ArrayBuffer in the background, and each filled block is delivered as a
+ * Uint16Array view.
+ */
+typedef struct {
+  km_io_sampler_handle_t base;
+  uint8_t count;
+  uint8_t channels[ADC_CAPTURE_MAX_CHANNELS];  // in ascending order
+  uint32_t rate;
+  bool running;
+  jerry_value_t buffer_js;
+  jerry_value_t callback_js;
+} adc_capture_handle_t;
+
+static void adc_capture_stop(adc_capture_handle_t *capture) {
+  if (capture->running) {
+    km_adc_capture_stop();
+    capture->running = false;
+    km_io_sampler_stop(&capture->base);
+  }
+}
+
+static void adc_capture_handle_freecb(
+    void *handle, struct jerry_object_native_info_t *info_p) {
+  adc_capture_handle_t *capture = (adc_capture_handle_t *)handle;
+  adc_capture_stop(capture);
+  jerry_value_free(capture->buffer_js);
+  jerry_value_free(capture->callback_js);
+  free(capture);
+}
+
+static const jerry_object_native_info_t adc_capture_handle_info = {
+    .free_cb = adc_capture_handle_freecb};
+
+/**
+ * Commit a filled block and reserve the next. Called from the DMA interrupt
+ * (or thread).
+ */
+static uint16_t *adc_capture_cb(uint16_t *filled, void *arg) {
+  adc_capture_handle_t *capture = (adc_capture_handle_t *)arg;
+  if (filled != NULL) {
+    km_io_sampler_commit(&capture->base);
+  } else {
+    km_io_sampler_drop(&capture->base, capture->base.block_size);
+  }
+  return km_io_sampler_reserve(&capture->base);
+}
+
+static void adc_capture_block_cb(km_io_sampler_handle_t *handle,
+                                 uint32_t block) {
+  adc_capture_handle_t *capture = (adc_capture_handle_t *)handle;
+  if (jerry_value_is_function(capture->callback_js)) {
+    jerry_value_t array = jerry_typedarray_with_buffer_span(
+        JERRY_TYPEDARRAY_UINT16, capture->buffer_js,
+        block * handle->block_size * sizeof(uint16_t), handle->block_size);
+    jerry_value_t index = jerry_number(block);
+    jerry_value_t this_val = jerry_undefined();
+    jerry_value_t args_p[2] = {array, index};
+    jerry_value_t ret_val =
+        jerry_call(capture->callback_js, this_val, args_p, 2);
+    if (jerry_value_is_error(ret_val)) {
+      jerryxx_print_error(ret_val, true);
+    }
+    jerry_value_free(ret_val);
+    jerry_value_free(this_val);
+    jerry_value_free(index);
+    jerry_value_free(array);
+  }
+}
+
+static void adc_capture_close_cb(km_io_handle_t *handle) { free(handle); }
+
+static void adc_capture_close_pins(const uint8_t *pins, int count) {
+  for (int i = 0; i < count; i++) {
+    km_adc_close(pins[i]);
+  }
+}
+
+/**
+ * ADCCapture constructor
+ * args:
+ *   pins {Array<number>} ADC pins, captured in round-robin
+ *   options {Object}
+ *     rate {number} frames (a sample of every pin) per second
+ *     blockSize {number} frames per block
+ *     blocks {number} blocks in the ring buffer
+ *   callback {function(data:Uint16Array, index:number)}
+ */
+JERRYXX_FUN(adc_capture_ctor_fn) {
+  JERRYXX_CHECK_ARG_ARRAY(0, "pins");
+  JERRYXX_CHECK_ARG_OBJECT(1, "options");
+  JERRYXX_CHECK_ARG_FUNCTION(2, "callback");
+  jerry_value_t pins = JERRYXX_GET_ARG(0);
+  jerry_value_t options = JERRYXX_GET_ARG(1);
+  jerry_value_t callback = JERRYXX_GET_ARG(2);
+
+  // read parameters
+  uint32_t count = jerry_array_length(pins);
+  uint32_t rate = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_ADC_RATE, ADC_CAPTURE_DEFAULT_RATE);
+  uint32_t block_frames = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_ADC_BLOCK_SIZE, ADC_CAPTURE_DEFAULT_BLOCK_SIZE);
+  uint32_t block_count = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_ADC_BLOCKS, ADC_CAPTURE_DEFAULT_BLOCKS);
+  if (count == 0 || count > ADC_CAPTURE_MAX_CHANNELS) {
+    return jerry_error_sz(JERRY_ERROR_RANGE,
+                          "pins must have 1 to 8 ADC pins.");
+  }
+  if (rate == 0) {
+    return jerry_error_sz(JERRY_ERROR_RANGE, "Invalid sampling rate.");
+  }
+  // two blocks are always being filled by the port
+  if (block_frames == 0 || block_count < 3) {
+    return jerry_error_sz(
+        JERRY_ERROR_RANGE,
+        "blockSize must be positive and blocks must be 3 or more.");
+  }
+
+  // setup channels in ascending order (the round-robin order)
+  uint8_t channels[ADC_CAPTURE_MAX_CHANNELS];
+  uint8_t channel_pins[ADC_CAPTURE_MAX_CHANNELS];
+  for (int i = 0; i < count; i++) {
+    jerry_value_t pin_js = jerry_object_get_index(pins, i);
+    uint8_t pin = (uint8_t)jerry_value_as_number(pin_js);
+    jerry_value_free(pin_js);
+    int ret = EINVPIN;
+    if (pin >= KM_ADC_CAPTURE_PIN_MIN && pin <= KM_ADC_CAPTURE_PIN_MAX) {
+      ret = km_adc_setup(pin);
+    }
+    if (ret < 0) {
+      adc_capture_close_pins(channel_pins, i);
+      return jerry_exception_value(create_system_error(ret), true);
+    }
+    for (int k = 0; k < i; k++) {
+      if (channels[k] == ret) {
+        adc_capture_close_pins(channel_pins, i);
+        return jerry_error_sz(JERRY_ERROR_RANGE, "Duplicated ADC pins.");
+      }
+    }
+    int j = i;
+    while (j > 0 && channels[j - 1] > ret) {
+      channels[j] = channels[j - 1];
+      channel_pins[j] = channel_pins[j - 1];
+      j--;
+    }
+    channels[j] = (uint8_t)ret;
+    channel_pins[j] = pin;
+  }
+
+  adc_capture_handle_t *capture = malloc(sizeof(adc_capture_handle_t));
+  if (capture == NULL) {
+    adc_capture_close_pins(channel_pins, count);
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  km_io_sampler_init(&capture->base);
+  capture->base.block_size = block_frames * count;
+  capture->base.block_count = block_count;
+  capture->count = count;
+  for (int i = 0; i < count; i++) {
+    capture->channels[i] = channels[i];
+  }
+  capture->rate = rate;
+  capture->running = false;
+
+  // allocate the ring buffer
+  capture->buffer_js = jerry_arraybuffer(capture->base.block_size *
+                                         block_count * sizeof(uint16_t));
+  if (jerry_value_is_exception(capture->buffer_js)) {
+    jerry_value_t error = capture->buffer_js;
+    free(capture);
+    adc_capture_close_pins(channel_pins, count);
+    return error;
+  }
+  capture->callback_js = jerry_value_copy(callback);
+
+  jerry_value_t pins_js = jerry_array(count);
+  for (int i = 0; i < count; i++) {
+    jerry_value_t pin_js = jerry_number(channel_pins[i]);
+    jerry_value_free(jerry_object_set_index(pins_js, i, pin_js));
+    jerry_value_free(pin_js);
+  }
+  jerryxx_set_property(JERRYXX_GET_THIS, MSTR_ADC_PINS, pins_js);
+  jerry_value_free(pins_js);
+  jerry_value_t buffer = jerry_typedarray_with_buffer(JERRY_TYPEDARRAY_UINT16,
+                                                      capture->buffer_js);
+  jerryxx_set_property(JERRYXX_GET_THIS, MSTR_ADC_BUFFER, buffer);
+  jerry_value_free(buffer);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_ADC_RATE, rate);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_ADC_BLOCK_SIZE,
+                              block_frames);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_ADC_BLOCKS, block_count);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_ADC_BITS,
+                              KM_ADC_CAPTURE_BITS);
+  jerry_object_set_native_ptr(JERRYXX_GET_THIS, &adc_capture_handle_info,
+                              capture);
+  return jerry_undefined();
+}
+
+/**
+ * ADCCapture.prototype.start() function
+ */
+JERRYXX_FUN(adc_capture_start_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(capture, adc_capture_handle_t,
+                            adc_capture_handle_info);
+  if (capture->running) {
+    return jerry_undefined();
+  }
+  km_io_sampler_handle_t *handle = &capture->base;
+  uint16_t *buffer = (uint16_t *)jerry_arraybuffer_data(capture->buffer_js);
+  // wake up at least twice per block to deliver it in time
+  uint32_t block_time = (uint32_t)(((uint64_t)handle->block_size * 1000) /
+                                   capture->count / capture->rate / 2);
+  km_io_sampler_start(handle, buffer, handle->block_size, handle->block_count,
+                      block_time > 0 ? block_time : 1, adc_capture_block_cb);
+  uint16_t *buf0 = km_io_sampler_reserve(handle);
+  uint16_t *buf1 = km_io_sampler_reserve(handle);
+  int ret = km_adc_capture_start(capture->channels, capture->count,
+                                 capture->rate, handle->block_size, buf0, buf1,
+                                 adc_capture_cb, capture);
+  if (ret < 0) {
+    km_io_sampler_stop(handle);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
+  capture->running = true;
+  return jerry_undefined();
+}
+
+/**
+ * ADCCapture.prototype.stop() function
+ */
+JERRYXX_FUN(adc_capture_stop_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(capture, adc_capture_handle_t,
+                            adc_capture_handle_info);
+  adc_capture_stop(capture);
+  return jerry_undefined();
+}
+
+/**
+ * ADCCapture.prototype.stats() function
+ * returns:
+ *   {Object} number of blocks filled and samples dropped since start()
+ */
+JERRYXX_FUN(adc_capture_stats_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(capture, adc_capture_handle_t,
+                            adc_capture_handle_info);
+  jerry_value_t obj = jerry_object();
+  jerryxx_set_property_number(
+      obj, MSTR_ADC_BLOCKS,
+      __atomic_load_n(&capture->base.head, __ATOMIC_ACQUIRE));
+  jerryxx_set_property_number(
+      obj, MSTR_ADC_OVERFLOW,
+      __atomic_load_n(&capture->base.overflow, __ATOMIC_RELAXED));
+  return obj;
+}
+
+/**
+ * ADCCapture.prototype.close() function
+ */
+JERRYXX_FUN(adc_capture_close_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(capture, adc_capture_handle_t,
+                            adc_capture_handle_info);
+  adc_capture_stop(capture);
+  jerry_value_free(capture->buffer_js);
+  jerry_value_free(capture->callback_js);
+  jerry_object_delete_native_ptr(JERRYXX_GET_THIS, &adc_capture_handle_info);
+  // free later, since close() may be called in the block callback
+  km_io_handle_close((km_io_handle_t *)capture, adc_capture_close_cb);
+  return jerry_undefined();
+}
+
+/**
+ * Initialize 'adc' module and return exports
+ */
+jerry_value_t module_adc_init() {
+  /* ADCCapture class */
+  jerry_value_t capture_ctor = jerry_function_external(adc_capture_ctor_fn);
+  jerry_value_t capture_prototype = jerry_object();
+  jerryxx_set_property(capture_ctor, "prototype", capture_prototype);
+  jerryxx_set_property_function(capture_prototype, MSTR_ADC_START,
+                                adc_capture_start_fn);
+  jerryxx_set_property_function(capture_prototype, MSTR_ADC_STOP,
+                                adc_capture_stop_fn);
+  jerryxx_set_property_function(capture_prototype, MSTR_ADC_STATS,
+                                adc_capture_stats_fn);
+  jerryxx_set_property_function(capture_prototype, MSTR_ADC_CLOSE,
+                                adc_capture_close_fn);
+  jerry_value_free(capture_prototype);
+
+  /* adc module exports */
+  jerry_value_t exports = jerry_object();
+  jerryxx_set_property(exports, MSTR_ADC_ADC_CAPTURE, capture_ctor);
+  jerry_value_free(capture_ctor);
+
+  return exports;
+}
@@ -22,7 +22,9 @@
 #include "module_flash.h"
 
 #include <stdlib.h>
+#include <string.h>
 
+#include "blkdev.h"
 #include "board.h"
 #include "err.h"
 #include "flash.h"
@@ -31,6 +33,64 @@
 #include "jerryxx.h"
 #include "magic_strings.h"
 
+typedef struct {
+  km_blkdev_t base;
+  int base_sector;
+  int count;
+  int size;
+} flash_blkdev_t;
+
+static int flash_blkdev_read(km_blkdev_t *blkdev, uint32_t block,
+                             uint32_t offset, uint8_t *buffer, size_t size) {
+  flash_blkdev_t *flash = (flash_blkdev_t *)blkdev;
+  if (((block * flash->size) + offset + size) >
+      (flash->count * flash->size)) {
+    return EINVAL;
+  }
+  memcpy(buffer,
+         km_flash_addr + ((flash->base_sector + block) * flash->size) + offset,
+         size);
+  return 0;
+}
+
+static int flash_blkdev_write(km_blkdev_t *blkdev, uint32_t block,
+                              uint32_t offset, const uint8_t *buffer,
+                              size_t size) {
+  flash_blkdev_t *flash = (flash_blkdev_t *)blkdev;
+  if (((block * flash->size) + offset + size) >
+      (flash->count * flash->size)) {
+    return EINVAL;
+  }
+  return km_flash_program(flash->base_sector + block, offset,
+                          (uint8_t *)buffer, size);
+}
+
+static int flash_blkdev_ioctl(km_blkdev_t *blkdev, int op, int arg) {
+  flash_blkdev_t *flash = (flash_blkdev_t *)blkdev;
+  switch (op) {
+    case KM_BLKDEV_IOCTL_INIT:
+    case KM_BLKDEV_IOCTL_SHUTDOWN:
+    case KM_BLKDEV_IOCTL_SYNC:
+      return 0;
+    case KM_BLKDEV_IOCTL_BLOCK_COUNT:
+      return flash->count;
+    case KM_BLKDEV_IOCTL_BLOCK_SIZE:
+      return flash->size;
+    case KM_BLKDEV_IOCTL_BLOCK_ERASE:
+      return km_flash_erase(flash->base_sector + arg, 1);
+    case KM_BLKDEV_IOCTL_BUFFER_SIZE:  // = flash page size
+      return 256;
+    default:
+      return -1;
+  }
+}
+
+static const km_blkdev_ops_t flash_blkdev_ops = {
+    .read = flash_blkdev_read,
+    .write = flash_blkdev_write,
+    .ioctl = flash_blkdev_ioctl,
+};
+
 /**
  * Flash (block device) constructor
  * args:
@@ -49,6 +109,17 @@ JERRYXX_FUN(flash_ctor_fn) {
   jerryxx_set_property_number(JERRYXX_GET_THIS, "base", base);
   jerryxx_set_property_number(JERRYXX_GET_THIS, "count", count);
   jerryxx_set_property_number(JERRYXX_GET_THIS, "size", size);
+
+  // attach native block device (used directly by the VFS modules)
+  flash_blkdev_t *flash = (flash_blkdev_t *)malloc(sizeof(flash_blkdev_t));
+  if (flash == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  flash->base.ops = &flash_blkdev_ops;
+  flash->base_sector = base;
+  flash->count = count;
+  flash->size = size;
+  km_blkdev_attach(JERRYXX_GET_THIS, (km_blkdev_t *)flash);
   return jerry_undefined();
 }
 
@@ -67,23 +138,21 @@ JERRYXX_FUN(flash_read_fn) {
   int block = JERRYXX_GET_ARG_NUMBER(0);
   jerry_value_t buffer = JERRYXX_GET_ARG(1);
   int offset = JERRYXX_GET_ARG_NUMBER_OPT(2, 0);
+  JERRYXX_GET_NATIVE_HANDLE(blkdev, km_blkdev_t, km_blkdev_native_info);
 
   // get buffer pointer
   jerry_length_t buffer_length = 0;
   jerry_length_t buffer_offset = 0;
   jerry_value_t arrbuf =
       jerry_typedarray_buffer(buffer, &buffer_offset, &buffer_length);
-  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf);
+  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf) + buffer_offset;
   jerry_value_free(arrbuf);
 
-  // printf("bd.read(%d, %d, %d)\r\n", block, buffer_length, offset);
-
   // read from flash
-  int base = jerryxx_get_property_number(JERRYXX_GET_THIS, "base", 0);
-  int size = jerryxx_get_property_number(JERRYXX_GET_THIS, "size", 0);
-  const uint8_t *addr = km_flash_addr;
-  for (int i = 0; i < buffer_length; i++) {
-    buffer_pointer[i] = addr[((base + block) * size) + offset + i];
+  int ret = blkdev->ops->read(blkdev, block, offset, buffer_pointer,
+                              buffer_length);
+  if (ret < 0) {
+    return jerry_exception_value(create_system_error(ret), true);
   }
   return jerry_undefined();
 }
@@ -103,20 +172,22 @@ JERRYXX_FUN(flash_write_fn) {
   int block = JERRYXX_GET_ARG_NUMBER(0);
   jerry_value_t buffer = JERRYXX_GET_ARG(1);
   int offset = JERRYXX_GET_ARG_NUMBER_OPT(2, 0);
+  JERRYXX_GET_NATIVE_HANDLE(blkdev, km_blkdev_t, km_blkdev_native_info);
 
   // get buffer pointer
   jerry_length_t buffer_length = 0;
   jerry_length_t buffer_offset = 0;
   jerry_value_t arrbuf =
       jerry_typedarray_buffer(buffer, &buffer_offset, &buffer_length);
-  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf);
+  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf) + buffer_offset;
   jerry_value_free(arrbuf);
 
-  // printf("bd.write(%d, %d, %d)\r\n", block, buffer_length, offset);
-
-  // write to buffer
-  int base = jerryxx_get_property_number(JERRYXX_GET_THIS, "base", 0);
-  km_flash_program(base + block, offset, buffer_pointer, buffer_length);
+  // write to flash
+  int ret = blkdev->ops->write(blkdev, block, offset, buffer_pointer,
+                               buffer_length);
+  if (ret < 0) {
+    return jerry_exception_value(create_system_error(ret), true);
+  }
   return jerry_undefined();
 }
 
@@ -132,31 +203,8 @@ JERRYXX_FUN(flash_ioctl_fn) {
   JERRYXX_CHECK_ARG_NUMBER_OPT(1, "arg")
   int op = JERRYXX_GET_ARG_NUMBER(0);
   int arg = JERRYXX_GET_ARG_NUMBER_OPT(1, 0);
-  int base = (int)jerryxx_get_property_number(JERRYXX_GET_THIS, "base", 0);
-
-  // printf("bd.ioctl(%d, %d)\r\n", op, arg);
-
-  switch (op) {
-    case 1:  // init
-      return jerry_number(0);
-    case 2:  // shutdown
-      return jerry_number(0);
-    case 3:  // sync
-      return jerry_number(0);
-    case 4:  // block count
-      return jerry_number(
-          jerryxx_get_property_number(JERRYXX_GET_THIS, "count", 0));
-    case 5:  // block size
-      return jerry_number(
-          jerryxx_get_property_number(JERRYXX_GET_THIS, "size", 0));
-    case 6:  // erase block
-      km_flash_erase(base + arg, 1);
-      return jerry_number(0);
-    case 7:  // buffer size (= flash page size)
-      return jerry_number(256);
-    default:
-      return jerry_number(-1);
-  }
+  JERRYXX_GET_NATIVE_HANDLE(blkdev, km_blkdev_t, km_blkdev_native_info);
+  return jerry_number(blkdev->ops->ioctl(blkdev, op, arg));
 }
 
 /**
@@ -85,6 +85,85 @@ void gc_set_rotation(gc_handle_t *handle, uint8_t rotation) {
   }
 }
 
+/**
+ * @brief  Clip a rectangle to the screen and map it to device coordinates
+ *   of the current rotation, so primitives can fill it row by row in the
+ *   buffer without transforming each pixel. It is also clipped to the rows
+ *   held in the buffer.
+ * @param  handle  Graphic context handle
+ * @param  x, y, w, h  Rectangle in screen coordinates, replaced by the
+ *   clipped rectangle in device coordinates
+ * @return  false if nothing is left after clipping
+ */
+bool gc_device_rect(gc_handle_t *handle, int16_t *x, int16_t *y, int16_t *w,
+                    int16_t *h) {
+  int32_t x0 = MAX(*x, 0);
+  int32_t y0 = MAX(*y, 0);
+  int32_t x1 = (int32_t)*x + *w;
+  int32_t y1 = (int32_t)*y + *h;
+  if (x1 > handle->width) x1 = handle->width;
+  if (y1 > handle->height) y1 = handle->height;
+  if (x0 >= x1 || y0 >= y1) {
+    return false;
+  }
+  switch (handle->rotation) {
+    case 1:
+      *x = handle->device_width - y1;
+      *y = x0;
+      *w = y1 - y0;
+      *h = x1 - x0;
+      break;
+    case 2:
+      *x = handle->device_width - x1;
+      *y = handle->device_height - y1;
+      *w = x1 - x0;
+      *h = y1 - y0;
+      break;
+    case 3:
+      *x = y0;
+      *y = handle->device_height - x1;
+      *w = y1 - y0;
+      *h = x1 - x0;
+      break;
+    default:
+      *x = x0;
+      *y = y0;
+      *w = x1 - x0;
+      *h = y1 - y0;
+      break;
+  }
+  int16_t top = MAX(*y, handle->buffer_y);
+  int16_t bottom = MIN(*y + *h, handle->buffer_y + handle->buffer_height);
+  if (top >= bottom) {
+    return false;
+  }
+  *y = top;
+  *h = bottom - top;
+  return true;
+}
+
+/**
+ * @brief  Mark nothing changed, after the buffer was sent to the display
+ * @param  handle  Graphic context handle
+ */
+void gc_clear_dirty(gc_handle_t *handle) {
+  handle->dirty_x0 = handle->device_width;
+  handle->dirty_y0 = handle->device_height;
+  handle->dirty_x1 = 0;
+  handle->dirty_y1 = 0;
+}
+
+/**
+ * @brief  Mark the whole screen changed
+ * @param  handle  Graphic context handle
+ */
+void gc_set_dirty(gc_handle_t *handle) {
+  handle->dirty_x0 = 0;
+  handle->dirty_y0 = 0;
+  handle->dirty_x1 = handle->device_width;
+  handle->dirty_y1 = handle->device_height;
+}
+
 /**
  * @brief   Return screen rotation
  * @param   handle    Graphic context handle
@@ -460,6 +539,11 @@ void gc_draw_char(gc_handle_t *handle, int16_t x, int16_t y, const char ch) {
     if ((x >= handle->width) || (y >= handle->height) ||
         ((x + 6 * sx - 1) < 0) || ((y + 8 * sy - 1) < 0))
       return;
+    if (handle->draw_bits_cb != NULL && sx == 1 && sy == 1) {
+      handle->draw_bits_cb(handle, x, y, &font_default_bitmap[ch * 5], 5, 8,
+                           true, handle->font_color);
+      return;
+    }
     for (int8_t i = 0; i < 5; i++) {
       uint8_t line = font_default_bitmap[ch * 5 + i];
       for (int8_t j = 0; j < 8; j++, line >>= 1) {
@@ -477,10 +561,15 @@ void gc_draw_char(gc_handle_t *handle, int16_t x, int16_t y, const char ch) {
     uint8_t h = handle->font->height;
     uint16_t sz = (((w + 7) / 8) * h);
     uint16_t idx = ((uint8_t)ch) - handle->font->first;
-    uint16_t offset = idx * sz;
+    uint32_t offset = (uint32_t)idx * sz;
     if ((x >= handle->width) || (y >= handle->height) ||
         ((x + w * sx - 1) < 0) || ((y + h * sy - 1) < 0))
       return;
+    if (handle->draw_bits_cb != NULL && sx == 1 && sy == 1) {
+      handle->draw_bits_cb(handle, x, y, &handle->font->bitmap[offset], w, h,
+                           false, handle->font_color);
+      return;
+    }
     uint8_t bit = 0;
     uint8_t bits = handle->font->bitmap[offset];
     for (uint8_t yy = 0; yy < h; yy++) {
@@ -605,8 +694,11 @@ void gc_draw_bitmap(gc_handle_t *handle, int16_t x, int16_t y, uint8_t *bitmap,
   if ((x >= handle->width) || (y >= handle->height) ||
       ((x + (w * scale_x) - 1) < 0) || ((y + (h * scale_y) - 1) < 0))
     return;
-  if (bpp == 1) {
-    uint16_t offset = 0;
+  if (bpp == 1 && handle->draw_bits_cb != NULL && scale_x == 1 &&
+      scale_y == 1 && !flip_x && !flip_y) {
+    handle->draw_bits_cb(handle, x, y, bitmap, w, h, false, color);
+  } else if (bpp == 1) {
+    uint32_t offset = 0;
     uint8_t bit = 0;
     uint8_t bits = bitmap[offset];
     for (int16_t yy = 0; yy < h; yy++) {
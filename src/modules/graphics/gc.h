@@ -41,6 +41,10 @@
 #define MAX(X, Y) ((X) > (Y) ? (X) : (Y))
 #endif
 
+#ifndef MIN
+#define MIN(X, Y) ((X) < (Y) ? (X) : (Y))
+#endif
+
 typedef struct gc_handle_s gc_handle_t;
 
 typedef void (*gc_set_pixel_cb)(gc_handle_t *, int16_t, int16_t, uint16_t);
@@ -52,6 +56,9 @@ typedef void (*gc_draw_vline_cb)(gc_handle_t *, int16_t, int16_t, int16_t,
 typedef void (*gc_fill_rect_cb)(gc_handle_t *, int16_t, int16_t, int16_t,
                                 int16_t, uint16_t);
 typedef void (*gc_fill_screen_cb)(gc_handle_t *, uint16_t);
+typedef void (*gc_draw_bits_cb)(gc_handle_t *, int16_t, int16_t,
+                                const uint8_t *, int16_t, int16_t, bool,
+                                uint16_t);
 
 /**
  * Graphic context native handle
@@ -64,7 +71,10 @@ struct gc_handle_s {
   uint8_t rotation;
   uint8_t bpp;
   uint8_t *buffer;
-  uint16_t buffer_size;
+  uint32_t buffer_size;
+  int16_t buffer_y;       // first device row held in the buffer and the
+  int16_t buffer_height;  // number of rows (all of them unless in strip mode)
+  struct gc_dlist_s *dlist;  // drawing calls recorded in strip mode, or NULL
   uint16_t color;
   uint16_t fill_color;
   gc_font_t *font;
@@ -77,12 +87,35 @@ struct gc_handle_s {
   gc_draw_vline_cb draw_vline_cb;
   gc_fill_rect_cb fill_rect_cb;
   gc_fill_screen_cb fill_screen_cb;
+  gc_draw_bits_cb draw_bits_cb;  // optional, 1-bit image blit
+  int16_t dirty_x0;  // region changed since the last display() in device
+  int16_t dirty_y0;  // coordinates, x1 and y1 exclusive (empty if x0 >= x1)
+  int16_t dirty_x1;
+  int16_t dirty_y1;
   jerry_value_t display_js_cb;
   jerry_value_t set_pixel_js_cb;
   jerry_value_t get_pixel_js_cb;
   jerry_value_t fill_rect_js_cb;
 };
 
+/**
+ * Extend the dirty region by a rectangle in device coordinates (clipped)
+ */
+static inline void gc_mark_dirty(gc_handle_t *handle, int16_t x, int16_t y,
+                                 int16_t w, int16_t h) {
+  if (x < handle->dirty_x0) handle->dirty_x0 = x;
+  if (y < handle->dirty_y0) handle->dirty_y0 = y;
+  if (x + w > handle->dirty_x1) handle->dirty_x1 = x + w;
+  if (y + h > handle->dirty_y1) handle->dirty_y1 = y + h;
+}
+
+/**
+ * Whether a device row is held in the buffer (always, unless in strip mode)
+ */
+static inline bool gc_buffer_has_row(gc_handle_t *handle, int16_t y) {
+  return y >= handle->buffer_y && y < handle->buffer_y + handle->buffer_height;
+}
+
 // primitive functions
 void gc_prim_set_pixel(gc_handle_t *handle, int16_t x, int16_t y,
                        uint16_t color);
@@ -117,6 +150,10 @@ void gc_clear_screen(gc_handle_t *handle);
 void gc_fill_screen(gc_handle_t *handle, uint16_t color);
 void gc_set_rotation(gc_handle_t *handle, uint8_t rotation);
 uint8_t gc_get_rotation(gc_handle_t *handle);
+bool gc_device_rect(gc_handle_t *handle, int16_t *x, int16_t *y, int16_t *w,
+                    int16_t *h);
+void gc_clear_dirty(gc_handle_t *handle);
+void gc_set_dirty(gc_handle_t *handle);
 void gc_set_color(gc_handle_t *handle, uint16_t color);
 uint16_t gc_get_color(gc_handle_t *handle);
 void gc_set_fill_color(gc_handle_t *handle, uint16_t color);
@@ -51,9 +51,13 @@ void gc_prim_16bit_set_pixel(gc_handle_t *handle, int16_t x, int16_t y,
         y = handle->device_height - y - 1;
         break;
     }
-    uint32_t idx = ((y * handle->device_width) + x) * 2;
+    if (!gc_buffer_has_row(handle, y)) {
+      return;
+    }
+    uint32_t idx = (((y - handle->buffer_y) * handle->device_width) + x) * 2;
     handle->buffer[idx] = color >> 8;
     handle->buffer[idx + 1] = color & 0xFF;
+    gc_mark_dirty(handle, x, y, 1, 1);
   }
 }
 
@@ -74,38 +78,105 @@ void gc_prim_16bit_get_pixel(gc_handle_t *handle, int16_t x, int16_t y,
         y = handle->device_height - y - 1;
         break;
     }
-    uint32_t idx = ((y * handle->device_width) + x) * 2;
-    *color = handle->buffer[idx] << 8 | handle->buffer[idx + 1];
+    if (gc_buffer_has_row(handle, y)) {
+      uint32_t idx = (((y - handle->buffer_y) * handle->device_width) + x) * 2;
+      *color = handle->buffer[idx] << 8 | handle->buffer[idx + 1];
+      return;
+    }
+  }
+  *color = 0;
+}
+
+/* word type which may alias the byte buffer */
+typedef uint32_t __attribute__((__may_alias__)) gc_16bit_word_t;
+
+/**
+ * Fill `count` consecutive pixels from `p` with the color. Pixels are stored
+ * big-endian, two per 32-bit word store once `p` is word aligned.
+ */
+static void gc_16bit_fill_span(uint8_t *p, uint32_t count, uint16_t color) {
+  uint8_t hi = color >> 8;
+  uint8_t lo = color & 0xFF;
+  if ((uintptr_t)p & 1) {
+    // unaligned buffer: bytes only
+    for (uint32_t i = 0; i < count; i++) {
+      *p++ = hi;
+      *p++ = lo;
+    }
+    return;
+  }
+  if (count > 0 && ((uintptr_t)p & 2)) {
+    *p++ = hi;
+    *p++ = lo;
+    count--;
+  }
+  uint8_t pattern[4] = {hi, lo, hi, lo};
+  gc_16bit_word_t word;
+  memcpy(&word, pattern, 4);
+  gc_16bit_word_t *wp = (gc_16bit_word_t *)p;
+  for (; count >= 8; count -= 8) {
+    wp[0] = word;
+    wp[1] = word;
+    wp[2] = word;
+    wp[3] = word;
+    wp += 4;
+  }
+  for (; count >= 2; count -= 2) {
+    *wp++ = word;
+  }
+  if (count > 0) {
+    p = (uint8_t *)wp;
+    p[0] = hi;
+    p[1] = lo;
+  }
+}
+
+/**
+ * Fill a rectangle given in device coordinates (already clipped)
+ */
+static void gc_16bit_fill_device_rect(gc_handle_t *handle, int16_t x,
+                                      int16_t y, int16_t w, int16_t h,
+                                      uint16_t color) {
+  uint32_t stride = handle->device_width * 2;
+  uint8_t *p = handle->buffer + (y - handle->buffer_y) * stride + x * 2;
+  if (w == handle->device_width) {
+    // full rows are contiguous in the buffer
+    gc_16bit_fill_span(p, (uint32_t)w * h, color);
+  } else if (w == 1) {
+    uint8_t hi = color >> 8;
+    uint8_t lo = color & 0xFF;
+    for (int16_t i = 0; i < h; i++) {
+      p[0] = hi;
+      p[1] = lo;
+      p += stride;
+    }
+  } else {
+    for (int16_t i = 0; i < h; i++) {
+      gc_16bit_fill_span(p, w, color);
+      p += stride;
+    }
   }
 }
 
 void gc_prim_16bit_draw_vline(gc_handle_t *handle, int16_t x, int16_t y,
                               int16_t h, uint16_t color) {
-  for (int16_t i = y; i < y + h; i++) {
-    gc_prim_16bit_set_pixel(handle, x, i, color);
-  }
+  gc_prim_16bit_fill_rect(handle, x, y, 1, h, color);
 }
 
 void gc_prim_16bit_draw_hline(gc_handle_t *handle, int16_t x, int16_t y,
                               int16_t w, uint16_t color) {
-  for (int16_t i = x; i < x + w; i++) {
-    gc_prim_16bit_set_pixel(handle, i, y, color);
-  }
+  gc_prim_16bit_fill_rect(handle, x, y, w, 1, color);
 }
 
 void gc_prim_16bit_fill_rect(gc_handle_t *handle, int16_t x, int16_t y,
                              int16_t w, int16_t h, uint16_t color) {
-  for (int16_t i = x; i < x + w; i++) {
-    gc_prim_16bit_draw_vline(handle, i, y, h, color);
+  if (gc_device_rect(handle, &x, &y, &w, &h)) {
+    gc_16bit_fill_device_rect(handle, x, y, w, h, color);
+    gc_mark_dirty(handle, x, y, w, h);
   }
 }
 
 void gc_prim_16bit_fill_screen(gc_handle_t *handle, uint16_t color) {
-  for (int16_t y = 0; y < handle->device_height; y++) {
-    for (int16_t x = 0; x < handle->device_width; x++) {
-      uint32_t idx = ((y * handle->device_width) + x) * 2;
-      handle->buffer[idx] = color >> 8;
-      handle->buffer[idx + 1] = color;
-    }
-  }
+  gc_16bit_fill_span(handle->buffer, handle->buffer_size / 2, color);
+  gc_set_dirty(handle);
 }
@@ -58,13 +58,17 @@ void gc_prim_1bit_set_pixel(gc_handle_t *handle, int16_t x, int16_t y,
         y = handle->device_height - y - 1;
         break;
     }
-    uint32_t idx = x + (y / 8) * handle->device_width;
+    if (!gc_buffer_has_row(handle, y)) {
+      return;
+    }
+    uint32_t idx = x + ((y - handle->buffer_y) / 8) * handle->device_width;
     uint8_t mask = (1 << (y & 7));
     if (color) {
       handle->buffer[idx] |= mask;
     } else {
       handle->buffer[idx] &= ~mask;
     }
+    gc_mark_dirty(handle, x, y, 1, 1);
   }
 }
 
@@ -91,14 +95,69 @@ void gc_prim_1bit_get_pixel(gc_handle_t *handle, int16_t x, int16_t y,
         y = handle->device_height - y - 1;
         break;
     }
-    *color = (handle->buffer[x + (y / 8) * handle->device_width] &
-              (1 << (y & 7))) > 0;
-    return;
+    if (gc_buffer_has_row(handle, y)) {
+      uint32_t idx = x + ((y - handle->buffer_y) / 8) * handle->device_width;
+      *color = (handle->buffer[idx] & (1 << (y & 7))) > 0;
+      return;
+    }
   }
   *color = 0;
   return;
 }
 
+/* word type which may alias the byte buffer */
+typedef uint32_t __attribute__((__may_alias__)) gc_1bit_word_t;
+
+/**
+ * Set (or clear) the bits of `mask` in `n` consecutive bytes, a word at a
+ * time once `p` is word aligned.
+ */
+static void gc_1bit_mask_span(uint8_t *p, uint32_t n, uint8_t mask,
+                              bool set) {
+  while (n > 0 && ((uintptr_t)p & 3)) {
+    *p = set ? (*p | mask) : (*p & ~mask);
+    p++;
+    n--;
+  }
+  gc_1bit_word_t word = mask * 0x01010101u;
+  gc_1bit_word_t *wp = (gc_1bit_word_t *)p;
+  if (set) {
+    for (; n >= 4; n -= 4) *wp++ |= word;
+  } else {
+    for (; n >= 4; n -= 4) *wp++ &= ~word;
+  }
+  p = (uint8_t *)wp;
+  while (n > 0) {
+    *p = set ? (*p | mask) : (*p & ~mask);
+    p++;
+    n--;
+  }
+}
+
+/**
+ * Fill a rectangle given in device coordinates (already clipped). Each page
+ * (8 rows) is filled with one masked span, or memset if the page is full.
+ */
+static void gc_1bit_fill_device_rect(gc_handle_t *handle, int16_t x,
+                                     int16_t y, int16_t w, int16_t h,
+                                     uint16_t color) {
+  int16_t y1 = y + h;
+  while (y < y1) {
+    int16_t page_end = (y | 7) + 1;
+    int16_t rows = (page_end < y1 ? page_end : y1) - y;
+    uint8_t mask = (uint8_t)(0xFF >> (8 - rows)) << (y & 7);
+    uint8_t *p =
+        handle->buffer + ((y - handle->buffer_y) >> 3) * handle->device_width +
+        x;
+    if (mask == 0xFF) {
+      memset(p, color ? 0xFF : 0, w);
+    } else {
+      gc_1bit_mask_span(p, w, mask, color != 0);
+    }
+    y += rows;
+  }
+}
+
 /**
  * @brief Primitive draw fast vertical line
  * @param handle Graphic context handle
@@ -109,9 +168,7 @@ void gc_prim_1bit_get_pixel(gc_handle_t *handle, int16_t x, int16_t y,
  */
 void gc_prim_1bit_draw_vline(gc_handle_t *handle, int16_t x, int16_t y,
                              int16_t h, uint16_t color) {
-  for (int16_t i = y; i < y + h; i++) {
-    gc_prim_1bit_set_pixel(handle, x, i, color);
-  }
+  gc_prim_1bit_fill_rect(handle, x, y, 1, h, color);
 }
 
 /**
@@ -124,9 +181,7 @@ void gc_prim_1bit_draw_vline(gc_handle_t *handle, int16_t x, int16_t y,
  */
 void gc_prim_1bit_draw_hline(gc_handle_t *handle, int16_t x, int16_t y,
                              int16_t w, uint16_t color) {
-  for (int16_t i = x; i < x + w; i++) {
-    gc_prim_1bit_set_pixel(handle, i, y, color);
-  }
+  gc_prim_1bit_fill_rect(handle, x, y, w, 1, color);
 }
 
 /**
@@ -140,8 +195,9 @@ void gc_prim_1bit_draw_hline(gc_handle_t *handle, int16_t x, int16_t y,
  */
 void gc_prim_1bit_fill_rect(gc_handle_t *handle, int16_t x, int16_t y,
                             int16_t w, int16_t h, uint16_t color) {
-  for (int16_t i = x; i < x + w; i++) {
-    gc_prim_1bit_draw_vline(handle, i, y, h, color);
+  if (gc_device_rect(handle, &x, &y, &w, &h)) {
+    gc_1bit_fill_device_rect(handle, x, y, w, h, color);
+    gc_mark_dirty(handle, x, y, w, h);
   }
 }
 
@@ -151,11 +207,152 @@ void gc_prim_1bit_fill_rect(gc_handle_t *handle, int16_t x, int16_t y,
  * @param color
  */
 void gc_prim_1bit_fill_screen(gc_handle_t *handle, uint16_t color) {
-  for (int i = 0; i < handle->buffer_size; i++) {
-    if (color) {
-      handle->buffer[i] = 255;
+  memset(handle->buffer, color ? 0xFF : 0, handle->buffer_size);
+  gc_set_dirty(handle);
+}
+
+static uint8_t gc_1bit_reverse(uint8_t b) {
+  b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+  b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+  b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+  return b;
+}
+
+/**
+ * Bytes gathered for a page column: bit `bit` of byte i becomes bit i of the
+ * column. The bytes are kept in two words, so one shift, mask and multiply
+ * per word packs the 4 bits of a word (the multiplier moves the bit of byte
+ * i to bit 24 + i without carries).
+ */
+typedef struct {
+  const uint8_t *p;  // first byte, NULL if not loaded
+  uint32_t lo;       // bytes 0..3
+  uint32_t hi;       // bytes 4..7
+} gc_1bit_gather_t;
+
+static void gc_1bit_gather_load(gc_1bit_gather_t *g, const uint8_t *p,
+                                int32_t step, uint8_t n) {
+  g->p = p;
+  g->lo = 0;
+  g->hi = 0;
+  for (uint8_t i = 0; i < n; i++, p += step) {
+    if (i < 4) {
+      g->lo |= (uint32_t)*p << (i * 8);
     } else {
-      handle->buffer[i] = 0;
+      g->hi |= (uint32_t)*p << ((i - 4) * 8);
+    }
+  }
+}
+
+static uint8_t gc_1bit_gather_bit(gc_1bit_gather_t *g, uint8_t bit) {
+  uint32_t lo = ((g->lo >> bit) & 0x01010101) * 0x01020408;
+  uint32_t hi = ((g->hi >> bit) & 0x01010101) * 0x01020408;
+  return (lo >> 24 & 0x0F) | (hi >> 20 & 0xF0);
+}
+
+/**
+ * @brief Draw the set bits of a 1-bit image with the color, leaving other
+ *   pixels unchanged. The image is written into the buffer a page column
+ *   (up to 8 pixels) at a time, in any rotation.
+ * @param handle Graphic context handle
+ * @param x, y  Position of the image
+ * @param bits  Image data, rows padded to bytes with MSB first, or if
+ *   `column` is true a byte per column with bit 0 at the top (8 rows high)
+ * @param w, h  Size of the image
+ * @param column
+ * @param color
+ */
+void gc_prim_1bit_draw_bits(gc_handle_t *handle, int16_t x, int16_t y,
+                            const uint8_t *bits, int16_t w, int16_t h,
+                            bool column, uint16_t color) {
+  int16_t dx = x, dy = y, dw = w, dh = h;
+  if (!gc_device_rect(handle, &dx, &dy, &dw, &dh)) {
+    return;
+  }
+  gc_mark_dirty(handle, dx, dy, dw, dh);
+  // source position of the device pixel (dx, dy), and the source steps for
+  // the next device column (cx, cy) and the next device row (rx, ry)
+  int32_t sx, sy;
+  int8_t cx, cy, rx, ry;
+  switch (handle->rotation) {
+    case 1:
+      sx = dy - x;
+      sy = handle->device_width - 1 - dx - y;
+      cx = 0, cy = -1, rx = 1, ry = 0;
+      break;
+    case 2:
+      sx = handle->device_width - 1 - dx - x;
+      sy = handle->device_height - 1 - dy - y;
+      cx = -1, cy = 0, rx = 0, ry = -1;
+      break;
+    case 3:
+      sx = handle->device_height - 1 - dy - x;
+      sy = dx - y;
+      cx = 0, cy = 1, rx = -1, ry = 0;
+      break;
+    default:
+      sx = dx - x;
+      sy = dy - y;
+      cx = 1, cy = 0, rx = 0, ry = 1;
+      break;
+  }
+  int32_t stride = column ? w : (w + 7) / 8;
+  int16_t y1 = dy + dh;
+  while (dy < y1) {
+    int16_t page_end = (dy | 7) + 1;
+    uint8_t n = (page_end < y1 ? page_end : y1) - dy;
+    uint8_t mask = 0xFF >> (8 - n);
+    uint8_t shift = dy & 7;
+    uint8_t *p = handle->buffer +
+                 ((dy - handle->buffer_y) >> 3) * handle->device_width + dx;
+    gc_1bit_gather_t g = {NULL, 0, 0};
+    int32_t csx = sx, csy = sy;
+    for (int16_t i = 0; i < dw; i++, csx += cx, csy += cy) {
+      // the n pixels from (csx, csy) stepping by (rx, ry) into bits 0..n-1
+      uint8_t v;
+      if (column) {
+        if (ry == 1) {
+          v = (bits[csx] >> csy) & mask;
+        } else if (ry == -1) {
+          v = gc_1bit_reverse(bits[csx] << (7 - csy)) & mask;
+        } else {
+          // along a source row: bit csy of the column bytes
+          if (g.p != bits + csx) {
+            gc_1bit_gather_load(&g, bits + csx, rx, n);
+          }
+          v = gc_1bit_gather_bit(&g, csy);
+        }
+      } else {
+        const uint8_t *row = bits + csy * stride;
+        if (ry == 0) {
+          // along a source row: sx .. sx + n - 1 (rx = 1) or sx - n + 1 ..
+          // sx (rx = -1), read as one MSB-first run with `last` in bit 0
+          int32_t first = rx > 0 ? csx : csx - n + 1;
+          int32_t last = first + n - 1;
+          uint16_t run = row[first >> 3] << 8;
+          if ((last >> 3) != (first >> 3)) {
+            run |= row[last >> 3];
+          }
+          v = (run >> (16 - (first & 7) - n)) & mask;
+          if (rx > 0) {
+            v = gc_1bit_reverse(v << (8 - n));
+          }
+        } else {
+          // along a source column: bit (7 - csx % 8) of the row bytes
+          if (g.p != row + (csx >> 3)) {
+            gc_1bit_gather_load(&g, row + (csx >> 3), ry * stride, n);
+          }
+          v = gc_1bit_gather_bit(&g, 7 - (csx & 7));
+        }
+      }
+      if (color) {
+        p[i] |= v << shift;
+      } else {
+        p[i] &= ~(v << shift);
+      }
     }
+    sx += rx * n;
+    sy += ry * n;
+    dy += n;
   }
 }
@@ -16,5 +16,8 @@ void gc_prim_1bit_draw_hline(gc_handle_t *handle, int16_t x, int16_t y,
 void gc_prim_1bit_fill_rect(gc_handle_t *handle, int16_t x, int16_t y,
                             int16_t w, int16_t h, uint16_t color);
 void gc_prim_1bit_fill_screen(gc_handle_t *handle, uint16_t color);
+void gc_prim_1bit_draw_bits(gc_handle_t *handle, int16_t x, int16_t y,
+                            const uint8_t *bits, int16_t w, int16_t h,
+                            bool column, uint16_t color);
 
 #endif /* __GC_1BIT_PRIMS_H */
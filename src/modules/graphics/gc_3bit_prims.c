@@ -93,11 +93,15 @@ void gc_prim_3bit_set_pixel(gc_handle_t *handle, int16_t x, int16_t y,
         y = handle->device_height - y - 1;
         break;
     }
-    uint32_t idx = ((y * handle->device_width) + x) / 2;
+    if (!gc_buffer_has_row(handle, y)) {
+      return;
+    }
+    uint32_t idx = (((y - handle->buffer_y) * handle->device_width) + x) / 2;
     uint8_t convertedColor = color_to_3bit(color);
     bool highPixel = ((x & 1) != 0);
     uint8_t pixel = handle->buffer[idx] & (highPixel ? 0xF8 : 0xC7);
     handle->buffer[idx] = pixel | (highPixel ? (convertedColor) : (convertedColor << 3));
+    gc_mark_dirty(handle, x, y, 1, 1);
   }
 }
 
@@ -130,16 +134,15 @@ void gc_prim_3bit_get_pixel(gc_handle_t *handle, int16_t x, int16_t y,
         y = handle->device_height - y - 1;
         break;
     }
-    uint32_t idx = ((y * handle->device_width) + x) / 2;
-
-    
-    if ((x & 1) != 0) {
+    if (gc_buffer_has_row(handle, y)) {
+      uint32_t idx = (((y - handle->buffer_y) * handle->device_width) + x) / 2;
+      if ((x & 1) != 0) {
         *color = color_from_3bit(handle->buffer[idx] & 0x07);
-    }
-    else {
+      } else {
         *color = color_from_3bit((handle->buffer[idx] & 0x38) >> 3);
+      }
+      return;
     }
-    return;
   }
   *color = 0;
   return;
@@ -200,11 +203,12 @@ void gc_prim_3bit_fill_screen(gc_handle_t *handle, uint16_t color) {
 
   uint8_t tempColor = color_to_3bit(color);
   uint8_t fillColor = (tempColor) | ((tempColor) << 3);
-  for (int16_t y = 0; y < handle->device_height; y++) {
+  for (int16_t y = 0; y < handle->buffer_height; y++) {
     uint32_t idx = (y * handle->device_width) / 2;
     for (int16_t x = 0; x < (handle->device_width/2); x++) {
       handle->buffer[idx + x] = fillColor;
     }
   }
+  gc_set_dirty(handle);
 
 }
@@ -0,0 +1,232 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "gc_dlist.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "font.h"
+#include "gc.h"
+
+#define GC_DLIST_RECORD_HEADER 4
+#define GC_DLIST_MIN_CAPACITY 256
+
+/**
+ * @brief  Create an empty display list
+ * @param  handle  Graphic context handle, whose current drawing state starts
+ *   the frame
+ * @return  NULL if out of memory
+ */
+gc_dlist_t *gc_dlist_new(gc_handle_t *handle) {
+  gc_dlist_t *dlist = (gc_dlist_t *)malloc(sizeof(gc_dlist_t));
+  if (dlist != NULL) {
+    dlist->data = NULL;
+    dlist->length = 0;
+    dlist->capacity = 0;
+    gc_dlist_save_state(handle, &dlist->start);
+  }
+  return dlist;
+}
+
+void gc_dlist_free(gc_dlist_t *dlist) {
+  if (dlist != NULL) {
+    free(dlist->data);
+    free(dlist);
+  }
+}
+
+/**
+ * @brief  Append a record to the display list
+ * @param  dlist  Display list
+ * @param  op  Operation
+ * @param  args, argc  Arguments (at most GC_DLIST_MAX_ARGS)
+ * @param  data, size  Data copied into the record (text, font, pointer)
+ * @return  false if out of memory
+ */
+bool gc_dlist_push(gc_dlist_t *dlist, gc_op_t op, const int16_t *args,
+                   uint8_t argc, const void *data, uint16_t size) {
+  uint32_t len = GC_DLIST_RECORD_HEADER + argc * sizeof(int16_t) + size;
+  if (dlist->length + len > dlist->capacity) {
+    uint32_t capacity = MAX(dlist->capacity * 2, GC_DLIST_MIN_CAPACITY);
+    while (capacity < dlist->length + len) {
+      capacity *= 2;
+    }
+    uint8_t *grown = (uint8_t *)realloc(dlist->data, capacity);
+    if (grown == NULL) {
+      return false;
+    }
+    dlist->data = grown;
+    dlist->capacity = capacity;
+  }
+  uint8_t *p = dlist->data + dlist->length;
+  p[0] = (uint8_t)op;
+  p[1] = argc;
+  memcpy(p + 2, &size, sizeof(uint16_t));
+  p += GC_DLIST_RECORD_HEADER;
+  if (argc > 0) {
+    memcpy(p, args, argc * sizeof(int16_t));
+    p += argc * sizeof(int16_t);
+  }
+  if (size > 0) {
+    memcpy(p, data, size);
+  }
+  dlist->length += len;
+  return true;
+}
+
+/**
+ * @brief  Draw the recorded frame from its start state. The primitives clip
+ *   the drawing to the rows held in the buffer, so only the current strip is
+ *   written. The drawing state is left as at the end of the frame.
+ * @param  dlist  Display list
+ * @param  handle  Graphic context handle
+ */
+void gc_dlist_replay(gc_dlist_t *dlist, gc_handle_t *handle) {
+  gc_dlist_load_state(dlist, handle, &dlist->start);
+  int16_t a[GC_DLIST_MAX_ARGS];
+  uint8_t *p = dlist->data;
+  uint8_t *end = dlist->data + dlist->length;
+  while (p < end) {
+    gc_op_t op = (gc_op_t)p[0];
+    uint8_t argc = p[1];
+    uint16_t size;
+    memcpy(&size, p + 2, sizeof(uint16_t));
+    p += GC_DLIST_RECORD_HEADER;
+    memcpy(a, p, argc * sizeof(int16_t));
+    p += argc * sizeof(int16_t);
+    uint8_t *data = p;
+    p += size;
+    switch (op) {
+      case GC_OP_FILL_SCREEN:
+        gc_fill_screen(handle, (uint16_t)a[0]);
+        break;
+      case GC_OP_SET_ROTATION:
+        gc_set_rotation(handle, (uint8_t)a[0]);
+        break;
+      case GC_OP_SET_COLOR:
+        gc_set_color(handle, (uint16_t)a[0]);
+        break;
+      case GC_OP_SET_FILL_COLOR:
+        gc_set_fill_color(handle, (uint16_t)a[0]);
+        break;
+      case GC_OP_SET_FONT_COLOR:
+        gc_set_font_color(handle, (uint16_t)a[0]);
+        break;
+      case GC_OP_SET_FONT:
+        if (size == sizeof(gc_font_t)) {
+          memcpy(&dlist->font, data, sizeof(gc_font_t));
+          gc_set_font(handle, &dlist->font);
+        } else {
+          gc_set_font(handle, NULL);
+        }
+        break;
+      case GC_OP_SET_FONT_SCALE:
+        gc_set_font_scale(handle, (uint8_t)a[0], (uint8_t)a[1]);
+        break;
+      case GC_OP_SET_PIXEL:
+        gc_set_pixel(handle, a[0], a[1], (uint16_t)a[2]);
+        break;
+      case GC_OP_DRAW_LINE:
+        gc_draw_line(handle, a[0], a[1], a[2], a[3]);
+        break;
+      case GC_OP_DRAW_RECT:
+        gc_draw_rect(handle, a[0], a[1], a[2], a[3]);
+        break;
+      case GC_OP_FILL_RECT:
+        gc_fill_rect(handle, a[0], a[1], a[2], a[3]);
+        break;
+      case GC_OP_DRAW_CIRCLE:
+        gc_draw_circle(handle, a[0], a[1], a[2]);
+        break;
+      case GC_OP_FILL_CIRCLE:
+        gc_fill_circle(handle, a[0], a[1], a[2]);
+        break;
+      case GC_OP_DRAW_ROUNDRECT:
+        gc_draw_roundrect(handle, a[0], a[1], a[2], a[3], a[4]);
+        break;
+      case GC_OP_FILL_ROUNDRECT:
+        gc_fill_roundrect(handle, a[0], a[1], a[2], a[3], a[4]);
+        break;
+      case GC_OP_DRAW_TEXT:
+        gc_draw_text(handle, a[0], a[1], (const char *)data);
+        break;
+      case GC_OP_DRAW_BITMAP:
+      case GC_OP_DRAW_BITMAP_DATA: {
+        uint8_t *bitmap = (uint8_t *)data;
+        if (op == GC_OP_DRAW_BITMAP) {
+          memcpy(&bitmap, data, sizeof(uint8_t *));
+        }
+        gc_draw_bitmap(handle, a[0], a[1], bitmap, a[2], a[3], (uint8_t)a[4],
+                       (uint16_t)a[5], a[6] != 0, (uint16_t)a[7],
+                       (uint8_t)a[8], (uint8_t)a[9], a[10] != 0, a[11] != 0);
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * @brief  Empty the display list to record the next frame, which starts
+ *   from the current drawing state
+ * @param  dlist  Display list
+ * @param  handle  Graphic context handle
+ */
+void gc_dlist_reset(gc_dlist_t *dlist, gc_handle_t *handle) {
+  dlist->length = 0;
+  gc_dlist_save_state(handle, &dlist->start);
+}
+
+/**
+ * @brief  Copy the drawing state (colors, font, rotation) of a handle
+ */
+void gc_dlist_save_state(gc_handle_t *handle, gc_dlist_state_t *state) {
+  state->color = handle->color;
+  state->fill_color = handle->fill_color;
+  state->font_color = handle->font_color;
+  state->font_scale_x = handle->font_scale_x;
+  state->font_scale_y = handle->font_scale_y;
+  state->rotation = handle->rotation;
+  state->has_font = handle->font != NULL;
+  if (state->has_font) {
+    memcpy(&state->font, handle->font, sizeof(gc_font_t));
+  }
+}
+
+/**
+ * @brief  Set the drawing state of a handle. A font is copied into the
+ *   display list, as the state may be freed or changed afterwards.
+ */
+void gc_dlist_load_state(gc_dlist_t *dlist, gc_handle_t *handle,
+                         const gc_dlist_state_t *state) {
+  handle->color = state->color;
+  handle->fill_color = state->fill_color;
+  handle->font_color = state->font_color;
+  handle->font_scale_x = state->font_scale_x;
+  handle->font_scale_y = state->font_scale_y;
+  gc_set_rotation(handle, state->rotation);
+  if (state->has_font) {
+    memcpy(&dlist->font, &state->font, sizeof(gc_font_t));
+    handle->font = &dlist->font;
+  } else {
+    handle->font = NULL;
+  }
+}
@@ -0,0 +1,97 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __GC_DLIST_H
+#define __GC_DLIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "font.h"
+#include "gc.h"
+
+/**
+ * Display list operations, replayed with the gc_* functions of the same name
+ */
+typedef enum {
+  GC_OP_FILL_SCREEN,     // color
+  GC_OP_SET_ROTATION,    // rotation
+  GC_OP_SET_COLOR,       // color
+  GC_OP_SET_FILL_COLOR,  // color
+  GC_OP_SET_FONT_COLOR,  // color
+  GC_OP_SET_FONT,        // data: gc_font_t, or nothing for the default font
+  GC_OP_SET_FONT_SCALE,  // scale_x, scale_y
+  GC_OP_SET_PIXEL,       // x, y, color
+  GC_OP_DRAW_LINE,       // x0, y0, x1, y1
+  GC_OP_DRAW_RECT,       // x, y, w, h
+  GC_OP_FILL_RECT,       // x, y, w, h
+  GC_OP_DRAW_CIRCLE,     // x, y, r
+  GC_OP_FILL_CIRCLE,     // x, y, r
+  GC_OP_DRAW_ROUNDRECT,  // x, y, w, h, r
+  GC_OP_FILL_ROUNDRECT,  // x, y, w, h, r
+  GC_OP_DRAW_TEXT,       // x, y, data: NUL-terminated text
+  GC_OP_DRAW_BITMAP,     // x, y, w, h, bpp, color, transparent,
+                         // transparent_color, scale_x, scale_y, flip_x,
+                         // flip_y, data: pointer to the bitmap
+  GC_OP_DRAW_BITMAP_DATA,  // args of GC_OP_DRAW_BITMAP, data: the bitmap
+} gc_op_t;
+
+#define GC_DLIST_MAX_ARGS 12
+#define GC_DLIST_BITMAP_COPY_MAX 512  // bitmaps up to this are copied
+
+/**
+ * Drawing state of a graphic context
+ */
+typedef struct {
+  uint16_t color;
+  uint16_t fill_color;
+  uint16_t font_color;
+  uint8_t font_scale_x;
+  uint8_t font_scale_y;
+  uint8_t rotation;
+  bool has_font;
+  gc_font_t font;
+} gc_dlist_state_t;
+
+/**
+ * Display list: the drawing calls of a frame recorded as records of
+ * [op:u8][argc:u8][size:u16][args:int16 x argc][data:size bytes], so the
+ * frame can be drawn again into each strip of the screen.
+ */
+typedef struct gc_dlist_s {
+  uint8_t *data;
+  uint32_t length;
+  uint32_t capacity;
+  gc_dlist_state_t start;  // drawing state when the frame was started
+  gc_font_t font;          // font set while replaying
+} gc_dlist_t;
+
+gc_dlist_t *gc_dlist_new(gc_handle_t *handle);
+void gc_dlist_free(gc_dlist_t *dlist);
+bool gc_dlist_push(gc_dlist_t *dlist, gc_op_t op, const int16_t *args,
+                   uint8_t argc, const void *data, uint16_t size);
+void gc_dlist_replay(gc_dlist_t *dlist, gc_handle_t *handle);
+void gc_dlist_reset(gc_dlist_t *dlist, gc_handle_t *handle);
+void gc_dlist_save_state(gc_handle_t *handle, gc_dlist_state_t *state);
+void gc_dlist_load_state(gc_dlist_t *dlist, gc_handle_t *handle,
+                         const gc_dlist_state_t *state);
+
+#endif /* __GC_DLIST_H */
@@ -28,8 +28,13 @@
 #define MSTR_GRAPHICS_SETPIXEL_CB "__setPixel_cb"
 #define MSTR_GRAPHICS_GETPIXEL_CB "__getPixel_cb"
 #define MSTR_GRAPHICS_FILLRECT_CB "__fillRect_cb"
+#define MSTR_GRAPHICS_DLIST_REFS "__dlist_refs"
 #define MSTR_GRAPHICS_WIDTH "width"
 #define MSTR_GRAPHICS_HEIGHT "height"
+#define MSTR_GRAPHICS_X "x"
+#define MSTR_GRAPHICS_Y "y"
+#define MSTR_GRAPHICS_OFFSET "offset"
+#define MSTR_GRAPHICS_STRIDE "stride"
 #define MSTR_GRAPHICS_FIRST "first"
 #define MSTR_GRAPHICS_LAST "last"
 #define MSTR_GRAPHICS_ADVANCE_X "advanceX"
@@ -39,6 +44,8 @@
 #define MSTR_GRAPHICS_BUFFER "buffer"
 #define MSTR_GRAPHICS_ROTATION "rotation"
 #define MSTR_GRAPHICS_BPP "bpp"
+#define MSTR_GRAPHICS_NATIVE_BUFFER "nativeBuffer"
+#define MSTR_GRAPHICS_STRIP_HEIGHT "stripHeight"
 #define MSTR_GRAPHICS_DATA "data"
 #define MSTR_GRAPHICS_SCALE_X "scaleX"
 #define MSTR_GRAPHICS_SCALE_Y "scaleY"
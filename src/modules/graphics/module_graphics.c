@@ -22,6 +22,7 @@
 #include "module_graphics.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "font.h"
 #include "gc.h"
@@ -29,6 +30,7 @@
 #include "gc_3bit_prims.h"
 #include "gc_1bit_prims.h"
 #include "gc_cb_prims.h"
+#include "gc_dlist.h"
 #include "graphics_magic_strings.h"
 #include "jerryscript.h"
 #include "jerryxx.h"
@@ -36,11 +38,27 @@
 
 gc_font_t custom_font;
 
-static void gc_handle_freecb(void *handle, struct jerry_object_native_info_t *info_p) { free(handle); }
+static void gc_handle_freecb(void *handle, struct jerry_object_native_info_t *info_p) {
+  gc_dlist_free(((gc_handle_t *)handle)->dlist);
+  free(handle);
+}
 
 static const jerry_object_native_info_t gc_handle_info = {.free_cb =
                                                               gc_handle_freecb};
 
+/**
+ * Record a drawing call to the display list (strip mode)
+ */
+static jerry_value_t gc_record(gc_handle_t *gc_handle, gc_op_t op,
+                               const int16_t *args, uint8_t argc,
+                               const void *data, uint16_t size) {
+  if (!gc_dlist_push(gc_handle->dlist, op, args, argc, data, size)) {
+    return jerry_error_sz(JERRY_ERROR_RANGE,
+                          "Not enough memory for the display list.");
+  }
+  return jerry_undefined();
+}
+
 /* ************************************************************************** */
 /*                            GRAPHIC CONTEXT CLASS                           */
 /* ************************************************************************** */
@@ -61,6 +79,7 @@ JERRYXX_FUN(gc_ctor_fn) {
   gc_handle->font_color = 1;
   gc_handle->font_scale_x = 1;
   gc_handle->font_scale_y = 1;
+  gc_handle->dlist = NULL;
   jerry_object_set_native_ptr(JERRYXX_GET_THIS, &gc_handle_info, gc_handle);
 
   // read parameters
@@ -111,6 +130,9 @@ JERRYXX_FUN(gc_ctor_fn) {
   gc_handle->draw_vline_cb = gc_prim_cb_draw_vline;
   gc_handle->fill_rect_cb = gc_prim_cb_fill_rect;
   gc_handle->fill_screen_cb = gc_prim_cb_fill_screen;
+  gc_handle->draw_bits_cb = NULL;
+  gc_handle->buffer_y = 0;
+  gc_handle->buffer_height = gc_handle->device_height;
 
   return jerry_undefined();
 }
@@ -153,6 +175,10 @@ JERRYXX_FUN(gc_color16_fn) {
  */
 JERRYXX_FUN(gc_clear_screen_fn) {
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {0};
+    return gc_record(gc_handle, GC_OP_FILL_SCREEN, args, 1, NULL, 0);
+  }
   gc_clear_screen(gc_handle);
   return jerry_undefined();
 }
@@ -164,6 +190,10 @@ JERRYXX_FUN(gc_fill_screen_fn) {
   JERRYXX_CHECK_ARG_NUMBER(0, "color")
   uint16_t color = (uint16_t)JERRYXX_GET_ARG_NUMBER(0);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {(int16_t)color};
+    return gc_record(gc_handle, GC_OP_FILL_SCREEN, args, 1, NULL, 0);
+  }
   gc_fill_screen(gc_handle, color);
   return jerry_undefined();
 }
@@ -176,6 +206,10 @@ JERRYXX_FUN(gc_set_rotation_fn) {
   uint8_t rotation = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
   gc_set_rotation(gc_handle, rotation);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {rotation};
+    return gc_record(gc_handle, GC_OP_SET_ROTATION, args, 1, NULL, 0);
+  }
   return jerry_undefined();
 }
 
@@ -196,6 +230,10 @@ JERRYXX_FUN(gc_set_color_fn) {
   uint16_t color = (uint16_t)JERRYXX_GET_ARG_NUMBER(0);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
   gc_set_color(gc_handle, color);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {(int16_t)color};
+    return gc_record(gc_handle, GC_OP_SET_COLOR, args, 1, NULL, 0);
+  }
   return jerry_undefined();
 }
 
@@ -216,6 +254,10 @@ JERRYXX_FUN(gc_set_fill_color_fn) {
   uint16_t color = (uint16_t)JERRYXX_GET_ARG_NUMBER(0);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
   gc_set_fill_color(gc_handle, color);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {(int16_t)color};
+    return gc_record(gc_handle, GC_OP_SET_FILL_COLOR, args, 1, NULL, 0);
+  }
   return jerry_undefined();
 }
 
@@ -236,6 +278,10 @@ JERRYXX_FUN(gc_set_font_color_fn) {
   uint16_t color = (uint16_t)JERRYXX_GET_ARG_NUMBER(0);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
   gc_set_font_color(gc_handle, color);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {(int16_t)color};
+    return gc_record(gc_handle, GC_OP_SET_FONT_COLOR, args, 1, NULL, 0);
+  }
   return jerry_undefined();
 }
 
@@ -307,6 +353,11 @@ JERRYXX_FUN(gc_set_font_fn) {
     } else {
       gc_handle->font = NULL;
     }
+    if (gc_handle->dlist != NULL) {
+      // the font is copied, as custom_font is shared by all contexts
+      return gc_record(gc_handle, GC_OP_SET_FONT, NULL, 0, gc_handle->font,
+                       gc_handle->font != NULL ? sizeof(gc_font_t) : 0);
+    }
   }
   return jerry_undefined();
 }
@@ -321,6 +372,10 @@ JERRYXX_FUN(gc_set_font_scale_fn) {
   int8_t scale_y = (int8_t)JERRYXX_GET_ARG_NUMBER(1);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
   gc_set_font_scale(gc_handle, scale_x, scale_y);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {scale_x, scale_y};
+    return gc_record(gc_handle, GC_OP_SET_FONT_SCALE, args, 2, NULL, 0);
+  }
   return jerry_undefined();
 }
 
@@ -335,12 +390,17 @@ JERRYXX_FUN(gc_set_pixel_fn) {
   int16_t y = (int16_t)JERRYXX_GET_ARG_NUMBER(1);
   uint16_t color = (uint16_t)JERRYXX_GET_ARG_NUMBER(2);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y, (int16_t)color};
+    return gc_record(gc_handle, GC_OP_SET_PIXEL, args, 3, NULL, 0);
+  }
   gc_set_pixel(gc_handle, x, y, color);
   return jerry_undefined();
 }
 
 /**
  * GraphicsContext.prototype.getPixel(x, y) -> color
+ * Not supported in strip mode, where the frame is not kept in the buffer.
  */
 JERRYXX_FUN(gc_get_pixel_fn) {
   JERRYXX_CHECK_ARG_NUMBER(0, "x")
@@ -348,6 +408,10 @@ JERRYXX_FUN(gc_get_pixel_fn) {
   int16_t x = (int16_t)JERRYXX_GET_ARG_NUMBER(0);
   int16_t y = (int16_t)JERRYXX_GET_ARG_NUMBER(1);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "getPixel() is not supported in strip mode.");
+  }
   uint16_t color = gc_get_pixel(gc_handle, x, y);
   return jerry_number(color);
 }
@@ -365,6 +429,10 @@ JERRYXX_FUN(gc_draw_line_fn) {
   int16_t x1 = (int16_t)JERRYXX_GET_ARG_NUMBER(2);
   int16_t y1 = (int16_t)JERRYXX_GET_ARG_NUMBER(3);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x0, y0, x1, y1};
+    return gc_record(gc_handle, GC_OP_DRAW_LINE, args, 4, NULL, 0);
+  }
   gc_draw_line(gc_handle, x0, y0, x1, y1);
   return jerry_undefined();
 }
@@ -382,6 +450,10 @@ JERRYXX_FUN(gc_draw_rect_fn) {
   int16_t w = (int16_t)JERRYXX_GET_ARG_NUMBER(2);
   int16_t h = (int16_t)JERRYXX_GET_ARG_NUMBER(3);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y, w, h};
+    return gc_record(gc_handle, GC_OP_DRAW_RECT, args, 4, NULL, 0);
+  }
   gc_draw_rect(gc_handle, x, y, w, h);
   return jerry_undefined();
 }
@@ -399,6 +471,10 @@ JERRYXX_FUN(gc_fill_rect_fn) {
   int16_t w = (int16_t)JERRYXX_GET_ARG_NUMBER(2);
   int16_t h = (int16_t)JERRYXX_GET_ARG_NUMBER(3);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y, w, h};
+    return gc_record(gc_handle, GC_OP_FILL_RECT, args, 4, NULL, 0);
+  }
   gc_fill_rect(gc_handle, x, y, w, h);
   return jerry_undefined();
 }
@@ -414,6 +490,10 @@ JERRYXX_FUN(gc_draw_circle_fn) {
   int16_t y = (int16_t)JERRYXX_GET_ARG_NUMBER(1);
   int16_t r = (int16_t)JERRYXX_GET_ARG_NUMBER(2);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y, r};
+    return gc_record(gc_handle, GC_OP_DRAW_CIRCLE, args, 3, NULL, 0);
+  }
   gc_draw_circle(gc_handle, x, y, r);
   return jerry_undefined();
 }
@@ -429,6 +509,10 @@ JERRYXX_FUN(gc_fill_circle_fn) {
   int16_t y = (int16_t)JERRYXX_GET_ARG_NUMBER(1);
   int16_t r = (int16_t)JERRYXX_GET_ARG_NUMBER(2);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y, r};
+    return gc_record(gc_handle, GC_OP_FILL_CIRCLE, args, 3, NULL, 0);
+  }
   gc_fill_circle(gc_handle, x, y, r);
   return jerry_undefined();
 }
@@ -448,6 +532,10 @@ JERRYXX_FUN(gc_draw_roundrect_fn) {
   int16_t h = (int16_t)JERRYXX_GET_ARG_NUMBER(3);
   int16_t r = (int16_t)JERRYXX_GET_ARG_NUMBER(4);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y, w, h, r};
+    return gc_record(gc_handle, GC_OP_DRAW_ROUNDRECT, args, 5, NULL, 0);
+  }
   gc_draw_roundrect(gc_handle, x, y, w, h, r);
   return jerry_undefined();
 }
@@ -467,6 +555,10 @@ JERRYXX_FUN(gc_fill_roundrect_fn) {
   int16_t h = (int16_t)JERRYXX_GET_ARG_NUMBER(3);
   int16_t r = (int16_t)JERRYXX_GET_ARG_NUMBER(4);
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y, w, h, r};
+    return gc_record(gc_handle, GC_OP_FILL_ROUNDRECT, args, 5, NULL, 0);
+  }
   gc_fill_roundrect(gc_handle, x, y, w, h, r);
   return jerry_undefined();
 }
@@ -482,6 +574,11 @@ JERRYXX_FUN(gc_draw_text_fn) {
   int16_t y = (int16_t)JERRYXX_GET_ARG_NUMBER(1);
   JERRYXX_GET_ARG_STRING_AS_CHAR(2, text)
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    int16_t args[] = {x, y};
+    return gc_record(gc_handle, GC_OP_DRAW_TEXT, args, 2, text,
+                     strlen(text) + 1);
+  }
   gc_draw_text(gc_handle, x, y, text);
   return jerry_undefined();
 }
@@ -559,17 +656,13 @@ JERRYXX_FUN(gc_draw_bitmap_fn) {
       // draw bitmap
       JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
       jerry_value_t data = jerryxx_get_property(bitmap, MSTR_GRAPHICS_DATA);
+      jerry_value_t buffer;
       if (jerry_value_is_typedarray(data) &&
           jerry_typedarray_type(data) ==
               JERRY_TYPEDARRAY_UINT8) { /* Uint8Array */
         jerry_length_t byteLength = 0;
         jerry_length_t byteOffset = 0;
-        jerry_value_t buffer =
-            jerry_typedarray_buffer(data, &byteOffset, &byteLength);
-        uint8_t *buf = jerry_arraybuffer_data(buffer);
-        gc_draw_bitmap(gc_handle, x, y, buf, w, h, bpp, color, transparent,
-                       transparent_color, scale_x, scale_y, flip_x, flip_y);
-        jerry_value_free(buffer);
+        buffer = jerry_typedarray_buffer(data, &byteOffset, &byteLength);
       } else if (jerry_value_is_string(data)) { /* decode base64 string */
         jerry_value_t global = jerry_current_realm();
         jerry_value_t atob_fn = jerryxx_get_property(global, MSTR_ATOB);
@@ -578,12 +671,7 @@ JERRYXX_FUN(gc_draw_bitmap_fn) {
         jerry_value_t decoded = jerry_call(atob_fn, this_val, args, 1);
         jerry_length_t byteLength = 0;
         jerry_length_t byteOffset = 0;
-        jerry_value_t buffer =
-            jerry_typedarray_buffer(decoded, &byteOffset, &byteLength);
-        uint8_t *buf = jerry_arraybuffer_data(buffer);
-        gc_draw_bitmap(gc_handle, x, y, buf, w, h, bpp, color, transparent,
-                       transparent_color, scale_x, scale_y, flip_x, flip_y);
-        jerry_value_free(buffer);
+        buffer = jerry_typedarray_buffer(decoded, &byteOffset, &byteLength);
         jerry_value_free(decoded);
         jerry_value_free(this_val);
         jerry_value_free(atob_fn);
@@ -593,25 +681,159 @@ JERRYXX_FUN(gc_draw_bitmap_fn) {
             JERRY_ERROR_TYPE,
             "bitmap.data must be Uint8Array or string.");
       }
+      uint8_t *buf = jerry_arraybuffer_data(buffer);
+      jerry_value_t ret = jerry_undefined();
+      if (gc_handle->dlist != NULL) {
+        int16_t args[] = {x,       y,       w,      h,     bpp,
+                          color,   transparent,     transparent_color,
+                          scale_x, scale_y, flip_x, flip_y};
+        uint32_t size = (bpp == 1) ? ((w + 7) / 8) * h : w * h * 2;
+        bool copy = size <= GC_DLIST_BITMAP_COPY_MAX &&
+                    size <= jerry_arraybuffer_size(buffer);
+        if (copy) {
+          // small bitmaps are copied, as drawn in direct mode
+          ret = gc_record(gc_handle, GC_OP_DRAW_BITMAP_DATA, args, 12, buf,
+                          size);
+        } else {
+          // the data is kept alive until the frame is displayed and
+          // drawn as it is then
+          ret = gc_record(gc_handle, GC_OP_DRAW_BITMAP, args, 12, &buf,
+                          sizeof(buf));
+        }
+        if (!jerry_value_is_error(ret) && !copy) {
+          jerry_value_t refs =
+              jerryxx_get_property(JERRYXX_GET_THIS, MSTR_GRAPHICS_DLIST_REFS);
+          jerry_value_free(
+              jerry_object_set_index(refs, jerry_array_length(refs), buffer));
+          jerry_value_free(refs);
+        }
+      } else {
+        gc_draw_bitmap(gc_handle, x, y, buf, w, h, bpp, color, transparent,
+                       transparent_color, scale_x, scale_y, flip_x, flip_y);
+      }
+      jerry_value_free(buffer);
       jerry_value_free(data);
+      return ret;
     }
   }
   return jerry_undefined();
 }
 
 /**
- * GraphicsContext.prototype.display() function
+ * Make the dirty region object passed to the display callback. The region is
+ * in device coordinates, widened to whole bytes of the buffer (pages of 8
+ * rows for 1-bit, pixel pairs for 3-bit). `offset` is the byte index of its
+ * top-left corner in the buffer and `stride` the bytes from a row (or page)
+ * to the next.
+ */
+static jerry_value_t gc_dirty_region(gc_handle_t *gc_handle) {
+  int32_t x0 = gc_handle->dirty_x0;
+  int32_t y0 = gc_handle->dirty_y0;
+  int32_t x1 = gc_handle->dirty_x1;
+  int32_t y1 = gc_handle->dirty_y1;
+  int32_t offset = 0;
+  int32_t stride = 0;
+  if (x0 >= x1 || y0 >= y1) {
+    x0 = y0 = x1 = y1 = 0;
+  } else if (gc_handle->bpp == 1) {
+    y0 &= ~7;
+    y1 = MIN((y1 + 7) & ~7, gc_handle->device_height);
+    stride = gc_handle->device_width;
+    offset = ((y0 - gc_handle->buffer_y) / 8) * stride + x0;
+  } else if (gc_handle->bpp == 3) {
+    x0 &= ~1;
+    x1 = MIN((x1 + 1) & ~1, gc_handle->device_width);
+    stride = gc_handle->device_width / 2;
+    offset = (y0 - gc_handle->buffer_y) * stride + x0 / 2;
+  } else {
+    stride = gc_handle->device_width * 2;
+    offset = (y0 - gc_handle->buffer_y) * stride + x0 * 2;
+  }
+  jerry_value_t region = jerry_object();
+  jerryxx_set_property_number(region, MSTR_GRAPHICS_X, x0);
+  jerryxx_set_property_number(region, MSTR_GRAPHICS_Y, y0);
+  jerryxx_set_property_number(region, MSTR_GRAPHICS_WIDTH, x1 - x0);
+  jerryxx_set_property_number(region, MSTR_GRAPHICS_HEIGHT, y1 - y0);
+  jerryxx_set_property_number(region, MSTR_GRAPHICS_OFFSET, offset);
+  jerryxx_set_property_number(region, MSTR_GRAPHICS_STRIDE, stride);
+  return region;
+}
+
+/**
+ * Display the frame recorded in strip mode. The frame is drawn into the
+ * buffer (cleared first) a strip of rows at a time, and the display callback
+ * is called for each strip with the region of the screen it covers. The
+ * display list is then emptied for the next frame, unless the callback
+ * throws.
+ */
+static jerry_value_t gc_display_strips(jerry_value_t this_val,
+                                       gc_handle_t *gc_handle) {
+  gc_dlist_t *dlist = gc_handle->dlist;
+  jerry_value_t ret_val = jerry_undefined();
+  if (jerry_value_is_function(gc_handle->display_js_cb)) {
+    gc_dlist_state_t state;
+    gc_dlist_save_state(gc_handle, &state);
+    int16_t rows = gc_handle->buffer_height;
+    jerry_value_t buffer = jerryxx_get_property(this_val, MSTR_GRAPHICS_BUFFER);
+    jerry_value_t this_ = jerry_undefined();
+    for (int16_t y = 0; y < gc_handle->device_height; y += rows) {
+      gc_handle->buffer_y = y;
+      gc_handle->buffer_height = MIN(rows, gc_handle->device_height - y);
+      memset(gc_handle->buffer, 0, gc_handle->buffer_size);
+      gc_dlist_replay(dlist, gc_handle);
+      gc_clear_dirty(gc_handle);
+      gc_mark_dirty(gc_handle, 0, y, gc_handle->device_width,
+                    gc_handle->buffer_height);
+      jerry_value_t region = gc_dirty_region(gc_handle);
+      jerry_value_t args[] = {buffer, region};
+      ret_val = jerry_call(gc_handle->display_js_cb, this_, args, 2);
+      jerry_value_free(region);
+      if (jerry_value_is_error(ret_val)) {
+        break;
+      }
+      jerry_value_free(ret_val);
+      ret_val = jerry_undefined();
+    }
+    gc_handle->buffer_y = 0;
+    gc_handle->buffer_height = rows;
+    gc_clear_dirty(gc_handle);
+    jerry_value_free(buffer);
+    jerry_value_free(this_);
+    if (jerry_value_is_error(ret_val)) {
+      gc_dlist_load_state(dlist, gc_handle, &state);
+      return ret_val;
+    }
+  }
+  gc_dlist_reset(dlist, gc_handle);
+  jerry_value_t refs = jerry_array(0);
+  jerryxx_set_property(this_val, MSTR_GRAPHICS_DLIST_REFS, refs);
+  jerry_value_free(refs);
+  return ret_val;
+}
+
+/**
+ * GraphicsContext.prototype.display() function. The display callback is
+ * called with the buffer and the region changed since the last call, so
+ * drivers may send only that window. The region is empty if nothing changed.
  */
 JERRYXX_FUN(gc_display_fn) {
   JERRYXX_GET_NATIVE_HANDLE(gc_handle, gc_handle_t, gc_handle_info);
+  if (gc_handle->dlist != NULL) {
+    return gc_display_strips(JERRYXX_GET_THIS, gc_handle);
+  }
   if (jerry_value_is_function(gc_handle->display_js_cb)) {
     jerry_value_t buffer =
         jerryxx_get_property(JERRYXX_GET_THIS, MSTR_GRAPHICS_BUFFER);
+    jerry_value_t region = gc_dirty_region(gc_handle);
     jerry_value_t this_ = jerry_undefined();
-    jerry_value_t args[] = {buffer};
+    jerry_value_t args[] = {buffer, region};
     jerry_value_t ret_val =
-        jerry_call(gc_handle->display_js_cb, this_, args, 1);
+        jerry_call(gc_handle->display_js_cb, this_, args, 2);
+    if (!jerry_value_is_error(ret_val)) {
+      gc_clear_dirty(gc_handle);
+    }
     jerry_value_free(buffer);
+    jerry_value_free(region);
     jerry_value_free(this_);
     return ret_val;
   } else {
@@ -639,11 +861,14 @@ JERRYXX_FUN(buffered_gc_ctor_fn) {
   gc_handle->font_color = 1;
   gc_handle->font_scale_x = 1;
   gc_handle->font_scale_y = 1;
+  gc_handle->dlist = NULL;
   jerry_object_set_native_ptr(JERRYXX_GET_THIS, &gc_handle_info, gc_handle);
 
   // read parameters
   gc_handle->device_width = (int16_t)JERRYXX_GET_ARG_NUMBER(0);
   gc_handle->device_height = (int16_t)JERRYXX_GET_ARG_NUMBER(1);
+  bool native_buffer = false;
+  int16_t strip_height = 0;
   if (JERRYXX_HAS_ARG(2)) {
     jerry_value_t options = JERRYXX_GET_ARG(2);
     if (jerry_value_is_object(options)) {
@@ -652,6 +877,18 @@ JERRYXX_FUN(buffered_gc_ctor_fn) {
           options, MSTR_GRAPHICS_ROTATION, 0);
       gc_set_rotation(gc_handle, rotation);
 
+      // allocate the buffer outside of the JS heap
+      native_buffer = jerryxx_get_property_boolean(
+          options, MSTR_GRAPHICS_NATIVE_BUFFER, false);
+
+      // rows of the buffer in strip mode. Drawing calls are recorded and
+      // replayed for each strip by display(), so getPixel() is not
+      // supported. drawBitmap() copies bitmaps up to
+      // GC_DLIST_BITMAP_COPY_MAX bytes; larger ones are drawn with their
+      // contents at display(), not at the call.
+      strip_height = (int16_t)jerryxx_get_property_number(
+          options, MSTR_GRAPHICS_STRIP_HEIGHT, 0);
+
       // bpp
       uint8_t bpp = (uint8_t)jerryxx_get_property_number(
           options, MSTR_GRAPHICS_BPP, 1);  // should be 1 or 16
@@ -681,6 +918,7 @@ JERRYXX_FUN(buffered_gc_ctor_fn) {
     gc_handle->draw_vline_cb = gc_prim_1bit_draw_vline;
     gc_handle->fill_rect_cb = gc_prim_1bit_fill_rect;
     gc_handle->fill_screen_cb = gc_prim_1bit_fill_screen;
+    gc_handle->draw_bits_cb = gc_prim_1bit_draw_bits;
   } else if (gc_handle->bpp == 3) {
     gc_handle->set_pixel_cb = gc_prim_3bit_set_pixel;
     gc_handle->get_pixel_cb = gc_prim_3bit_get_pixel;
@@ -688,6 +926,7 @@ JERRYXX_FUN(buffered_gc_ctor_fn) {
     gc_handle->draw_vline_cb = gc_prim_3bit_draw_vline;
     gc_handle->fill_rect_cb = gc_prim_3bit_fill_rect;
     gc_handle->fill_screen_cb = gc_prim_3bit_fill_screen;
+    gc_handle->draw_bits_cb = NULL;
   } else {
     gc_handle->set_pixel_cb = gc_prim_16bit_set_pixel;
     gc_handle->get_pixel_cb = gc_prim_16bit_get_pixel;
@@ -695,10 +934,31 @@ JERRYXX_FUN(buffered_gc_ctor_fn) {
     gc_handle->draw_vline_cb = gc_prim_16bit_draw_vline;
     gc_handle->fill_rect_cb = gc_prim_16bit_fill_rect;
     gc_handle->fill_screen_cb = gc_prim_16bit_fill_screen;
+    gc_handle->draw_bits_cb = NULL;
+  }
+
+  // strip mode: the buffer holds only some rows of the screen, and drawing
+  // calls are recorded to draw the frame again into each strip on display()
+  gc_handle->buffer_y = 0;
+  gc_handle->buffer_height = gc_handle->device_height;
+  if (strip_height > 0 && strip_height < gc_handle->device_height) {
+    if (gc_handle->bpp == 1) {
+      strip_height = (strip_height + 7) & ~7;  // whole pages
+    }
+    gc_handle->buffer_height = MIN(strip_height, gc_handle->device_height);
+    gc_handle->dlist = gc_dlist_new(gc_handle);
+    if (gc_handle->dlist == NULL) {
+      return jerry_error_sz(JERRY_ERROR_RANGE,
+                            "Not enough memory for the display list.");
+    }
+    jerry_value_t refs = jerry_array(0);
+    jerryxx_set_property(JERRYXX_GET_THIS, MSTR_GRAPHICS_DLIST_REFS, refs);
+    jerry_value_free(refs);
   }
 
   // allocate buffer
-  size_t size = gc_handle->device_width * gc_handle->device_height;
+  uint32_t size =
+      (uint32_t)gc_handle->device_width * (uint32_t)gc_handle->buffer_height;
   if (gc_handle->bpp == 1) {
     size = size / 8;
   } else if (gc_handle->bpp == 3) {
@@ -706,14 +966,28 @@ JERRYXX_FUN(buffered_gc_ctor_fn) {
   } else {
     size = size * 2;
   }
-  jerry_value_t buffer = jerry_typedarray(JERRY_TYPEDARRAY_UINT8, size);
+  jerry_value_t buf;
+  if (native_buffer) {
+    // owned by the ArrayBuffer once created
+    uint8_t *data = (uint8_t *)malloc(size > 0 ? size : 1);
+    if (data == NULL) {
+      return jerry_error_sz(JERRY_ERROR_RANGE,
+                            "Not enough memory for the buffer.");
+    }
+    memset(data, 0, size);
+    buf = jerry_arraybuffer_external(data, size, NULL);
+  } else {
+    buf = jerry_arraybuffer(size);
+  }
+  if (jerry_value_is_error(buf)) {
+    return buf;
+  }
+  jerry_value_t buffer =
+      jerry_typedarray_with_buffer(JERRY_TYPEDARRAY_UINT8, buf);
   jerryxx_set_property(JERRYXX_GET_THIS, MSTR_GRAPHICS_BUFFER, buffer);
-  jerry_length_t byteOffset = 0;
-  jerry_length_t byteLength = 0;
-  jerry_value_t buf =
-      jerry_typedarray_buffer(buffer, &byteOffset, &byteLength);
   gc_handle->buffer = jerry_arraybuffer_data(buf);
   gc_handle->buffer_size = size;
+  gc_set_dirty(gc_handle);  // nothing sent to the display yet
   jerry_value_free(buf);
   jerry_value_free(buffer);
   return jerry_undefined();
@@ -34,6 +34,10 @@
 #define MSTR_I2C_READ "read"
 #define MSTR_I2C_MEM_WRITE "memWrite"
 #define MSTR_I2C_MEM_READ "memRead"
+#define MSTR_I2C_TRANSACTION "transaction"
+#define MSTR_I2C_MEM_ADDRESS "memAddress"
+#define MSTR_I2C_MEM_ADDRESS_SIZE "memAddressSize"
+#define MSTR_I2C_OFFSET "offset"
 #define MSTR_I2C_CLOSE "close"
 #define MSTR_I2C_SDA "sda"
 #define MSTR_I2C_SCL "scl"
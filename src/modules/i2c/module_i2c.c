@@ -351,6 +351,160 @@ JERRYXX_FUN(i2c_memread_fn) {
   }
 }
 
+/**
+ * Run a single operation of I2C.prototype.transaction(). Read operations
+ * store the received bytes into buf at *offset and advance it.
+ */
+static jerry_value_t i2c_transaction_op(uint8_t bus, jerry_value_t op,
+                                        uint8_t *buf, size_t buf_len,
+                                        size_t *offset, size_t *read_length,
+                                        uint32_t timeout) {
+  if (!jerry_value_is_object(op)) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The operation must be an object.");
+  }
+  uint8_t address =
+      (uint8_t)jerryxx_get_property_number(op, MSTR_I2C_ADDRESS, 0);
+  double mem_address_value =
+      jerryxx_get_property_number(op, MSTR_I2C_MEM_ADDRESS, -1);
+  uint16_t mem_address_size =
+      (uint16_t)jerryxx_get_property_number(op, MSTR_I2C_MEM_ADDRESS_SIZE, 8);
+  bool mem = mem_address_value >= 0;
+  uint16_t mem_address = mem ? (uint16_t)mem_address_value : 0;
+  int ret = 0;
+
+  jerry_value_t read = jerryxx_get_property(op, MSTR_I2C_READ);
+  if (jerry_value_is_number(read)) { /* read or memRead */
+    double length_value = jerry_value_as_number(read);
+    jerry_value_free(read);
+    double offset_value =
+        jerryxx_get_property_number(op, MSTR_I2C_OFFSET, (double)*offset);
+    // negative (or NaN) values would wrap around when converted
+    if (!(length_value >= 0) || !(offset_value >= 0)) {
+      return jerry_exception_value(create_system_error(EINVAL), true);
+    }
+    if (length_value > buf_len || offset_value > buf_len - length_value) {
+      return jerry_error_sz(JERRY_ERROR_RANGE,
+                            "The buffer is too small for the read operations.");
+    }
+    size_t length = (size_t)length_value;
+    *offset = (size_t)offset_value;
+    if (mem) {
+      ret = km_i2c_mem_read_master(bus, address, mem_address, mem_address_size,
+                                   buf + *offset, length, timeout);
+    } else {
+      ret = km_i2c_read_master(bus, address, buf + *offset, length, timeout);
+    }
+    if (ret < 0) return jerry_exception_value(create_system_error(ret), true);
+    *offset += length;
+    *read_length += length;
+    return jerry_undefined();
+  }
+  jerry_value_free(read);
+
+  jerry_value_t data = jerryxx_get_property(op, MSTR_I2C_WRITE);
+  if (jerry_value_is_typedarray(data) &&
+      jerry_typedarray_type(data) ==
+          JERRY_TYPEDARRAY_UINT8) { /* Uint8Array */
+    jerry_length_t byteLength = 0;
+    jerry_length_t byteOffset = 0;
+    jerry_value_t array_buffer =
+        jerry_typedarray_buffer(data, &byteOffset, &byteLength);
+    uint8_t *data_buf = jerry_arraybuffer_data(array_buffer) + byteOffset;
+    if (mem) {
+      ret = km_i2c_mem_write_master(bus, address, mem_address,
+                                    mem_address_size, data_buf, byteLength,
+                                    timeout);
+    } else {
+      ret = km_i2c_write_master(bus, address, data_buf, byteLength, timeout);
+    }
+    jerry_value_free(array_buffer);
+  } else if (jerry_value_is_string(data)) { /* for string */
+    jerry_size_t len = jerryxx_get_ascii_string_size(data);
+    uint8_t data_buf[len];
+    jerryxx_string_to_ascii_char_buffer(data, data_buf, len);
+    if (mem) {
+      ret = km_i2c_mem_write_master(bus, address, mem_address,
+                                    mem_address_size, data_buf, len, timeout);
+    } else {
+      ret = km_i2c_write_master(bus, address, data_buf, len, timeout);
+    }
+  } else if (jerry_value_is_number(data)) { /* single byte */
+    uint8_t byte = (uint8_t)jerry_value_as_number(data);
+    if (mem) {
+      ret = km_i2c_mem_write_master(bus, address, mem_address,
+                                    mem_address_size, &byte, 1, timeout);
+    } else {
+      ret = km_i2c_write_master(bus, address, &byte, 1, timeout);
+    }
+  } else {
+    jerry_value_free(data);
+    return jerry_error_sz(
+        JERRY_ERROR_TYPE,
+        "The operation must have a read length or write data.");
+  }
+  jerry_value_free(data);
+  if (ret < 0) return jerry_exception_value(create_system_error(ret), true);
+  return jerry_undefined();
+}
+
+/**
+ * I2C.prototype.transaction() function
+ */
+JERRYXX_FUN(i2c_transaction_fn) {
+  // check and get args
+  JERRYXX_CHECK_ARG_ARRAY(0, "ops");
+  JERRYXX_CHECK_ARG_TYPEDARRAY(1, "buffer");
+  JERRYXX_CHECK_ARG_NUMBER_OPT(2, "timeout");
+  jerry_value_t ops = JERRYXX_GET_ARG(0);
+  jerry_value_t buffer = JERRYXX_GET_ARG(1);
+  uint32_t timeout = (uint32_t)JERRYXX_GET_ARG_NUMBER_OPT(2, 5000);
+  if (jerry_typedarray_type(buffer) != JERRY_TYPEDARRAY_UINT8) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The buffer argument must be Uint8Array.");
+  }
+
+  // check this.bus number
+  jerry_value_t bus_value =
+      jerryxx_get_property(JERRYXX_GET_THIS, MSTR_I2C_BUS);
+  if (!jerry_value_is_number(bus_value)) {
+    jerry_value_free(bus_value);
+    return jerry_error_sz(
+        JERRY_ERROR_REFERENCE,
+        "I2C bus is not initialized.");
+  }
+  uint8_t bus = (uint8_t)jerry_value_as_number(bus_value);
+  jerry_value_free(bus_value);
+  // check the mode (determine slave mode or master mode)
+  km_i2c_mode_t i2cmode = (km_i2c_mode_t)jerryxx_get_property_number(
+      JERRYXX_GET_THIS, MSTR_I2C_MODE, KM_I2C_MASTER);
+  if (i2cmode == KM_I2C_SLAVE)
+    return jerry_error_sz(
+        JERRY_ERROR_RANGE,
+        "This function runs in master mode only.");
+
+  // run the operations in order, reading into the buffer
+  jerry_length_t byteLength = 0;
+  jerry_length_t byteOffset = 0;
+  jerry_value_t array_buffer =
+      jerry_typedarray_buffer(buffer, &byteOffset, &byteLength);
+  uint8_t *buf = jerry_arraybuffer_data(array_buffer) + byteOffset;
+  size_t offset = 0;
+  size_t read_length = 0;
+  jerry_length_t count = jerry_array_length(ops);
+  jerry_value_t ret = jerry_undefined();
+  for (jerry_length_t i = 0; i < count; i++) {
+    jerry_value_t op = jerry_object_get_index(ops, i);
+    ret = i2c_transaction_op(bus, op, buf, byteLength, &offset, &read_length,
+                             timeout);
+    jerry_value_free(op);
+    if (jerry_value_is_exception(ret)) break;
+  }
+  jerry_value_free(array_buffer);
+  if (jerry_value_is_exception(ret)) return ret;
+  return jerry_number(read_length);
+}
+
 /**
  * I2C.prototype.close() function
  */
@@ -394,6 +548,8 @@ jerry_value_t module_i2c_init() {
                                 i2c_memwrite_fn);
   jerryxx_set_property_function(i2c_prototype, MSTR_I2C_MEM_READ,
                                 i2c_memread_fn);
+  jerryxx_set_property_function(i2c_prototype, MSTR_I2C_TRANSACTION,
+                                i2c_transaction_fn);
   jerryxx_set_property_function(i2c_prototype, MSTR_I2C_CLOSE, i2c_close_fn);
   jerry_value_free(i2c_prototype);
 
@@ -173,6 +173,18 @@ void km_cyw43_infinite_loop() {
   }
 }
 
+/**
+ * Sleep until the cyw43 driver has work to do or the timeout.
+ * Return false if the driver is not initialized.
+ */
+bool km_cyw43_wait_for_work(absolute_time_t until) {
+  if (__cyw43_drv.status_flag & KM_CYW43_STATUS_INIT) {
+    cyw43_arch_wait_for_work_until(until);
+    return true;
+  }
+  return false;
+}
+
 static int __cyw43_init() {
   int ret = 0;
   if (__cyw43_drv.status_flag == KM_CYW43_STATUS_DISABLED) {
@@ -19,8 +19,12 @@
  * SOFTWARE.
  */
 
+#include <stdbool.h>
+
 #include "jerryscript.h"
+#include "pico/time.h"
 
 jerry_value_t module_pico_cyw43_init();
 void km_cyw43_deinit();
 void km_cyw43_infinite_loop();
+bool km_cyw43_wait_for_work(absolute_time_t until);
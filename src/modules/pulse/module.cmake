@@ -0,0 +1,2 @@
+list(APPEND SOURCES ${SRC_DIR}/modules/pulse/module_pulse.c)
+include_directories(${SRC_DIR}/modules/pulse)
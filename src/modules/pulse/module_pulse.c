@@ -0,0 +1,241 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "err.h"
+#include "gpio.h"
+#include "io.h"
+#include "jerryscript.h"
+#include "jerryxx.h"
+#include "pulse.h"
+#include "pulse_magic_strings.h"
+
+#define PULSE_DEFAULT_TIMEOUT 1000000  // usec
+#define PULSE_POLL_INTERVAL 1          // msec
+
+/**
+ * Pulse io handle. A repeating timer polls the engine until it is done,
+ * then calls the callback.
+ */
+typedef struct {
+  km_io_timer_handle_t base;
+  uint8_t id;  // engine id
+  bool capture;
+  jerry_value_t data_js;
+  jerry_value_t callback_js;
+} pulse_handle_t;
+
+static pulse_handle_t *pulse_handles[KM_PULSE_MAX];
+
+static void pulse_close_cb(km_io_handle_t *handle) { free(handle); }
+
+static void pulse_release(pulse_handle_t *pulse) {
+  km_pulse_stop(pulse->id);
+  km_io_timer_stop(&pulse->base);
+  jerry_value_free(pulse->data_js);
+  jerry_value_free(pulse->callback_js);
+  pulse_handles[pulse->id] = NULL;
+  km_io_handle_close((km_io_handle_t *)pulse, pulse_close_cb);
+}
+
+static void pulse_timer_cb(km_io_timer_handle_t *timer) {
+  pulse_handle_t *pulse = (pulse_handle_t *)timer;
+  int count = km_pulse_status(pulse->id);
+  if (count == EBUSY) {
+    return;
+  }
+  if (count < 0) {
+    count = 0;
+  }
+  jerry_value_t callback = jerry_value_copy(pulse->callback_js);
+  jerry_value_t data = jerry_value_copy(pulse->data_js);
+  bool capture = pulse->capture;
+  // released first, so the engine can be started again in the callback
+  pulse_release(pulse);
+  if (jerry_value_is_function(callback)) {
+    jerry_value_t this_val = jerry_undefined();
+    jerry_value_t count_val = jerry_number(count);
+    jerry_value_t ret_val;
+    if (capture) {
+      jerry_length_t byte_offset = 0;
+      jerry_length_t byte_length = 0;
+      jerry_value_t array_buffer =
+          jerry_typedarray_buffer(data, &byte_offset, &byte_length);
+      jerry_value_t array = jerry_typedarray_with_buffer_span(
+          JERRY_TYPEDARRAY_UINT32, array_buffer, byte_offset, count);
+      jerry_value_t args_p[2] = {array, count_val};
+      ret_val = jerry_call(callback, this_val, args_p, 2);
+      jerry_value_free(array);
+      jerry_value_free(array_buffer);
+    } else {
+      jerry_value_t args_p[1] = {count_val};
+      ret_val = jerry_call(callback, this_val, args_p, 1);
+    }
+    if (jerry_value_is_error(ret_val)) {
+      jerryxx_print_error(ret_val, true);
+    }
+    jerry_value_free(ret_val);
+    jerry_value_free(count_val);
+    jerry_value_free(this_val);
+  }
+  jerry_value_free(data);
+  jerry_value_free(callback);
+}
+
+static uint32_t *pulse_get_buffer(jerry_value_t data, size_t *length) {
+  if (!jerry_value_is_typedarray(data) ||
+      jerry_typedarray_type(data) != JERRY_TYPEDARRAY_UINT32) {
+    return NULL;
+  }
+  jerry_length_t byte_offset = 0;
+  jerry_length_t byte_length = 0;
+  jerry_value_t array_buffer =
+      jerry_typedarray_buffer(data, &byte_offset, &byte_length);
+  uint32_t *buf =
+      (uint32_t *)(jerry_arraybuffer_data(array_buffer) + byte_offset);
+  jerry_value_free(array_buffer);
+  *length = byte_length / sizeof(uint32_t);
+  return buf;
+}
+
+static jerry_value_t pulse_start(int id, bool capture, jerry_value_t data,
+                                 jerry_value_t callback) {
+  if (id < 0) {
+    return jerry_exception_value(create_system_error(id), true);
+  }
+  pulse_handle_t *pulse = malloc(sizeof(pulse_handle_t));
+  if (pulse == NULL) {
+    km_pulse_stop(id);
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  km_io_timer_init(&pulse->base);
+  KM_IO_SET_FLAG_ON(pulse->base.base.flags, KM_IO_FLAG_INTERNAL);
+  pulse->id = id;
+  pulse->capture = capture;
+  pulse->data_js = jerry_value_copy(data);
+  pulse->callback_js = jerry_value_copy(callback);
+  pulse_handles[id] = pulse;
+  int ret =
+      km_io_timer_start(&pulse->base, pulse_timer_cb, PULSE_POLL_INTERVAL, true);
+  if (ret < 0) {
+    pulse_release(pulse);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
+  return jerry_number(id);
+}
+
+/**
+ * capture() function
+ * args:
+ *   pin {number}
+ *   data {Uint32Array} filled with the durations of the levels (usec)
+ *   options {Object}
+ *     startState {number} wait for this level to start
+ *     mode {number} pin mode to set
+ *     timeout {number} ends when a level lasts longer than this (usec)
+ *   callback {function(data:Uint32Array, count:number)}
+ * returns:
+ *   {number} id to stop the capture
+ */
+JERRYXX_FUN(pulse_capture_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "pin");
+  JERRYXX_CHECK_ARG(1, "data");
+  JERRYXX_CHECK_ARG_OBJECT(2, "options");
+  JERRYXX_CHECK_ARG_FUNCTION(3, "callback");
+  uint8_t pin = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
+  jerry_value_t data = JERRYXX_GET_ARG(1);
+  jerry_value_t options = JERRYXX_GET_ARG(2);
+  size_t length = 0;
+  uint32_t *buf = pulse_get_buffer(data, &length);
+  if (buf == NULL) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The data argument must be Uint32Array");
+  }
+  uint8_t start_state = (uint8_t)jerryxx_get_property_number(
+      options, MSTR_PULSE_START_STATE, KM_PULSE_NO_STATE);
+  uint8_t mode = (uint8_t)jerryxx_get_property_number(options, MSTR_PULSE_MODE,
+                                                      255);
+  uint32_t timeout = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_PULSE_TIMEOUT, PULSE_DEFAULT_TIMEOUT);
+  if (mode < 255) {
+    km_gpio_set_io_mode(pin, mode);
+  }
+  int id = km_pulse_capture_start(pin, start_state, buf, length, timeout);
+  return pulse_start(id, true, data, JERRYXX_GET_ARG(3));
+}
+
+/**
+ * generate() function
+ * args:
+ *   pin {number}
+ *   data {Uint32Array} durations of the levels (usec)
+ *   options {Object}
+ *     startState {number} initial level of the pin, HIGH by default
+ *   callback {function(count:number)}
+ * returns:
+ *   {number} id to stop the generation
+ */
+JERRYXX_FUN(pulse_generate_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "pin");
+  JERRYXX_CHECK_ARG(1, "data");
+  JERRYXX_CHECK_ARG_OBJECT(2, "options");
+  JERRYXX_CHECK_ARG_FUNCTION(3, "callback");
+  uint8_t pin = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
+  jerry_value_t data = JERRYXX_GET_ARG(1);
+  jerry_value_t options = JERRYXX_GET_ARG(2);
+  size_t length = 0;
+  uint32_t *buf = pulse_get_buffer(data, &length);
+  if (buf == NULL) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The data argument must be Uint32Array");
+  }
+  uint8_t start_state = (uint8_t)jerryxx_get_property_number(
+      options, MSTR_PULSE_START_STATE, KM_GPIO_HIGH);
+  int id = km_pulse_generate_start(pin, start_state, buf, length);
+  return pulse_start(id, false, data, JERRYXX_GET_ARG(3));
+}
+
+/**
+ * stop() function
+ * args:
+ *   id {number} returned from capture() or generate()
+ */
+JERRYXX_FUN(pulse_stop_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "id");
+  int id = (int)JERRYXX_GET_ARG_NUMBER(0);
+  if (id >= 0 && id < KM_PULSE_MAX && pulse_handles[id] != NULL) {
+    pulse_release(pulse_handles[id]);
+  }
+  return jerry_undefined();
+}
+
+jerry_value_t module_pulse_init() {
+  for (int i = 0; i < KM_PULSE_MAX; i++) {
+    pulse_handles[i] = NULL;
+  }
+  jerry_value_t exports = jerry_object();
+  jerryxx_set_property_function(exports, MSTR_PULSE_CAPTURE, pulse_capture_fn);
+  jerryxx_set_property_function(exports, MSTR_PULSE_GENERATE,
+                                pulse_generate_fn);
+  jerryxx_set_property_function(exports, MSTR_PULSE_STOP, pulse_stop_fn);
+  return exports;
+}
@@ -20,8 +20,10 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "board.h"
+#include "err.h"
 #include "hardware/clocks.h"
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
@@ -34,6 +36,7 @@
 #include "jerryxx.h"
 #include "pico/stdlib.h"
 #include "pico/rand.h"
+#include "pio_dma.h"
 #include "rp2_magic_strings.h"
 
 #define __PIO_INT_EN_PIO0_0 1
@@ -49,7 +52,25 @@
 
 #define __RP2_TEMP_ADC_PORT 30
 
+#define __PIO_DMA_WAIT_TIME 1  // msec the loop may sleep while transferring
+
+/**
+ * DMA transfer io handle of a state machine. The blocks are in a
+ * Uint32Array, and tracked by the sampler handle in 16-bit units.
+ */
+typedef struct {
+  km_io_sampler_handle_t base;
+  uint8_t pio;
+  uint8_t sm;
+  bool tx;
+  bool continuous;
+  jerry_value_t data_js;
+  jerry_value_t callback_js;
+} __pio_dma_handle_t;
+
 static jerry_value_t __pio_call_back[KALUMA_PIO_NUM];
+static __pio_dma_handle_t *__pio_dma_handles[KALUMA_PIO_NUM][KALUMA_PIO_SM_NUM]
+                                            [2];
 
 static PIO __pio(uint8_t pio) {
   if (pio == 0) {
@@ -282,34 +303,97 @@ JERRYXX_FUN(pio_sm_exec_fn) {
   return jerry_undefined();
 }
 
+/**
+ * Put the elements of a Uint8Array, Uint16Array or Uint32Array view to the
+ * TX FIFO, each as a word shifted left by shift bits. If pack is true, the
+ * bytes of the view are packed into words in memory order instead, and the
+ * last word is padded with zeros.
+ */
+static bool __pio_sm_put_view(PIO pio, uint sm, jerry_value_t data,
+                              uint8_t shift, bool pack) {
+  size_t size;
+  switch (jerry_typedarray_type(data)) {
+    case JERRY_TYPEDARRAY_UINT8:
+    case JERRY_TYPEDARRAY_UINT8CLAMPED:
+      size = 1;
+      break;
+    case JERRY_TYPEDARRAY_UINT16:
+      size = 2;
+      break;
+    case JERRY_TYPEDARRAY_UINT32:
+      size = 4;
+      break;
+    default:
+      return false;
+  }
+  jerry_length_t byte_length = 0;
+  jerry_length_t byte_offset = 0;
+  jerry_value_t array_buffer =
+      jerry_typedarray_buffer(data, &byte_offset, &byte_length);
+  uint8_t *buf = jerry_arraybuffer_data(array_buffer) + byte_offset;
+  jerry_value_free(array_buffer);
+  if (pack) {
+    for (size_t i = 0; i < byte_length; i += 4) {
+      uint32_t word = 0;
+      size_t n = (byte_length - i < 4) ? byte_length - i : 4;
+      memcpy(&word, buf + i, n);
+      pio_sm_put_blocking(pio, sm, word << shift);
+    }
+  } else if (size == 1) {
+    for (size_t i = 0; i < byte_length; i++) {
+      pio_sm_put_blocking(pio, sm, (uint32_t)buf[i] << shift);
+    }
+  } else if (size == 2) {
+    uint16_t *buf16 = (uint16_t *)buf;
+    for (size_t i = 0; i < byte_length / 2; i++) {
+      pio_sm_put_blocking(pio, sm, (uint32_t)buf16[i] << shift);
+    }
+  } else {
+    uint32_t *buf32 = (uint32_t *)buf;
+    for (size_t i = 0; i < byte_length / 4; i++) {
+      pio_sm_put_blocking(pio, sm, buf32[i] << shift);
+    }
+  }
+  return true;
+}
+
+/**
+ * pio_sm_put()
+ * args:
+ *   pio {number}
+ *   sm {number}
+ *   data {number|Uint8Array|Uint16Array|Uint32Array}
+ *   shift {number} bits to shift each word left, 0 by default
+ *   pack {boolean} pack the bytes of data into words, false by default
+ */
 JERRYXX_FUN(pio_sm_put_fn) {
   JERRYXX_CHECK_ARG_NUMBER(0, "pio");
   JERRYXX_CHECK_ARG_NUMBER(1, "sm");
   JERRYXX_CHECK_ARG(2, "data");
+  JERRYXX_CHECK_ARG_NUMBER_OPT(3, "shift");
+  JERRYXX_CHECK_ARG_BOOLEAN_OPT(4, "pack");
   uint8_t pio = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
   uint8_t sm = (uint8_t)JERRYXX_GET_ARG_NUMBER(1);
   jerry_value_t data = JERRYXX_GET_ARG(2);
+  uint8_t shift = (uint8_t)JERRYXX_GET_ARG_NUMBER_OPT(3, 0);
+  bool pack = JERRYXX_GET_ARG_BOOLEAN_OPT(4, false);
+  if (shift > 31) {
+    return jerry_error_sz(JERRY_ERROR_RANGE, "shift must be 0 to 31.");
+  }
   PIO _pio = __pio(pio);
-  if (jerry_value_is_typedarray(data) &&
-      jerry_typedarray_type(data) ==
-          JERRY_TYPEDARRAY_UINT32) { /* Uint32Array */
-    jerry_length_t byteLength = 0;
-    jerry_length_t byteOffset = 0;
-    jerry_value_t array_buffer =
-        jerry_typedarray_buffer(data, &byteOffset, &byteLength);
-    size_t len = jerry_arraybuffer_size(array_buffer) / 4;
-    uint8_t *data_buf = jerry_arraybuffer_data(array_buffer);
-    jerry_value_free(array_buffer);
-    for (int i = 0; i < len; i++) {
-      pio_sm_put_blocking(_pio, sm, *((uint32_t *)data_buf + i));
+  if (jerry_value_is_typedarray(data)) {
+    if (!__pio_sm_put_view(_pio, sm, data, shift, pack)) {
+      return jerry_error_sz(JERRY_ERROR_TYPE,
+                            "The data argument must be number, Uint8Array, "
+                            "Uint16Array or Uint32Array");
     }
   } else if (jerry_value_is_number(data)) {
     uint32_t data_value = jerry_value_as_number(data);
-    pio_sm_put_blocking(_pio, sm, data_value);
+    pio_sm_put_blocking(_pio, sm, data_value << shift);
   } else {
-    return jerry_error_sz(
-        JERRY_ERROR_TYPE,
-        "The data argument must be number of Uint32Array");
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The data argument must be number, Uint8Array, "
+                          "Uint16Array or Uint32Array");
   }
   return jerry_undefined();
 }
@@ -398,6 +482,249 @@ JERRYXX_FUN(pio_sm_irq_fn) {
   return jerry_undefined();
 }
 
+static void __pio_dma_close_cb(km_io_handle_t *handle) { free(handle); }
+
+/**
+ * Free a handle left transferring at cleanup (soft reset). The JS values
+ * are already gone with the engine.
+ */
+static void __pio_dma_cleanup_cb(km_io_sampler_handle_t *base) {
+  __pio_dma_handle_t *handle = (__pio_dma_handle_t *)base;
+  __pio_dma_handles[handle->pio][handle->sm][handle->tx] = NULL;
+  free(handle);
+}
+
+static void __pio_dma_release(__pio_dma_handle_t *handle) {
+  km_pio_dma_stop(handle->pio, handle->sm, handle->tx);
+  km_io_sampler_stop(&handle->base);
+  jerry_value_free(handle->data_js);
+  jerry_value_free(handle->callback_js);
+  __pio_dma_handles[handle->pio][handle->sm][handle->tx] = NULL;
+  // free later, since this may be called in the block callback
+  km_io_handle_close((km_io_handle_t *)handle, __pio_dma_close_cb);
+}
+
+/**
+ * Commit a transferred block and reserve the next. Called from the DMA
+ * interrupt.
+ */
+static uint32_t *__pio_dma_cb(uint32_t *done, void *arg) {
+  __pio_dma_handle_t *handle = (__pio_dma_handle_t *)arg;
+  if (done != NULL) {
+    km_io_sampler_commit(&handle->base);
+  } else {
+    km_io_sampler_drop(&handle->base, handle->base.block_size / 2);
+  }
+  if (!handle->continuous) {
+    return NULL;
+  }
+  return (uint32_t *)km_io_sampler_reserve(&handle->base);
+}
+
+static void __pio_dma_block_cb(km_io_sampler_handle_t *base, uint32_t block) {
+  __pio_dma_handle_t *handle = (__pio_dma_handle_t *)base;
+  jerry_value_t callback = jerry_value_copy(handle->callback_js);
+  jerry_value_t array;
+  if (handle->continuous) {
+    jerry_length_t byte_offset = 0;
+    jerry_length_t byte_length = 0;
+    jerry_value_t array_buffer =
+        jerry_typedarray_buffer(handle->data_js, &byte_offset, &byte_length);
+    size_t block_words = base->block_size / 2;
+    array = jerry_typedarray_with_buffer_span(
+        JERRY_TYPEDARRAY_UINT32, array_buffer,
+        byte_offset + block * block_words * sizeof(uint32_t), block_words);
+    jerry_value_free(array_buffer);
+  } else {
+    // a single transfer is done, so another can be started in the callback
+    array = jerry_value_copy(handle->data_js);
+    __pio_dma_release(handle);
+  }
+  if (jerry_value_is_function(callback)) {
+    jerry_value_t index = jerry_number(block);
+    jerry_value_t this_val = jerry_undefined();
+    jerry_value_t args_p[2] = {array, index};
+    jerry_value_t ret_val = jerry_call(callback, this_val, args_p, 2);
+    if (jerry_value_is_error(ret_val)) {
+      jerryxx_print_error(ret_val, true);
+    }
+    jerry_value_free(ret_val);
+    jerry_value_free(this_val);
+    jerry_value_free(index);
+  }
+  jerry_value_free(array);
+  jerry_value_free(callback);
+}
+
+/**
+ * Start a DMA transfer between a Uint32Array and the TX or RX FIFO. With
+ * blocks of 3 or more, the array is divided into the blocks and transferred
+ * continuously: the callback is called with each block done, and the block
+ * is not transferred again until the callback returns. When the callback
+ * is late, zeros are sent (TX) or the words are dropped (RX). A TX block is
+ * done when its last word is in the TX FIFO.
+ */
+static jerry_value_t __pio_sm_dma_start(uint8_t pio, uint8_t sm, bool tx,
+                                        jerry_value_t data, uint32_t blocks,
+                                        jerry_value_t callback) {
+  if (pio >= KALUMA_PIO_NUM || sm >= KALUMA_PIO_SM_NUM) {
+    return jerry_error_sz(JERRY_ERROR_RANGE, "Invalid PIO or state machine.");
+  }
+  if (!jerry_value_is_typedarray(data) ||
+      jerry_typedarray_type(data) != JERRY_TYPEDARRAY_UINT32) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The data argument must be Uint32Array");
+  }
+  bool continuous = (blocks > 1);
+  if (!continuous) {
+    blocks = 1;
+  }
+  size_t length = jerry_typedarray_length(data);
+  if (blocks == 2 || length == 0 || length % blocks != 0) {
+    return jerry_error_sz(
+        JERRY_ERROR_RANGE,
+        "blocks must be 3 or more and divide the length of data.");
+  }
+  if (__pio_dma_handles[pio][sm][tx] != NULL) {
+    return jerry_exception_value(create_system_error(EBUSY), true);
+  }
+  jerry_length_t byte_offset = 0;
+  jerry_length_t byte_length = 0;
+  jerry_value_t array_buffer =
+      jerry_typedarray_buffer(data, &byte_offset, &byte_length);
+  uint32_t *buffer =
+      (uint32_t *)(jerry_arraybuffer_data(array_buffer) + byte_offset);
+  jerry_value_free(array_buffer);
+
+  __pio_dma_handle_t *handle = malloc(sizeof(__pio_dma_handle_t));
+  if (handle == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  km_io_sampler_init(&handle->base);
+  handle->base.cleanup_cb = __pio_dma_cleanup_cb;
+  handle->pio = pio;
+  handle->sm = sm;
+  handle->tx = tx;
+  handle->continuous = continuous;
+  size_t block_words = length / blocks;
+  km_io_sampler_start(&handle->base, (uint16_t *)buffer, block_words * 2,
+                      blocks, __PIO_DMA_WAIT_TIME, __pio_dma_block_cb);
+  uint32_t *buf0 = (uint32_t *)km_io_sampler_reserve(&handle->base);
+  uint32_t *buf1 =
+      continuous ? (uint32_t *)km_io_sampler_reserve(&handle->base) : NULL;
+  int ret = km_pio_dma_start(pio, sm, tx, block_words, buf0, buf1,
+                             __pio_dma_cb, handle);
+  if (ret < 0) {
+    km_io_sampler_stop(&handle->base);
+    free(handle);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
+  handle->data_js = jerry_value_copy(data);
+  handle->callback_js = jerry_value_copy(callback);
+  __pio_dma_handles[pio][sm][tx] = handle;
+  return jerry_undefined();
+}
+
+/**
+ * pio_sm_put_dma()
+ * args:
+ *   pio {number}
+ *   sm {number}
+ *   data {Uint32Array}
+ *   blocks {number} 0 for a single transfer
+ *   callback {function(data:Uint32Array, index:number)}
+ */
+JERRYXX_FUN(pio_sm_put_dma_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "pio");
+  JERRYXX_CHECK_ARG_NUMBER(1, "sm");
+  JERRYXX_CHECK_ARG(2, "data");
+  JERRYXX_CHECK_ARG_NUMBER_OPT(3, "blocks");
+  JERRYXX_CHECK_ARG_FUNCTION_OPT(4, "callback");
+  uint8_t pio = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
+  uint8_t sm = (uint8_t)JERRYXX_GET_ARG_NUMBER(1);
+  uint32_t blocks = (uint32_t)JERRYXX_GET_ARG_NUMBER_OPT(3, 0);
+  jerry_value_t callback =
+      JERRYXX_HAS_ARG(4) ? JERRYXX_GET_ARG(4) : jerry_undefined();
+  return __pio_sm_dma_start(pio, sm, true, JERRYXX_GET_ARG(2), blocks,
+                            callback);
+}
+
+/**
+ * pio_sm_get_dma()
+ * args:
+ *   pio {number}
+ *   sm {number}
+ *   data {Uint32Array}
+ *   blocks {number} 0 for a single transfer
+ *   callback {function(data:Uint32Array, index:number)}
+ */
+JERRYXX_FUN(pio_sm_get_dma_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "pio");
+  JERRYXX_CHECK_ARG_NUMBER(1, "sm");
+  JERRYXX_CHECK_ARG(2, "data");
+  JERRYXX_CHECK_ARG_NUMBER_OPT(3, "blocks");
+  JERRYXX_CHECK_ARG_FUNCTION_OPT(4, "callback");
+  uint8_t pio = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
+  uint8_t sm = (uint8_t)JERRYXX_GET_ARG_NUMBER(1);
+  uint32_t blocks = (uint32_t)JERRYXX_GET_ARG_NUMBER_OPT(3, 0);
+  jerry_value_t callback =
+      JERRYXX_HAS_ARG(4) ? JERRYXX_GET_ARG(4) : jerry_undefined();
+  return __pio_sm_dma_start(pio, sm, false, JERRYXX_GET_ARG(2), blocks,
+                            callback);
+}
+
+/**
+ * pio_sm_dma_stop()
+ * args:
+ *   pio {number}
+ *   sm {number}
+ *   tx {boolean}
+ */
+JERRYXX_FUN(pio_sm_dma_stop_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "pio");
+  JERRYXX_CHECK_ARG_NUMBER(1, "sm");
+  JERRYXX_CHECK_ARG_BOOLEAN(2, "tx");
+  uint8_t pio = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
+  uint8_t sm = (uint8_t)JERRYXX_GET_ARG_NUMBER(1);
+  bool tx = JERRYXX_GET_ARG_BOOLEAN(2);
+  if (pio < KALUMA_PIO_NUM && sm < KALUMA_PIO_SM_NUM &&
+      __pio_dma_handles[pio][sm][tx] != NULL) {
+    __pio_dma_release(__pio_dma_handles[pio][sm][tx]);
+  }
+  return jerry_undefined();
+}
+
+/**
+ * pio_sm_dma_stats()
+ * args:
+ *   pio {number}
+ *   sm {number}
+ *   tx {boolean}
+ * returns:
+ *   {Object} number of blocks done and words dropped (RX) or zeros sent
+ *   (TX) since the transfer started, or null if not transferring
+ */
+JERRYXX_FUN(pio_sm_dma_stats_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "pio");
+  JERRYXX_CHECK_ARG_NUMBER(1, "sm");
+  JERRYXX_CHECK_ARG_BOOLEAN(2, "tx");
+  uint8_t pio = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
+  uint8_t sm = (uint8_t)JERRYXX_GET_ARG_NUMBER(1);
+  bool tx = JERRYXX_GET_ARG_BOOLEAN(2);
+  if (pio >= KALUMA_PIO_NUM || sm >= KALUMA_PIO_SM_NUM ||
+      __pio_dma_handles[pio][sm][tx] == NULL) {
+    return jerry_null();
+  }
+  km_io_sampler_handle_t *handle = &__pio_dma_handles[pio][sm][tx]->base;
+  jerry_value_t obj = jerry_object();
+  jerryxx_set_property_number(obj, MSTR_RP2_PIO_DMA_BLOCKS,
+                              __atomic_load_n(&handle->head, __ATOMIC_ACQUIRE));
+  jerryxx_set_property_number(
+      obj, MSTR_RP2_PIO_DMA_OVERFLOW,
+      __atomic_load_n(&handle->overflow, __ATOMIC_RELAXED));
+  return obj;
+}
+
 JERRYXX_FUN(dormant_fn) {
   JERRYXX_CHECK_ARG_ARRAY(0, "pins");
   JERRYXX_CHECK_ARG_ARRAY(1, "events");
@@ -534,6 +861,7 @@ jerry_value_t module_rp2_init() {
   for (int i = 0; i < KALUMA_PIO_NUM; i++) {
     __pio_call_back[i] = jerry_undefined();
   }
+  memset(__pio_dma_handles, 0, sizeof(__pio_dma_handles));
 
   // pio module exports
   jerry_value_t exports = jerry_object();
@@ -558,6 +886,14 @@ jerry_value_t module_rp2_init() {
   jerryxx_set_property_function(exports, MSTR_RP2_PIO_SM_DRAIN_TXFIFO,
                                 pio_sm_drain_txfifo_fn);
   jerryxx_set_property_function(exports, MSTR_RP2_PIO_SM_IRQ, pio_sm_irq_fn);
+  jerryxx_set_property_function(exports, MSTR_RP2_PIO_SM_PUT_DMA,
+                                pio_sm_put_dma_fn);
+  jerryxx_set_property_function(exports, MSTR_RP2_PIO_SM_GET_DMA,
+                                pio_sm_get_dma_fn);
+  jerryxx_set_property_function(exports, MSTR_RP2_PIO_SM_DMA_STOP,
+                                pio_sm_dma_stop_fn);
+  jerryxx_set_property_function(exports, MSTR_RP2_PIO_SM_DMA_STATS,
+                                pio_sm_dma_stats_fn);
   jerryxx_set_property_function(exports, MSTR_RP2_DORMANT, dormant_fn);
   jerryxx_set_property_function(exports, MSTR_RP2_RANDOM_BIG_INT, random_big_int_fn);
   return exports;
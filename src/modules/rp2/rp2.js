@@ -456,8 +456,15 @@ class StateMachine {
     return rp2_native.pio_sm_get(this.pio, this.sm);
   }
 
-  put(value) {
-    rp2_native.pio_sm_put(this.pio, this.sm, value);
+  put(value, options) {
+    options = Object.assign({ shift: 0, pack: false }, options);
+    rp2_native.pio_sm_put(
+      this.pio,
+      this.sm,
+      value,
+      options.shift,
+      options.pack
+    );
   }
 
   setPins(value, mask) {
@@ -486,6 +493,34 @@ class StateMachine {
   irq(handler) {
     return rp2_native.pio_sm_irq(this.pio, handler);
   }
+
+  putDMA(data, callback) {
+    rp2_native.pio_sm_put_dma(this.pio, this.sm, data, 0, callback);
+  }
+
+  getDMA(data, callback) {
+    rp2_native.pio_sm_get_dma(this.pio, this.sm, data, 0, callback);
+  }
+
+  putStream(data, blocks, callback) {
+    rp2_native.pio_sm_put_dma(this.pio, this.sm, data, blocks, callback);
+  }
+
+  getStream(data, blocks, callback) {
+    rp2_native.pio_sm_get_dma(this.pio, this.sm, data, blocks, callback);
+  }
+
+  stopDMA() {
+    rp2_native.pio_sm_dma_stop(this.pio, this.sm, true);
+    rp2_native.pio_sm_dma_stop(this.pio, this.sm, false);
+  }
+
+  dmaStats() {
+    return {
+      tx: rp2_native.pio_sm_dma_stats(this.pio, this.sm, true),
+      rx: rp2_native.pio_sm_dma_stats(this.pio, this.sm, false),
+    };
+  }
 }
 
 function dormant(pins, events) {
@@ -73,6 +73,12 @@
 #define MSTR_RP2_STATE_MACHINE_CLEAR_FIFOS "clearFIFOs"
 #define MSTR_RP2_STATE_MACHINE_DRAIN_TXFIFO "drainTXFIFO"
 #define MSTR_RP2_STATE_MACHINE_IRQ "irq"
+#define MSTR_RP2_STATE_MACHINE_PUT_DMA "putDMA"
+#define MSTR_RP2_STATE_MACHINE_GET_DMA "getDMA"
+#define MSTR_RP2_STATE_MACHINE_PUT_STREAM "putStream"
+#define MSTR_RP2_STATE_MACHINE_GET_STREAM "getStream"
+#define MSTR_RP2_STATE_MACHINE_STOP_DMA "stopDMA"
+#define MSTR_RP2_STATE_MACHINE_DMA_STATS "dmaStats"
 
 #define MSTR_RP2_PIO_ADD_PROGRAM "pio_add_program"
 #define MSTR_RP2_PIO_SM_INIT "pio_sm_init"
@@ -114,6 +120,12 @@
 #define MSTR_RP2_PIO_SM_CLEAR_FIFOS "pio_sm_clear_fifos"
 #define MSTR_RP2_PIO_SM_DRAIN_TXFIFO "pio_sm_drain_txfifo"
 #define MSTR_RP2_PIO_SM_IRQ "pio_sm_irq"
+#define MSTR_RP2_PIO_SM_PUT_DMA "pio_sm_put_dma"
+#define MSTR_RP2_PIO_SM_GET_DMA "pio_sm_get_dma"
+#define MSTR_RP2_PIO_SM_DMA_STOP "pio_sm_dma_stop"
+#define MSTR_RP2_PIO_SM_DMA_STATS "pio_sm_dma_stats"
+#define MSTR_RP2_PIO_DMA_BLOCKS "blocks"
+#define MSTR_RP2_PIO_DMA_OVERFLOW "overflow"
 
 #define MSTR_RP2_DORMANT "dormant"
 #define MSTR_RP2_RANDOM_BIG_INT "randomBigInt"
@@ -0,0 +1,2 @@
+list(APPEND SOURCES ${SRC_DIR}/modules/sampler/module_sampler.c)
+include_directories(${SRC_DIR}/modules/sampler)
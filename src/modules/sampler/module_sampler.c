@@ -0,0 +1,329 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "adc.h"
+#include "err.h"
+#include "gpio.h"
+#include "io.h"
+#include "jerryscript.h"
+#include "jerryxx.h"
+#include "sampler.h"
+#include "sampler_magic_strings.h"
+
+#define SAMPLER_DEFAULT_RATE 1000
+#define SAMPLER_DEFAULT_BLOCK_SIZE 64
+#define SAMPLER_DEFAULT_BLOCKS 4
+#define SAMPLER_MAX_CHANNELS 8  // for each of ADC and GPIO
+
+/**
+ * Sampler io handle. A frame of all channels (ADC values followed by GPIO
+ * levels) is captured on each timer tick into a ring of blocks held by an
+ * ArrayBuffer, and each filled block is delivered as a Uint16Array view.
+ */
+typedef struct {
+  km_io_sampler_handle_t base;
+  uint8_t adc_count;
+  uint8_t adc[SAMPLER_MAX_CHANNELS];  // ADC index (output of km_adc_setup)
+  uint8_t gpio_count;
+  uint8_t gpio[SAMPLER_MAX_CHANNELS];
+  int timer;  // sampling timer id, or -1 if stopped
+  uint32_t period_us;
+  uint32_t block_size;  // samples per block
+  uint32_t block_count;
+  jerry_value_t buffer_js;
+  jerry_value_t callback_js;
+} sampler_handle_t;
+
+static void sampler_stop(sampler_handle_t *sampler) {
+  if (sampler->timer >= 0) {
+    km_sampler_stop(sampler->timer);
+    sampler->timer = -1;
+    km_io_sampler_stop(&sampler->base);
+  }
+}
+
+static void sampler_handle_freecb(void *handle,
+                                  struct jerry_object_native_info_t *info_p) {
+  sampler_handle_t *sampler = (sampler_handle_t *)handle;
+  sampler_stop(sampler);
+  jerry_value_free(sampler->buffer_js);
+  jerry_value_free(sampler->callback_js);
+  free(sampler);
+}
+
+static const jerry_object_native_info_t sampler_handle_info = {
+    .free_cb = sampler_handle_freecb};
+
+/**
+ * Capture a frame. Called from the timer interrupt (or thread).
+ */
+static void sampler_tick_cb(void *arg) {
+  sampler_handle_t *sampler = (sampler_handle_t *)arg;
+  uint16_t frame[SAMPLER_MAX_CHANNELS * 2];
+  size_t n = 0;
+  for (int i = 0; i < sampler->adc_count; i++) {
+    frame[n++] = km_adc_read_u16(sampler->adc[i]);
+  }
+  for (int i = 0; i < sampler->gpio_count; i++) {
+    frame[n++] = (uint16_t)km_gpio_read(sampler->gpio[i]);
+  }
+  km_io_sampler_put(&sampler->base, frame, n);
+}
+
+static void sampler_block_cb(km_io_sampler_handle_t *handle, uint32_t block) {
+  sampler_handle_t *sampler = (sampler_handle_t *)handle;
+  if (jerry_value_is_function(sampler->callback_js)) {
+    jerry_value_t array = jerry_typedarray_with_buffer_span(
+        JERRY_TYPEDARRAY_UINT16, sampler->buffer_js,
+        block * sampler->block_size * sizeof(uint16_t), sampler->block_size);
+    jerry_value_t index = jerry_number(block);
+    jerry_value_t this_val = jerry_undefined();
+    jerry_value_t args_p[2] = {array, index};
+    jerry_value_t ret_val =
+        jerry_call(sampler->callback_js, this_val, args_p, 2);
+    if (jerry_value_is_error(ret_val)) {
+      jerryxx_print_error(ret_val, true);
+    }
+    jerry_value_free(ret_val);
+    jerry_value_free(this_val);
+    jerry_value_free(index);
+    jerry_value_free(array);
+  }
+}
+
+static void sampler_close_cb(km_io_handle_t *handle) { free(handle); }
+
+/**
+ * Read an array of pin numbers into pins. Returns the number of pins, or -1
+ * if the value is not an array or has too many pins.
+ */
+static int sampler_get_pins(jerry_value_t options, const char *name,
+                            uint8_t *pins) {
+  jerry_value_t array = jerryxx_get_property(options, name);
+  int count = 0;
+  if (jerry_value_is_array(array)) {
+    count = jerry_array_length(array);
+    if (count > SAMPLER_MAX_CHANNELS) {
+      count = -1;
+    }
+    for (int i = 0; i < count; i++) {
+      jerry_value_t pin = jerry_object_get_index(array, i);
+      pins[i] = (uint8_t)jerry_value_as_number(pin);
+      jerry_value_free(pin);
+    }
+  } else if (!jerry_value_is_undefined(array)) {
+    count = -1;
+  }
+  jerry_value_free(array);
+  return count;
+}
+
+/**
+ * sampler_native constructor
+ * args:
+ *   options {Object}
+ *     adc {Array<number>} ADC pins
+ *     gpio {Array<number>} GPIO pins
+ *     rate {number} frames per second
+ *     blockSize {number} frames per block
+ *     blocks {number} blocks in the ring buffer
+ *   callback {function(data:Uint16Array, index:number)}
+ */
+JERRYXX_FUN(sampler_ctor_fn) {
+  JERRYXX_CHECK_ARG_OBJECT(0, "options");
+  JERRYXX_CHECK_ARG_FUNCTION(1, "callback");
+  jerry_value_t options = JERRYXX_GET_ARG(0);
+  jerry_value_t callback = JERRYXX_GET_ARG(1);
+
+  // read parameters
+  uint8_t adc_pins[SAMPLER_MAX_CHANNELS];
+  uint8_t gpio_pins[SAMPLER_MAX_CHANNELS];
+  int adc_count = sampler_get_pins(options, MSTR_SAMPLER_ADC, adc_pins);
+  int gpio_count = sampler_get_pins(options, MSTR_SAMPLER_GPIO, gpio_pins);
+  double rate = jerryxx_get_property_number(options, MSTR_SAMPLER_RATE,
+                                            SAMPLER_DEFAULT_RATE);
+  uint32_t block_frames = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_SAMPLER_BLOCK_SIZE, SAMPLER_DEFAULT_BLOCK_SIZE);
+  uint32_t block_count = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_SAMPLER_BLOCKS, SAMPLER_DEFAULT_BLOCKS);
+  if (adc_count < 0 || gpio_count < 0) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "adc and gpio must be arrays of up to 8 pins.");
+  }
+  if (adc_count + gpio_count == 0) {
+    return jerry_error_sz(JERRY_ERROR_RANGE, "No channels to sample.");
+  }
+  if (rate <= 0 || rate > 1000000) {
+    return jerry_error_sz(JERRY_ERROR_RANGE, "Invalid sampling rate.");
+  }
+  if (block_frames == 0 || block_count < 2) {
+    return jerry_error_sz(
+        JERRY_ERROR_RANGE,
+        "blockSize must be positive and blocks must be 2 or more.");
+  }
+
+  // setup channels
+  uint8_t channels = adc_count + gpio_count;
+  sampler_handle_t *sampler = malloc(sizeof(sampler_handle_t));
+  if (sampler == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  sampler->adc_count = adc_count;
+  for (int i = 0; i < adc_count; i++) {
+    int ret = km_adc_setup(adc_pins[i]);
+    if (ret < 0) {
+      free(sampler);
+      return jerry_exception_value(create_system_error(ret), true);
+    }
+    sampler->adc[i] = (uint8_t)ret;
+  }
+  sampler->gpio_count = gpio_count;
+  for (int i = 0; i < gpio_count; i++) {
+    sampler->gpio[i] = gpio_pins[i];
+  }
+
+  // allocate the ring buffer
+  sampler->block_size = block_frames * channels;
+  sampler->block_count = block_count;
+  sampler->buffer_js =
+      jerry_arraybuffer(sampler->block_size * block_count * sizeof(uint16_t));
+  if (jerry_value_is_exception(sampler->buffer_js)) {
+    jerry_value_t error = sampler->buffer_js;
+    free(sampler);
+    return error;
+  }
+  sampler->callback_js = jerry_value_copy(callback);
+  sampler->period_us = (uint32_t)(1000000 / rate);
+  if (sampler->period_us == 0) {
+    sampler->period_us = 1;
+  }
+  sampler->timer = -1;
+  km_io_sampler_init(&sampler->base);
+
+  jerry_value_t buffer = jerry_typedarray_with_buffer(JERRY_TYPEDARRAY_UINT16,
+                                                      sampler->buffer_js);
+  jerryxx_set_property(JERRYXX_GET_THIS, MSTR_SAMPLER_BUFFER, buffer);
+  jerry_value_free(buffer);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_SAMPLER_CHANNELS,
+                              channels);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_SAMPLER_RATE,
+                              1000000.0 / sampler->period_us);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_SAMPLER_BLOCK_SIZE,
+                              block_frames);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_SAMPLER_BLOCKS,
+                              block_count);
+  jerry_object_set_native_ptr(JERRYXX_GET_THIS, &sampler_handle_info, sampler);
+  return jerry_undefined();
+}
+
+/**
+ * Sampler.prototype.start() function
+ */
+JERRYXX_FUN(sampler_start_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(sampler, sampler_handle_t, sampler_handle_info);
+  if (sampler->timer >= 0) {
+    return jerry_undefined();
+  }
+  uint16_t *buffer = (uint16_t *)jerry_arraybuffer_data(sampler->buffer_js);
+  // wake up at least twice per block to deliver it in time
+  uint32_t block_time =
+      (uint32_t)(((uint64_t)sampler->block_size /
+                  (sampler->adc_count + sampler->gpio_count)) *
+                 sampler->period_us / 2000);
+  km_io_sampler_start(&sampler->base, buffer, sampler->block_size,
+                      sampler->block_count, block_time > 0 ? block_time : 1,
+                      sampler_block_cb);
+  int ret = km_sampler_start(sampler->period_us, sampler_tick_cb, sampler);
+  if (ret < 0) {
+    km_io_sampler_stop(&sampler->base);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
+  sampler->timer = ret;
+  return jerry_undefined();
+}
+
+/**
+ * Sampler.prototype.stop() function
+ */
+JERRYXX_FUN(sampler_stop_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(sampler, sampler_handle_t, sampler_handle_info);
+  sampler_stop(sampler);
+  return jerry_undefined();
+}
+
+/**
+ * Sampler.prototype.stats() function
+ * returns:
+ *   {Object} number of blocks filled and samples dropped since start()
+ */
+JERRYXX_FUN(sampler_stats_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(sampler, sampler_handle_t, sampler_handle_info);
+  jerry_value_t obj = jerry_object();
+  jerryxx_set_property_number(
+      obj, MSTR_SAMPLER_BLOCKS,
+      __atomic_load_n(&sampler->base.head, __ATOMIC_ACQUIRE));
+  jerryxx_set_property_number(
+      obj, MSTR_SAMPLER_OVERFLOW,
+      __atomic_load_n(&sampler->base.overflow, __ATOMIC_RELAXED));
+  return obj;
+}
+
+/**
+ * Sampler.prototype.close() function
+ */
+JERRYXX_FUN(sampler_close_fn) {
+  JERRYXX_GET_NATIVE_HANDLE(sampler, sampler_handle_t, sampler_handle_info);
+  sampler_stop(sampler);
+  jerry_value_free(sampler->buffer_js);
+  jerry_value_free(sampler->callback_js);
+  jerry_object_delete_native_ptr(JERRYXX_GET_THIS, &sampler_handle_info);
+  // free later, since close() may be called in the block callback
+  km_io_handle_close((km_io_handle_t *)sampler, sampler_close_cb);
+  return jerry_undefined();
+}
+
+/**
+ * Initialize 'sampler' module and return exports
+ */
+jerry_value_t module_sampler_init() {
+  /* Sampler class */
+  jerry_value_t sampler_ctor = jerry_function_external(sampler_ctor_fn);
+  jerry_value_t sampler_prototype = jerry_object();
+  jerryxx_set_property(sampler_ctor, "prototype", sampler_prototype);
+  jerryxx_set_property_function(sampler_prototype, MSTR_SAMPLER_START,
+                                sampler_start_fn);
+  jerryxx_set_property_function(sampler_prototype, MSTR_SAMPLER_STOP,
+                                sampler_stop_fn);
+  jerryxx_set_property_function(sampler_prototype, MSTR_SAMPLER_STATS,
+                                sampler_stats_fn);
+  jerryxx_set_property_function(sampler_prototype, MSTR_SAMPLER_CLOSE,
+                                sampler_close_fn);
+  jerry_value_free(sampler_prototype);
+
+  /* sampler module exports */
+  jerry_value_t exports = jerry_object();
+  jerryxx_set_property(exports, MSTR_SAMPLER_SAMPLER, sampler_ctor);
+  jerry_value_free(sampler_ctor);
+
+  return exports;
+}
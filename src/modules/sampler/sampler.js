@@ -0,0 +1,44 @@
+const sampler_native = process.binding(process.binding.sampler);
+const { EventEmitter } = require('events');
+
+/**
+ * Sample ADC channels and GPIO levels at a fixed rate. Each 'data' event
+ * passes a block of interleaved frames (ADC values in 0-65535 followed by
+ * GPIO levels) as a Uint16Array view of the ring buffer, which is valid
+ * until the block is filled again.
+ */
+function Sampler(options) {
+  EventEmitter.call(this);
+  let self = this;
+  options = options || {};
+  this._native = new sampler_native.Sampler(options, function (data, index) {
+    self.emit('data', data, index);
+  });
+  this.buffer = this._native.buffer;
+  this.channels = this._native.channels;
+  this.rate = this._native.rate;
+  this.blockSize = this._native.blockSize;
+  this.blocks = this._native.blocks;
+}
+
+// Inherits from EventEmitter
+Sampler.prototype = new EventEmitter();
+Sampler.prototype.constructor = Sampler;
+
+Sampler.prototype.start = function () {
+  this._native.start();
+}
+
+Sampler.prototype.stop = function () {
+  this._native.stop();
+}
+
+Sampler.prototype.stats = function () {
+  return this._native.stats();
+}
+
+Sampler.prototype.close = function () {
+  this._native.close();
+}
+
+exports.Sampler = Sampler;
@@ -0,0 +1,39 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __SAMPLER_MAGIC_STRINGS_H
+#define __SAMPLER_MAGIC_STRINGS_H
+
+#define MSTR_SAMPLER_SAMPLER "Sampler"
+#define MSTR_SAMPLER_ADC "adc"
+#define MSTR_SAMPLER_GPIO "gpio"
+#define MSTR_SAMPLER_RATE "rate"
+#define MSTR_SAMPLER_BLOCK_SIZE "blockSize"
+#define MSTR_SAMPLER_BLOCKS "blocks"
+#define MSTR_SAMPLER_CHANNELS "channels"
+#define MSTR_SAMPLER_BUFFER "buffer"
+#define MSTR_SAMPLER_START "start"
+#define MSTR_SAMPLER_STOP "stop"
+#define MSTR_SAMPLER_STATS "stats"
+#define MSTR_SAMPLER_CLOSE "close"
+#define MSTR_SAMPLER_OVERFLOW "overflow"
+
+#endif /* __SAMPLER_MAGIC_STRINGS_H */
@@ -23,6 +23,7 @@
 
 #include <stdlib.h>
 
+#include "blkdev.h"
 #include "board.h"
 #include "err.h"
 #include "gpio.h"
@@ -184,51 +185,127 @@ static int __send_command(uint8_t command, uint32_t arg, uint8_t crc) {
   return ret;
 }
 
-static int __receive_datablock(uint8_t *buff, unsigned int length) {
-  int ret = 0;
-  uint8_t send = 0xFF;
+/**
+ * Transfer a data block payload in background (DMA) and wait for it
+ */
+static int __transfer_payload(const uint8_t *tx_buf, uint8_t *rx_buf,
+                              unsigned int length) {
+  int ret = km_spi_transfer_async(__sdcard_handle.bus, tx_buf, rx_buf, length);
+  if (ret < 0) {
+    return ret;
+  }
+  while (km_spi_transfer_busy(__sdcard_handle.bus)) {
+  }
+  return 0;
+}
+
+static int __receive_data(uint8_t *buff, unsigned int length) {
   uint8_t tocken;
   const uint32_t timeout_ms = 200;
   uint64_t start_ms = km_gettime();
   do {
     km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);
   } while (tocken == 0xFF && km_gettime() < start_ms + timeout_ms);
-  if (tocken == 0xFE) {
-    km_spi_recv(__sdcard_handle.bus, 0xFF, buff, length, length * 10);
-    km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);  // CRC
-    km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);  // CRC
-  } else {
-    ret = ETIMEDOUT;
+  if (tocken != 0xFE) {
+    return ETIMEDOUT;
   }
-  km_spi_send(__sdcard_handle.bus, &send, 1, 100);
-  CS_HIGH;
-  km_spi_send(__sdcard_handle.bus, &send, 1, 100);
-  return ret;
+  if (__transfer_payload(NULL, buff, length) < 0) {
+    return EIO;
+  }
+  km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);  // CRC
+  km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);  // CRC
+  return 0;
 }
 
-static int __send_datablock(uint8_t *buff, unsigned int length) {
-  int ret = 0;
-  uint8_t send = 0xFF;
-  uint8_t tocken = 0xFE;
+static int __send_data(uint8_t tocken, const uint8_t *buff,
+                       unsigned int length) {
   km_spi_send(__sdcard_handle.bus, &tocken, 1, 100);  // Send start token
-  km_spi_send(__sdcard_handle.bus, buff, length,
-              length * 10);  // Send start token
+  if (__transfer_payload(buff, NULL, length) < 0) {  // Send data
+    return EIO;
+  }
   const uint32_t timeout_ms = 300;
   uint64_t start_ms = km_gettime();
   do {
     km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);
   } while (tocken == 0xFF && km_gettime() < start_ms + timeout_ms);
-  if ((tocken & 0x1F) == 0x05) {  // Dsta accepted
-    start_ms = km_gettime();
-    do {
-      km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);
-    } while (tocken == 0x00 && km_gettime() < start_ms + timeout_ms);
-  } else {
-    ret = ETIMEDOUT;
+  if ((tocken & 0x1F) != 0x05) {  // Data not accepted
+    return ETIMEDOUT;
   }
+  start_ms = km_gettime();
+  do {
+    km_spi_recv(__sdcard_handle.bus, 0xFF, &tocken, 1, 10);
+  } while (tocken == 0x00 && km_gettime() < start_ms + timeout_ms);
+  return 0;
+}
+
+static void __end_transfer(void) {
+  uint8_t send = 0xFF;
   km_spi_send(__sdcard_handle.bus, &send, 1, 100);
   CS_HIGH;
   km_spi_send(__sdcard_handle.bus, &send, 1, 100);
+}
+
+static int __receive_datablock(uint8_t *buff, unsigned int length) {
+  int ret = __receive_data(buff, length);
+  __end_transfer();
+  return ret;
+}
+
+static int __send_datablock(const uint8_t *buff, unsigned int length) {
+  int ret = __send_data(0xFE, buff, length);
+  __end_transfer();
+  return ret;
+}
+
+/**
+ * Read contiguous blocks with READ_MULTIPLE_BLOCK, streaming the data blocks
+ * without a command round trip per block.
+ */
+static int __receive_datablocks(uint32_t address, uint8_t *buff,
+                                uint32_t count) {
+  int ret = 0;
+  if (__send_command(SD_CMD18, address, 0x00) != 0) {
+    __end_transfer();
+    return EIO;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    ret = __receive_data(buff, __sdcard_handle.size);
+    if (ret < 0) {
+      break;
+    }
+    buff += __sdcard_handle.size;
+  }
+  __send_command(SD_CMD12, 0, 0x00);
+  __wait_for_ready(500);
+  __end_transfer();
+  return ret;
+}
+
+/**
+ * Write contiguous blocks with WRITE_MULTIPLE_BLOCK. SD cards are told the
+ * number of blocks first (ACMD23) so they can pre-erase them.
+ */
+static int __send_datablocks(uint32_t address, const uint8_t *buff,
+                             uint32_t count) {
+  int ret = 0;
+  if (!(__sdcard_handle.sd_type & SD_TYPE_MMC)) {
+    __send_command(SD_ACMD23, count, 0x00);
+  }
+  if (__send_command(SD_CMD25, address, 0x00) != 0) {
+    __end_transfer();
+    return EIO;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    ret = __send_data(0xFC, buff, __sdcard_handle.size);
+    if (ret < 0) {
+      break;
+    }
+    buff += __sdcard_handle.size;
+  }
+  uint8_t stop = 0xFD;  // Stop transmission token
+  km_spi_send(__sdcard_handle.bus, &stop, 1, 100);
+  __wait_for_ready(500);
+  __end_transfer();
   return ret;
 }
 
@@ -346,6 +423,95 @@ static void init_sd(void) {
   __sdcard_handle.count = 0;
   __sdcard_handle.size = 0;
 }
+static uint32_t __block_address(uint32_t block) {
+  // SDHC/SDXC cards are block addressed, SDSC and MMC cards byte addressed
+  if (__sdcard_handle.sd_type & SD_TYPE_SDHC) {
+    return block;
+  }
+  return block * __sdcard_handle.size;
+}
+
+static int sdcard_blkdev_read(km_blkdev_t *blkdev, uint32_t block,
+                              uint32_t offset, uint8_t *buffer, size_t size) {
+  if (!(__sdcard_handle.status & SD_STATUS_INIT)) {
+    return ENODEV;
+  }
+  if ((offset != 0) || (size % __sdcard_handle.size)) {
+    return EINVAL;
+  }
+  uint32_t count = size / __sdcard_handle.size;
+  if (count > 1) {
+    return (__receive_datablocks(__block_address(block), buffer, count) < 0)
+               ? EIO
+               : 0;
+  }
+  if ((__send_command(SD_CMD17, __block_address(block), 0x00) != 0) ||
+      (__receive_datablock(buffer, __sdcard_handle.size) < 0)) {
+    return EIO;
+  }
+  return 0;
+}
+
+static int sdcard_blkdev_write(km_blkdev_t *blkdev, uint32_t block,
+                               uint32_t offset, const uint8_t *buffer,
+                               size_t size) {
+  if (!(__sdcard_handle.status & SD_STATUS_INIT)) {
+    return ENODEV;
+  }
+  if ((offset != 0) || (size % __sdcard_handle.size)) {
+    return EINVAL;
+  }
+  uint32_t count = size / __sdcard_handle.size;
+  if (count > 1) {
+    return (__send_datablocks(__block_address(block), buffer, count) < 0)
+               ? EIO
+               : 0;
+  }
+  if ((__send_command(SD_CMD24, __block_address(block), 0x00) != 0) ||
+      (__send_datablock(buffer, __sdcard_handle.size) < 0)) {
+    return EIO;
+  }
+  return 0;
+}
+
+static int sdcard_blkdev_ioctl(km_blkdev_t *blkdev, int op, int arg) {
+  int ret;
+  switch (op) {
+    case KM_BLKDEV_IOCTL_INIT:
+      ret = __sdcard_init();
+      if (ret == EALREADY) {
+        return (int)__sdcard_handle.status;
+      }
+      return (ret > 0) ? ret : EIO;
+    case KM_BLKDEV_IOCTL_SHUTDOWN:
+      init_sd();
+      return 0;
+    case KM_BLKDEV_IOCTL_SYNC:
+      return 0;
+    case KM_BLKDEV_IOCTL_BLOCK_COUNT:
+      return __sdcard_handle.count;
+    case KM_BLKDEV_IOCTL_BLOCK_SIZE:
+    case KM_BLKDEV_IOCTL_BUFFER_SIZE:
+      return __sdcard_handle.size;
+    case KM_BLKDEV_IOCTL_BLOCK_ERASE:
+      if (!(__sdcard_handle.status & SD_STATUS_INIT)) {
+        return ENODEV;
+      }
+      if (__erase_datablock(__block_address(arg), __block_address(arg)) < 0) {
+        return EIO;
+      }
+      return 0;
+    default:
+      return EINVAL;
+  }
+}
+
+static const km_blkdev_ops_t sdcard_blkdev_ops = {
+    .read = sdcard_blkdev_read,
+    .write = sdcard_blkdev_write,
+    .ioctl = sdcard_blkdev_ioctl,
+};
+
 /**
  * Sdcard (block device) constructor
  * args:
@@ -398,6 +564,14 @@ JERRYXX_FUN(sdcard_ctor_fn) {
   init_sd();
   __sdcard_handle.bus = bus;
   __sdcard_handle.cs_pin = cs_pin;
+
+  // attach native block device (used directly by the VFS modules)
+  km_blkdev_t *blkdev = (km_blkdev_t *)malloc(sizeof(km_blkdev_t));
+  if (blkdev == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  blkdev->ops = &sdcard_blkdev_ops;
+  km_blkdev_attach(JERRYXX_GET_THIS, blkdev);
   return jerry_undefined();
 }
 
@@ -405,7 +579,7 @@ JERRYXX_FUN(sdcard_ctor_fn) {
  * Sdcard.prototype.read()
  * args:
  *   block {number}
- *   buffer {Uint8Array}
+ *   buffer {Uint8Array} multiple of the block size
  *   offset {number}
  */
 JERRYXX_FUN(sdcard_read_fn) {
@@ -415,24 +589,22 @@ JERRYXX_FUN(sdcard_read_fn) {
   JERRYXX_CHECK_ARG_NUMBER_OPT(2, "offset")
   int block = JERRYXX_GET_ARG_NUMBER(0);
   jerry_value_t buffer = JERRYXX_GET_ARG(1);
-  // int offset = JERRYXX_GET_ARG_NUMBER_OPT(2, 0);
+  int offset = JERRYXX_GET_ARG_NUMBER_OPT(2, 0);
+  JERRYXX_GET_NATIVE_HANDLE(blkdev, km_blkdev_t, km_blkdev_native_info);
 
   // get buffer pointer
   jerry_length_t buffer_length = 0;
   jerry_length_t buffer_offset = 0;
   jerry_value_t arrbuf =
       jerry_typedarray_buffer(buffer, &buffer_offset, &buffer_length);
-  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf);
+  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf) + buffer_offset;
   jerry_value_free(arrbuf);
-  if (!(__sdcard_handle.status & SD_STATUS_INIT)) {
-    return jerry_error_sz(
-        JERRY_ERROR_COMMON, "SDCard is not initialized.");
-  }
-  if (__send_command(SD_CMD17, block, 0x00) != 0xFF) {
-    if (__receive_datablock(buffer_pointer, __sdcard_handle.size) < 0) {
-      return jerry_error_sz(JERRY_ERROR_COMMON,
-                                "SDCard read error.");
-    }
+  int ret = blkdev->ops->read(blkdev, block, offset, buffer_pointer,
+                              buffer_length);
+  if (ret == ENODEV) {
+    return jerry_error_sz(JERRY_ERROR_COMMON, "SDCard is not initialized.");
+  } else if (ret < 0) {
+    return jerry_error_sz(JERRY_ERROR_COMMON, "SDCard read error.");
   }
   return jerry_undefined();
 }
@@ -441,7 +613,7 @@ JERRYXX_FUN(sdcard_read_fn) {
  * Sdcard.prototype.write()
  * args:
  *   block {number}
- *   buffer {Uint8Array}
+ *   buffer {Uint8Array} multiple of the block size
  *   offset {number}
  */
 JERRYXX_FUN(sdcard_write_fn) {
@@ -451,23 +623,22 @@ JERRYXX_FUN(sdcard_write_fn) {
   JERRYXX_CHECK_ARG_NUMBER_OPT(2, "offset")
   int block = JERRYXX_GET_ARG_NUMBER(0);
   jerry_value_t buffer = JERRYXX_GET_ARG(1);
-  // int offset = JERRYXX_GET_ARG_NUMBER_OPT(2, 0);
+  int offset = JERRYXX_GET_ARG_NUMBER_OPT(2, 0);
+  JERRYXX_GET_NATIVE_HANDLE(blkdev, km_blkdev_t, km_blkdev_native_info);
 
   // get buffer pointer
   jerry_length_t buffer_length = 0;
   jerry_length_t buffer_offset = 0;
   jerry_value_t arrbuf =
       jerry_typedarray_buffer(buffer, &buffer_offset, &buffer_length);
-  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf);
+  uint8_t *buffer_pointer = jerry_arraybuffer_data(arrbuf) + buffer_offset;
   jerry_value_free(arrbuf);
-  if (!(__sdcard_handle.status & SD_STATUS_INIT)) {
-    return jerry_error_sz(
-        JERRY_ERROR_COMMON, "SDCard is not initialized.");
-  }
-  if ((__send_command(SD_CMD24, block, 0x00) != 0x00) ||
-      (__send_datablock(buffer_pointer, __sdcard_handle.size) < 0)) {
-    return jerry_error_sz(JERRY_ERROR_COMMON,
-                              "SDCard write error.");
+  int ret = blkdev->ops->write(blkdev, block, offset, buffer_pointer,
+                               buffer_length);
+  if (ret == ENODEV) {
+    return jerry_error_sz(JERRY_ERROR_COMMON, "SDCard is not initialized.");
+  } else if (ret < 0) {
+    return jerry_error_sz(JERRY_ERROR_COMMON, "SDCard write error.");
   }
   return jerry_undefined();
 }
@@ -484,43 +655,24 @@ JERRYXX_FUN(sdcard_ioctl_fn) {
   JERRYXX_CHECK_ARG_NUMBER_OPT(1, "arg")
   int op = JERRYXX_GET_ARG_NUMBER(0);
   int arg = JERRYXX_GET_ARG_NUMBER_OPT(1, 0);
-  int ret;
+  JERRYXX_GET_NATIVE_HANDLE(blkdev, km_blkdev_t, km_blkdev_native_info);
 
-  switch (op) {
-    case 1:  // init
-      ret = __sdcard_init();
-      if (ret <= 0) {
-        return jerry_error_sz(JERRY_ERROR_COMMON,
-                                  "SD Card init error.");
-      }
-      return jerry_number(ret);
-    case 2:  // shutdown
-      init_sd();
-      return jerry_number(0);
-    case 3:  // sync
-      return jerry_number(0);
-    case 4:  // block count
-      return jerry_number(__sdcard_handle.count);
-    case 5:  // block size
-      return jerry_number(__sdcard_handle.size);
-    case 6:  // erase block
-      if (!(__sdcard_handle.status & SD_STATUS_INIT)) {
-        return jerry_error_sz(
-            JERRY_ERROR_COMMON,
-            "SDCard is not initialized.");
-      } else {
-        if (__erase_datablock(arg, arg) < 0) {
-          return jerry_error_sz(
-              JERRY_ERROR_COMMON, "SDCard earse error.");
+  int ret = blkdev->ops->ioctl(blkdev, op, arg);
+  if (ret < 0) {
+    switch (op) {
+      case KM_BLKDEV_IOCTL_INIT:
+        return jerry_error_sz(JERRY_ERROR_COMMON, "SD Card init error.");
+      case KM_BLKDEV_IOCTL_BLOCK_ERASE:
+        if (ret == ENODEV) {
+          return jerry_error_sz(JERRY_ERROR_COMMON,
+                                "SDCard is not initialized.");
         }
-      }
-      return jerry_number(0);
-    case 7:  // buffer size
-      return jerry_number(__sdcard_handle.size);
-    default:
-      return jerry_error_sz(JERRY_ERROR_COMMON,
-                                "Unknown operation.");
+        return jerry_error_sz(JERRY_ERROR_COMMON, "SDCard earse error.");
+      default:
+        return jerry_error_sz(JERRY_ERROR_COMMON, "Unknown operation.");
+    }
   }
+  return jerry_number(ret);
 }
 
 /**
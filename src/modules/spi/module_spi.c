@@ -22,6 +22,7 @@
 #include <stdlib.h>
 
 #include "err.h"
+#include "io.h"
 #include "jerryscript.h"
 #include "jerryxx.h"
 #include "spi.h"
@@ -31,6 +32,223 @@
 #define SPI_DEFAULT_BAUDRATE 3000000
 #define SPI_DEFAULT_BITORDER KM_SPI_BITORDER_MSB
 #define SPI_DEFAULT_PULL KM_SPI_DATA_NOPULL
+#define SPI_DMA_MIN_LENGTH 64
+
+/**
+ * Transfer data in background (DMA) and wait for the completion. Used for
+ * large payloads such as framebuffers pushed by display drivers.
+ */
+static int spi_transfer_dma(uint8_t bus, const uint8_t *tx_buf,
+                            uint8_t *rx_buf, size_t len) {
+  int ret = km_spi_transfer_async(bus, tx_buf, rx_buf, len);
+  if (ret < 0) {
+    return ret;
+  }
+  while (km_spi_transfer_busy(bus)) {
+  }
+  return len;
+}
+
+#define SPI_ASYNC_BUS_NUM 4
+
+/**
+ * A pending asynchronous transfer. Requests on the same bus are queued and
+ * the first one is in progress.
+ */
+typedef struct spi_request_s {
+  km_io_spi_handle_t base;
+  struct spi_request_s *next;
+  jerry_value_t promise;
+  jerry_value_t data_js;  // keeps the data to send alive
+  uint8_t *tx_buf;
+  bool tx_allocated;  // tx_buf is a copy of a string
+  uint8_t *rx_buf;    // NULL if received data are discarded
+  size_t len;
+} spi_request_t;
+
+static spi_request_t *spi_requests[SPI_ASYNC_BUS_NUM];
+
+static void spi_request_start(uint8_t bus);
+
+static void spi_request_settle(spi_request_t *req, int status) {
+  jerry_value_t ret;
+  if (status < 0) {
+    free(req->rx_buf);
+    jerry_value_t err = create_system_error(status);
+    ret = jerry_promise_reject(req->promise, err);
+    jerry_value_free(err);
+  } else if (req->rx_buf != NULL) {
+    jerry_value_t buffer =
+        jerry_arraybuffer_external(req->rx_buf, req->len, NULL);
+    jerry_value_t array =
+        jerry_typedarray_with_buffer(JERRY_TYPEDARRAY_UINT8, buffer);
+    ret = jerry_promise_resolve(req->promise, array);
+    jerry_value_free(array);
+    jerry_value_free(buffer);
+  } else {
+    jerry_value_t len = jerry_number(req->len);
+    ret = jerry_promise_resolve(req->promise, len);
+    jerry_value_free(len);
+  }
+  jerry_value_free(ret);
+  jerry_value_free(req->promise);
+  jerry_value_free(req->data_js);
+  if (req->tx_allocated) {
+    free(req->tx_buf);
+  }
+  free(req);
+}
+
+static void spi_request_cb(km_io_spi_handle_t *handle, int status) {
+  uint8_t bus = handle->bus;
+  spi_request_t *req = (spi_request_t *)handle;
+  spi_requests[bus] = req->next;
+  spi_request_settle(req, status);
+  spi_request_start(bus);
+}
+
+static void spi_request_start(uint8_t bus) {
+  while (spi_requests[bus] != NULL) {
+    spi_request_t *req = spi_requests[bus];
+    int ret = km_io_spi_transfer(&req->base, bus, req->tx_buf, req->rx_buf,
+                                 req->len, spi_request_cb);
+    if (ret == 0) {
+      return;
+    }
+    spi_requests[bus] = req->next;
+    spi_request_settle(req, ret);
+  }
+}
+
+/**
+ * Release the requests queued on the bus at cleanup (soft reset). Called for
+ * the request in progress, the first one. The JS values are already gone
+ * with the engine.
+ */
+static void spi_request_cleanup_cb(km_io_spi_handle_t *handle) {
+  uint8_t bus = handle->bus;
+  spi_request_t *req = spi_requests[bus];
+  while (req != NULL) {
+    spi_request_t *next = req->next;
+    free(req->rx_buf);
+    if (req->tx_allocated) {
+      free(req->tx_buf);
+    }
+    free(req);
+    req = next;
+  }
+  spi_requests[bus] = NULL;
+}
+
+/**
+ * Reject the requests waiting behind the one in progress when the bus is
+ * closed. The request in progress is settled when it is completed.
+ */
+static void spi_request_cancel(uint8_t bus) {
+  if (bus >= SPI_ASYNC_BUS_NUM || spi_requests[bus] == NULL) {
+    return;
+  }
+  spi_request_t *req = spi_requests[bus]->next;
+  spi_requests[bus]->next = NULL;
+  while (req != NULL) {
+    spi_request_t *next = req->next;
+    spi_request_settle(req, ECANCELED);
+    req = next;
+  }
+}
+
+/**
+ * Release a request which is not submitted
+ */
+static void spi_request_free(spi_request_t *req) {
+  jerry_value_free(req->data_js);
+  if (req->tx_allocated) {
+    free(req->tx_buf);
+  }
+  free(req->rx_buf);
+  free(req);
+}
+
+/**
+ * Queue an asynchronous transfer and return a promise settled when it is
+ * completed. The request is released if it can not be queued.
+ */
+static jerry_value_t spi_request_submit(uint8_t bus, spi_request_t *req) {
+  if (bus >= SPI_ASYNC_BUS_NUM) {
+    spi_request_free(req);
+    return jerry_exception_value(create_system_error(EINVAL), true);
+  }
+  km_io_spi_init(&req->base);
+  req->base.cleanup_cb = spi_request_cleanup_cb;
+  req->next = NULL;
+  req->promise = jerry_promise();
+  jerry_value_t promise = jerry_value_copy(req->promise);
+  if (spi_requests[bus] == NULL) {
+    spi_requests[bus] = req;
+    spi_request_start(bus);
+  } else {
+    spi_request_t *tail = spi_requests[bus];
+    while (tail->next != NULL) {
+      tail = tail->next;
+    }
+    tail->next = req;
+  }
+  return promise;
+}
+
+/**
+ * Fill the request with the data to send (Uint8Array or string). Return 0,
+ * EINVAL if the data is not Uint8Array or string, or ENOMEM.
+ */
+static int spi_request_set_data(spi_request_t *req, jerry_value_t data) {
+  if (jerry_value_is_typedarray(data) &&
+      jerry_typedarray_type(data) == JERRY_TYPEDARRAY_UINT8) {
+    jerry_length_t byteLength = 0;
+    jerry_length_t byteOffset = 0;
+    jerry_value_t array_buffer =
+        jerry_typedarray_buffer(data, &byteOffset, &byteLength);
+    req->tx_buf = jerry_arraybuffer_data(array_buffer) + byteOffset;
+    req->tx_allocated = false;
+    req->len = byteLength;
+    req->data_js = jerry_value_copy(data);
+    jerry_value_free(array_buffer);
+    return 0;
+  } else if (jerry_value_is_string(data)) {
+    req->len = jerryxx_get_ascii_string_size(data);
+    req->tx_buf = malloc(req->len > 0 ? req->len : 1);
+    if (req->tx_buf == NULL) {
+      return ENOMEM;
+    }
+    req->tx_allocated = true;
+    req->data_js = jerry_undefined();
+    jerryxx_string_to_ascii_char_buffer(data, req->tx_buf, req->len);
+    return 0;
+  }
+  return EINVAL;
+}
+
+/**
+ * Create a request with the data to send. Throws if failed.
+ */
+static jerry_value_t spi_request_create(jerry_value_t data,
+                                        spi_request_t **req_p) {
+  spi_request_t *req = malloc(sizeof(spi_request_t));
+  if (req == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  req->rx_buf = NULL;
+  int ret = spi_request_set_data(req, data);
+  if (ret == EINVAL) {
+    free(req);
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The data argument must be Uint8Array or string.");
+  } else if (ret < 0) {
+    free(req);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
+  *req_p = req;
+  return jerry_undefined();
+}
 
 /**
  * SPI() constructor
@@ -122,7 +340,9 @@ JERRYXX_FUN(spi_transfer_fn) {
     size_t len = jerry_arraybuffer_size(array_buffer);
     uint8_t *tx_buf = jerry_arraybuffer_data(array_buffer);
     uint8_t *rx_buf = malloc(len);
-    int ret = km_spi_sendrecv(bus, tx_buf, rx_buf, len, timeout);
+    int ret = (len >= SPI_DMA_MIN_LENGTH)
+                  ? spi_transfer_dma(bus, tx_buf, rx_buf, len)
+                  : km_spi_sendrecv(bus, tx_buf, rx_buf, len, timeout);
     jerry_value_free(array_buffer);
     if (ret < 0) {
       free(rx_buf);
@@ -193,7 +413,9 @@ JERRYXX_FUN(spi_send_fn) {
     size_t len = jerry_arraybuffer_size(array_buffer);
     uint8_t *tx_buf = jerry_arraybuffer_data(array_buffer);
     for (int c = 0; c < count; c++) {
-      ret = km_spi_send(bus, tx_buf, len, timeout);
+      ret = (len >= SPI_DMA_MIN_LENGTH)
+                ? spi_transfer_dma(bus, tx_buf, NULL, len)
+                : km_spi_send(bus, tx_buf, len, timeout);
       if (ret < 0) break;
     }
     jerry_value_free(array_buffer);
@@ -254,6 +476,103 @@ JERRYXX_FUN(spi_recv_fn) {
   }
 }
 
+/**
+ * SPI.prototype.transferAsync() function
+ * args:
+ *   data {Uint8Array|string}
+ * returns {Promise<Uint8Array>} resolved with the received data
+ */
+JERRYXX_FUN(spi_transfer_async_fn) {
+  JERRYXX_CHECK_ARG(0, "data");
+  jerry_value_t data = JERRYXX_GET_ARG(0);
+
+  // check this.bus number
+  jerry_value_t bus_value =
+      jerryxx_get_property(JERRYXX_GET_THIS, MSTR_SPI_BUS);
+  if (!jerry_value_is_number(bus_value)) {
+    jerry_value_free(bus_value);
+    return jerry_error_sz(JERRY_ERROR_REFERENCE, "SPI bus is not initialized.");
+  }
+  uint8_t bus = (uint8_t)jerry_value_as_number(bus_value);
+  jerry_value_free(bus_value);
+
+  spi_request_t *req = NULL;
+  jerry_value_t ret = spi_request_create(data, &req);
+  if (jerry_value_is_exception(ret)) {
+    return ret;
+  }
+  req->rx_buf = malloc(req->len > 0 ? req->len : 1);
+  if (req->rx_buf == NULL) {
+    spi_request_free(req);
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  return spi_request_submit(bus, req);
+}
+
+/**
+ * SPI.prototype.sendAsync() function
+ * args:
+ *   data {Uint8Array|string}
+ * returns {Promise<number>} resolved with the number of bytes sent
+ */
+JERRYXX_FUN(spi_send_async_fn) {
+  JERRYXX_CHECK_ARG(0, "data");
+  jerry_value_t data = JERRYXX_GET_ARG(0);
+
+  // check this.bus number
+  jerry_value_t bus_value =
+      jerryxx_get_property(JERRYXX_GET_THIS, MSTR_SPI_BUS);
+  if (!jerry_value_is_number(bus_value)) {
+    jerry_value_free(bus_value);
+    return jerry_error_sz(JERRY_ERROR_REFERENCE, "SPI bus is not initialized.");
+  }
+  uint8_t bus = (uint8_t)jerry_value_as_number(bus_value);
+  jerry_value_free(bus_value);
+
+  spi_request_t *req = NULL;
+  jerry_value_t ret = spi_request_create(data, &req);
+  if (jerry_value_is_exception(ret)) {
+    return ret;
+  }
+  return spi_request_submit(bus, req);
+}
+
+/**
+ * SPI.prototype.recvAsync() function (sends 0xFF while receiving)
+ * args:
+ *   length {number}
+ * returns {Promise<Uint8Array>} resolved with the received data
+ */
+JERRYXX_FUN(spi_recv_async_fn) {
+  JERRYXX_CHECK_ARG_NUMBER(0, "length");
+  uint32_t length = (uint32_t)JERRYXX_GET_ARG_NUMBER(0);
+
+  // check this.bus number
+  jerry_value_t bus_value =
+      jerryxx_get_property(JERRYXX_GET_THIS, MSTR_SPI_BUS);
+  if (!jerry_value_is_number(bus_value)) {
+    jerry_value_free(bus_value);
+    return jerry_error_sz(JERRY_ERROR_REFERENCE, "SPI bus is not initialized.");
+  }
+  uint8_t bus = (uint8_t)jerry_value_as_number(bus_value);
+  jerry_value_free(bus_value);
+
+  spi_request_t *req = malloc(sizeof(spi_request_t));
+  if (req == NULL) {
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  req->tx_buf = NULL;
+  req->tx_allocated = false;
+  req->data_js = jerry_undefined();
+  req->len = length;
+  req->rx_buf = malloc(length > 0 ? length : 1);
+  if (req->rx_buf == NULL) {
+    spi_request_free(req);
+    return jerry_exception_value(create_system_error(ENOMEM), true);
+  }
+  return spi_request_submit(bus, req);
+}
+
 /**
  * SPI.prototype.close() function
  */
@@ -270,7 +589,10 @@ JERRYXX_FUN(spi_close_fn) {
   uint8_t bus = (uint8_t)jerry_value_as_number(bus_value);
   jerry_value_free(bus_value);
 
-  // close the bus
+  // close the bus (after the transfer in progress)
+  spi_request_cancel(bus);
+  while (km_spi_transfer_busy(bus)) {
+  }
   int ret = km_spi_close(bus);
   if (ret < 0) {
     return jerry_exception_value(create_system_error(ret), true);
@@ -286,6 +608,10 @@ JERRYXX_FUN(spi_close_fn) {
  * Initialize 'spi' module
  */
 jerry_value_t module_spi_init() {
+  for (int i = 0; i < SPI_ASYNC_BUS_NUM; i++) {
+    spi_requests[i] = NULL;
+  }
+
   /* SPI class */
   jerry_value_t spi_ctor = jerry_function_external(spi_ctor_fn);
   jerry_value_t spi_prototype = jerry_object();
@@ -304,6 +630,12 @@ jerry_value_t module_spi_init() {
                                 spi_transfer_fn);
   jerryxx_set_property_function(spi_prototype, MSTR_SPI_SEND, spi_send_fn);
   jerryxx_set_property_function(spi_prototype, MSTR_SPI_RECV, spi_recv_fn);
+  jerryxx_set_property_function(spi_prototype, MSTR_SPI_TRANSFER_ASYNC,
+                                spi_transfer_async_fn);
+  jerryxx_set_property_function(spi_prototype, MSTR_SPI_SEND_ASYNC,
+                                spi_send_async_fn);
+  jerryxx_set_property_function(spi_prototype, MSTR_SPI_RECV_ASYNC,
+                                spi_recv_async_fn);
   jerryxx_set_property_function(spi_prototype, MSTR_SPI_CLOSE, spi_close_fn);
   jerry_value_free(spi_prototype);
 
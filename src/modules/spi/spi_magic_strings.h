@@ -32,6 +32,9 @@
 #define MSTR_SPI_TRANSFER "transfer"
 #define MSTR_SPI_SEND "send"
 #define MSTR_SPI_RECV "recv"
+#define MSTR_SPI_TRANSFER_ASYNC "transferAsync"
+#define MSTR_SPI_SEND_ASYNC "sendAsync"
+#define MSTR_SPI_RECV_ASYNC "recvAsync"
 #define MSTR_SPI_CLOSE "close"
 #define MSTR_SPI_MODE0 "MODE_0"
 #define MSTR_SPI_MODE1 "MODE_1"
@@ -34,6 +34,23 @@
 #define UART_DEFAULT_STOP 1
 #define UART_DEFAULT_FLOW KM_UART_FLOW_NONE
 #define UART_DEFAULT_BUFFERSIZE 2048
+#define UART_DEFAULT_BATCHSIZE 0
+#define UART_DEFAULT_BATCHTIMEOUT 5
+#define UART_DEFAULT_TXBUFFERSIZE 1024
+#define UART_DEFAULT_HIGHWATERMARK 512
+#define UART_POOL_SIZE 4
+
+/**
+ * UART io handle with a pool of receive arrays for the batch mode. A pooled
+ * Uint8Array of batchSize bytes is created once, handed to JS as is for a
+ * full batch and reused after release().
+ */
+typedef struct {
+  km_io_uart_handle_t base;
+  jerry_value_t pool[UART_POOL_SIZE];
+  bool pool_used[UART_POOL_SIZE];
+  jerry_value_t current;  // Uint8Array being filled
+} uart_handle_t;
 
 static int uart_available_cb(km_io_uart_handle_t *handle) {
   uint8_t port = handle->port;
@@ -41,6 +58,74 @@ static int uart_available_cb(km_io_uart_handle_t *handle) {
   return len;
 }
 
+static uint8_t *uart_array_data(jerry_value_t array) {
+  jerry_length_t byte_offset = 0;
+  jerry_length_t byte_length = 0;
+  jerry_value_t array_buffer =
+      jerry_typedarray_buffer(array, &byte_offset, &byte_length);
+  uint8_t *buf = jerry_arraybuffer_data(array_buffer) + byte_offset;
+  jerry_value_free(array_buffer);
+  return buf;
+}
+
+static uint8_t *uart_alloc_cb(km_io_uart_handle_t *handle, size_t len) {
+  uart_handle_t *uart = (uart_handle_t *)handle;
+  for (int i = 0; i < UART_POOL_SIZE; i++) {
+    if (!uart->pool_used[i]) {
+      if (jerry_value_is_undefined(uart->pool[i])) {
+        jerry_value_t array =
+            jerry_typedarray(JERRY_TYPEDARRAY_UINT8, handle->batch_size);
+        if (jerry_value_is_exception(array)) {
+          jerry_value_free(array);
+          break;
+        }
+        uart->pool[i] = array;
+      }
+      uart->pool_used[i] = true;
+      uart->current = jerry_value_copy(uart->pool[i]);
+      return uart_array_data(uart->current);
+    }
+  }
+  // all pooled arrays are held by JS, fallback to a new array
+  jerry_value_t array = jerry_typedarray(JERRY_TYPEDARRAY_UINT8, len);
+  if (jerry_value_is_exception(array)) {
+    jerry_value_free(array);
+    return NULL;  // keep the data in the ring buffer
+  }
+  uart->current = array;
+  return uart_array_data(uart->current);
+}
+
+static void uart_batch_read_cb(km_io_uart_handle_t *handle, uint8_t *buf,
+                               size_t len) {
+  uart_handle_t *uart = (uart_handle_t *)handle;
+  jerry_value_t array = uart->current;
+  uart->current = jerry_undefined();
+  if (jerry_typedarray_length(array) != len) {
+    // short batch (timeout), pass a view of the received bytes only
+    jerry_length_t byte_offset = 0;
+    jerry_length_t byte_length = 0;
+    jerry_value_t array_buffer =
+        jerry_typedarray_buffer(array, &byte_offset, &byte_length);
+    jerry_value_free(array);
+    array = jerry_typedarray_with_buffer_span(JERRY_TYPEDARRAY_UINT8,
+                                              array_buffer, byte_offset, len);
+    jerry_value_free(array_buffer);
+  }
+  if (jerry_value_is_function(handle->read_js_cb)) {
+    jerry_value_t this_val = jerry_undefined();
+    jerry_value_t args_p[1] = {array};
+    jerry_value_t ret_val =
+        jerry_call(handle->read_js_cb, this_val, args_p, 1);
+    if (jerry_value_is_error(ret_val)) {
+      jerryxx_print_error(ret_val, true);
+    }
+    jerry_value_free(ret_val);
+    jerry_value_free(this_val);
+  }
+  jerry_value_free(array);
+}
+
 static void uart_read_cb(km_io_uart_handle_t *handle, uint8_t *buf,
                          size_t len) {
   if (jerry_value_is_function(handle->read_js_cb)) {
@@ -62,7 +147,25 @@ static void uart_read_cb(km_io_uart_handle_t *handle, uint8_t *buf,
   }
 }
 
-static void uart_close_cb(km_io_handle_t *handle) { free(handle); }
+static void uart_drain_cb(km_io_uart_handle_t *handle) {
+  if (jerry_value_is_function(handle->drain_js_cb)) {
+    jerry_value_t this_val = jerry_undefined();
+    jerry_value_t ret_val = jerry_call(handle->drain_js_cb, this_val, NULL, 0);
+    if (jerry_value_is_error(ret_val)) {
+      jerryxx_print_error(ret_val, true);
+    }
+    jerry_value_free(ret_val);
+    jerry_value_free(this_val);
+  }
+}
+
+static void uart_close_cb(km_io_handle_t *handle) {
+  km_io_uart_handle_t *uart = (km_io_uart_handle_t *)handle;
+  if (uart->tx_buffer != NULL) {
+    free(uart->tx_buffer);
+  }
+  free(handle);
+}
 
 /**
  * uart_native constructor
@@ -70,11 +173,13 @@ static void uart_close_cb(km_io_handle_t *handle) { free(handle); }
  *   port {number}
  *   options {Object}
  *   callback (function(data))
+ *   drain {function()} called when the transmit queue becomes empty
  */
 JERRYXX_FUN(uart_ctor_fn) {
   JERRYXX_CHECK_ARG_NUMBER(0, "port");
   JERRYXX_CHECK_ARG_OBJECT(1, "options");
   JERRYXX_CHECK_ARG_FUNCTION(2, "callback");
+  JERRYXX_CHECK_ARG_FUNCTION_OPT(3, "drain");
 
   // read parameters
   uint8_t port = (uint8_t)JERRYXX_GET_ARG_NUMBER(0);
@@ -92,6 +197,21 @@ JERRYXX_FUN(uart_ctor_fn) {
                                                         UART_DEFAULT_FLOW);
   uint32_t buffer_size = (uint32_t)jerryxx_get_property_number(
       options, MSTR_UART_BUFFERSIZE, UART_DEFAULT_BUFFERSIZE);
+  uint32_t batch_size = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_UART_BATCHSIZE, UART_DEFAULT_BATCHSIZE);
+  uint32_t batch_timeout = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_UART_BATCHTIMEOUT, UART_DEFAULT_BATCHTIMEOUT);
+  uint32_t tx_buffer_size = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_UART_TXBUFFERSIZE, UART_DEFAULT_TXBUFFERSIZE);
+  uint32_t high_water_mark = (uint32_t)jerryxx_get_property_number(
+      options, MSTR_UART_HIGHWATERMARK, UART_DEFAULT_HIGHWATERMARK);
+  if (tx_buffer_size == 0) {
+    return jerry_error_sz(JERRY_ERROR_RANGE, "txBufferSize must be positive.");
+  }
+  if (batch_size > buffer_size) {
+    return jerry_error_sz(JERRY_ERROR_RANGE,
+                          "batchSize must not exceed bufferSize.");
+  }
   km_uart_pins_t def_pins = km_uart_get_default_pins(port);
   km_uart_pins_t pins;
   pins.tx =
@@ -118,6 +238,14 @@ JERRYXX_FUN(uart_ctor_fn) {
   jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_FLOW, flow);
   jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_BUFFERSIZE,
                               buffer_size);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_BATCHSIZE,
+                              batch_size);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_BATCHTIMEOUT,
+                              batch_timeout);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_TXBUFFERSIZE,
+                              tx_buffer_size);
+  jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_HIGHWATERMARK,
+                              high_water_mark);
   jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_TX, pins.tx);
   jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_RX, pins.rx);
   jerryxx_set_property_number(JERRYXX_GET_THIS, MSTR_UART_CTS, pins.cts);
@@ -125,15 +253,46 @@ JERRYXX_FUN(uart_ctor_fn) {
   jerryxx_set_property(JERRYXX_GET_THIS, "callback", callback);
 
   // setup io handle
-  km_io_uart_handle_t *handle = malloc(sizeof(km_io_uart_handle_t));
+  uart_handle_t *uart = malloc(sizeof(uart_handle_t));
+  km_io_uart_handle_t *handle = &uart->base;
   km_io_uart_init(handle);
+  for (int i = 0; i < UART_POOL_SIZE; i++) {
+    uart->pool[i] = jerry_undefined();
+    uart->pool_used[i] = false;
+  }
+  uart->current = jerry_undefined();
   handle->read_js_cb = jerry_value_copy(callback);
+  handle->drain_js_cb = JERRYXX_HAS_ARG(3)
+                            ? jerry_value_copy(JERRYXX_GET_ARG(3))
+                            : jerry_undefined();
+  ret = km_io_uart_write_start(handle, tx_buffer_size, high_water_mark,
+                               uart_drain_cb);
+  if (ret < 0) {
+    jerry_value_free(handle->read_js_cb);
+    jerry_value_free(handle->drain_js_cb);
+    free(uart);
+    km_uart_close(port);
+    return jerry_exception_value(create_system_error(ret), true);
+  }
   jerryxx_set_property_number(JERRYXX_GET_THIS, "handle_id", handle->base.id);
-  km_io_uart_read_start(handle, port, uart_available_cb, uart_read_cb);
+  if (batch_size > 0) {
+    km_io_uart_set_batch(handle, batch_size, batch_timeout, uart_alloc_cb);
+    km_io_uart_read_start(handle, port, uart_available_cb, uart_batch_read_cb);
+  } else {
+    km_io_uart_read_start(handle, port, uart_available_cb, uart_read_cb);
+  }
 
   return jerry_undefined();
 }
 
+/**
+ * UART.prototype.write() function
+ * args:
+ *   data {Uint8Array|string}
+ *   count {number}
+ * returns:
+ *   {boolean} false if the transmit queue is above the high water mark
+ */
 JERRYXX_FUN(uart_write_fn) {
   JERRYXX_CHECK_ARG(0, "data");
   JERRYXX_CHECK_ARG_NUMBER_OPT(1, "count");
@@ -150,11 +309,17 @@ JERRYXX_FUN(uart_write_fn) {
         JERRY_ERROR_REFERENCE,
         "UART port is not initialized.");
   }
-  uint8_t port = (uint8_t)jerry_value_as_number(port_value);
   jerry_value_free(port_value);
+  uint32_t handle_id =
+      jerryxx_get_property_number(JERRYXX_GET_THIS, "handle_id", 0);
+  km_io_uart_handle_t *handle = km_io_uart_get_by_id(handle_id);
+  if (handle == NULL) {
+    return jerry_error_sz(JERRY_ERROR_REFERENCE,
+                          "UART port is not initialized.");
+  }
 
-  // write data to the port
-  int ret = 0;
+  // queue data to the port
+  int ret = 1;
   if (jerry_value_is_typedarray(data) &&
       jerry_typedarray_type(data) ==
           JERRY_TYPEDARRAY_UINT8) { /* Uint8Array */
@@ -162,10 +327,9 @@ JERRYXX_FUN(uart_write_fn) {
     jerry_length_t byteOffset = 0;
     jerry_value_t array_buffer =
         jerry_typedarray_buffer(data, &byteOffset, &byteLength);
-    size_t len = jerry_arraybuffer_size(array_buffer);
-    uint8_t *buf = jerry_arraybuffer_data(array_buffer);
+    uint8_t *buf = jerry_arraybuffer_data(array_buffer) + byteOffset;
     for (int c = 0; c < count; c++) {
-      ret = km_uart_write(port, buf, len);
+      ret = km_io_uart_write(handle, buf, byteLength);
       if (ret < 0) break;
     }
     jerry_value_free(array_buffer);
@@ -174,7 +338,7 @@ JERRYXX_FUN(uart_write_fn) {
     uint8_t buf[len];
     jerryxx_string_to_ascii_char_buffer(data, buf, len);
     for (int c = 0; c < count; c++) {
-      ret = km_uart_write(port, buf, len);
+      ret = km_io_uart_write(handle, buf, len);
       if (ret < 0) break;
     }
   } else {
@@ -185,7 +349,71 @@ JERRYXX_FUN(uart_write_fn) {
   if (ret < 0)
     return jerry_exception_value(create_system_error(ret), true);
   else
-    return jerry_number(ret);
+    return jerry_boolean(ret > 0);
+}
+
+/**
+ * UART.prototype.release() function
+ * args:
+ *   data {Uint8Array} data received in the batch mode
+ */
+JERRYXX_FUN(uart_release_fn) {
+  JERRYXX_CHECK_ARG(0, "data");
+  jerry_value_t data = JERRYXX_GET_ARG(0);
+  if (!jerry_value_is_typedarray(data)) {
+    return jerry_error_sz(JERRY_ERROR_TYPE,
+                          "The data argument must be Uint8Array.");
+  }
+  uint32_t handle_id =
+      jerryxx_get_property_number(JERRYXX_GET_THIS, "handle_id", 0);
+  uart_handle_t *uart = (uart_handle_t *)km_io_uart_get_by_id(handle_id);
+  if (uart != NULL) {
+    uint8_t *buf = uart_array_data(data);
+    for (int i = 0; i < UART_POOL_SIZE; i++) {
+      if (!jerry_value_is_undefined(uart->pool[i]) &&
+          uart_array_data(uart->pool[i]) == buf) {
+        uart->pool_used[i] = false;
+        break;
+      }
+    }
+  }
+  return jerry_undefined();
+}
+
+/**
+ * UART.prototype.rxStats() function
+ * args:
+ *   reset {boolean} reset highWater and overflow
+ * returns:
+ *   {Object} statistics of the read buffer
+ */
+JERRYXX_FUN(uart_rx_stats_fn) {
+  JERRYXX_CHECK_ARG_BOOLEAN_OPT(0, "reset");
+  bool reset = JERRYXX_GET_ARG_BOOLEAN_OPT(0, false);
+
+  // check this.port
+  jerry_value_t port_value =
+      jerryxx_get_property(JERRYXX_GET_THIS, MSTR_UART_PORT);
+  if (!jerry_value_is_number(port_value)) {
+    jerry_value_free(port_value);
+    return jerry_error_sz(
+        JERRY_ERROR_REFERENCE,
+        "UART port is not initialized.");
+  }
+  uint8_t port = (uint8_t)jerry_value_as_number(port_value);
+  jerry_value_free(port_value);
+
+  km_uart_stats_t stats;
+  int ret = km_uart_get_stats(port, &stats, reset);
+  if (ret < 0) {
+    return jerry_exception_value(create_system_error(ret), true);
+  }
+  jerry_value_t obj = jerry_object();
+  jerryxx_set_property_number(obj, MSTR_UART_SIZE, stats.size);
+  jerryxx_set_property_number(obj, MSTR_UART_LENGTH, stats.length);
+  jerryxx_set_property_number(obj, MSTR_UART_HIGHWATER, stats.high_water);
+  jerryxx_set_property_number(obj, MSTR_UART_OVERFLOW, stats.overflow);
+  return obj;
 }
 
 /**
@@ -204,6 +432,14 @@ JERRYXX_FUN(uart_close_fn) {
   uint8_t port = (uint8_t)jerry_value_as_number(port_value);
   jerry_value_free(port_value);
 
+  // write out the transmit queue
+  uint32_t handle_id =
+      jerryxx_get_property_number(JERRYXX_GET_THIS, "handle_id", 0);
+  km_io_uart_handle_t *handle = km_io_uart_get_by_id(handle_id);
+  if (handle != NULL) {
+    km_io_uart_flush(handle);
+  }
+
   // close the port
   int ret = km_uart_close(port);
   if (ret < 0) {
@@ -214,11 +450,14 @@ JERRYXX_FUN(uart_close_fn) {
   jerryxx_delete_property(JERRYXX_GET_THIS, MSTR_UART_PORT);
 
   // close io handle
-  uint32_t handle_id =
-      jerryxx_get_property_number(JERRYXX_GET_THIS, "handle_id", 0);
-  km_io_uart_handle_t *handle = km_io_uart_get_by_id(handle_id);
   if (handle != NULL) {
+    uart_handle_t *uart = (uart_handle_t *)handle;
+    for (int i = 0; i < UART_POOL_SIZE; i++) {
+      jerry_value_free(uart->pool[i]);
+    }
+    jerry_value_free(uart->current);
     jerry_value_free(handle->read_js_cb);
+    jerry_value_free(handle->drain_js_cb);
     km_io_uart_read_stop(handle);
     km_io_handle_close((km_io_handle_t *)handle, uart_close_cb);
   }
@@ -236,6 +475,10 @@ jerry_value_t module_uart_init() {
   jerry_value_t uart_prototype = jerry_object();
   jerryxx_set_property(uart_ctor, "prototype", uart_prototype);
   jerryxx_set_property_function(uart_prototype, MSTR_UART_WRITE, uart_write_fn);
+  jerryxx_set_property_function(uart_prototype, MSTR_UART_RELEASE,
+                                uart_release_fn);
+  jerryxx_set_property_function(uart_prototype, MSTR_UART_RXSTATS,
+                                uart_rx_stats_fn);
   jerryxx_set_property_function(uart_prototype, MSTR_UART_CLOSE, uart_close_fn);
   jerry_value_free(uart_prototype);
 
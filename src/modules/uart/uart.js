@@ -7,6 +7,8 @@ function UART(port, options) {
   options = options || {};
   this._native = new uart_native.UART(port, options, function (data) {
     self.emit('data', data);
+  }, function () {
+    self.emit('drain');
   });
 }
 
@@ -15,7 +17,15 @@ UART.prototype = new EventEmitter();
 UART.prototype.constructor = UART;
 
 UART.prototype.write = function (data) {
-  this._native.write(data);
+  return this._native.write(data);
+}
+
+UART.prototype.release = function (data) {
+  this._native.release(data);
+}
+
+UART.prototype.rxStats = function (reset) {
+  return this._native.rxStats(reset);
 }
 
 UART.prototype.close = function () {
@@ -30,12 +30,22 @@
 #define MSTR_UART_STOP "stop"
 #define MSTR_UART_FLOW "flow"
 #define MSTR_UART_BUFFERSIZE "bufferSize"
+#define MSTR_UART_TXBUFFERSIZE "txBufferSize"
+#define MSTR_UART_HIGHWATERMARK "highWaterMark"
+#define MSTR_UART_BATCHSIZE "batchSize"
+#define MSTR_UART_BATCHTIMEOUT "batchTimeout"
 #define MSTR_UART_DATAEVENT "dataEvent"
 #define MSTR_UART_TX "tx"
 #define MSTR_UART_RX "rx"
 #define MSTR_UART_CTS "cts"
 #define MSTR_UART_RTS "rts"
 #define MSTR_UART_WRITE "write"
+#define MSTR_UART_RELEASE "release"
+#define MSTR_UART_RXSTATS "rxStats"
+#define MSTR_UART_SIZE "size"
+#define MSTR_UART_LENGTH "length"
+#define MSTR_UART_HIGHWATER "highWater"
+#define MSTR_UART_OVERFLOW "overflow"
 #define MSTR_UART_CLOSE "close"
 #define MSTR_UART_PARITY_NONE "PARITY_NONE"
 #define MSTR_UART_PARITY_ODD "PARITY_ODD"
@@ -25,6 +25,7 @@
 #include <string.h>
 #include <time.h>
 
+#include "blkdev.h"
 #include "diskio.h"
 #include "err.h"
 #include "io.h"
@@ -50,8 +51,12 @@ static void vfs_handle_freecb(void *handle, struct jerry_object_native_info_t *i
 static const jerry_object_native_info_t vfs_handle_info = {
     .free_cb = vfs_handle_freecb};
 
-static int blkdev_ioctl(jerry_value_t blkdev_js, int op, int arg) {
+static int blkdev_ioctl(vfs_fat_handle_t *vfs_handle, int op, int arg) {
   // km_tty_printf("blkdev_ioctl(%d, %d)\r\n", op, arg);
+  if (vfs_handle->blkdev != NULL) {
+    return vfs_handle->blkdev->ops->ioctl(vfs_handle->blkdev, op, arg);
+  }
+  jerry_value_t blkdev_js = vfs_handle->blkdev_js;
   jerry_value_t ioctl_js = jerryxx_get_property(blkdev_js, "ioctl");
   jerry_value_t op_js = jerry_number(op);
   jerry_value_t arg_js = jerry_number(arg);
@@ -109,9 +114,14 @@ DRESULT disk_read(void *drv,    /* [IN] Physical drive nmuber (0..) */
   }
   // get native vfs handle
   vfs_fat_handle_t *vfs_handle = (vfs_fat_handle_t *)drv;
-  int block_size = blkdev_ioctl(vfs_handle->blkdev_js, 5, 0);
+  // native block device: all sectors in a single call
+  if (vfs_handle->blkdev != NULL) {
+    int ret = vfs_handle->blkdev->ops->read(
+        vfs_handle->blkdev, sector, 0, buff, count * vfs_handle->block_size);
+    return (ret < 0) ? RES_ERROR : RES_OK;
+  }
   jerry_value_t arraybuffer = jerry_arraybuffer_external(
-    (uint8_t *)buff, count * block_size, NULL);
+    (uint8_t *)buff, count * vfs_handle->block_size, NULL);
   jerry_value_t buffer_js = jerry_typedarray_with_buffer(
       JERRY_TYPEDARRAY_UINT8, arraybuffer);
   jerry_value_t read_js = jerryxx_get_property(vfs_handle->blkdev_js, "read");
@@ -140,9 +150,14 @@ DRESULT disk_write(
   }
   // get native vfs handle
   vfs_fat_handle_t *vfs_handle = (vfs_fat_handle_t *)drv;
-  int block_size = blkdev_ioctl(vfs_handle->blkdev_js, 5, 0);
+  // native block device: all sectors in a single call
+  if (vfs_handle->blkdev != NULL) {
+    int ret = vfs_handle->blkdev->ops->write(
+        vfs_handle->blkdev, sector, 0, buff, count * vfs_handle->block_size);
+    return (ret < 0) ? RES_ERROR : RES_OK;
+  }
   jerry_value_t arraybuffer = jerry_arraybuffer_external(
-    (uint8_t *)buff, count * block_size, NULL);
+    (uint8_t *)buff, count * vfs_handle->block_size, NULL);
   jerry_value_t buffer_js = jerry_typedarray_with_buffer(
       JERRY_TYPEDARRAY_UINT8, arraybuffer);
   jerry_value_t write_js = jerryxx_get_property(vfs_handle->blkdev_js, "write");
@@ -173,19 +188,18 @@ DRESULT disk_ioctl(void *drv, /* [IN] Physical drive nmuber (0..) */
   switch (cmd) {
     int res;
     case CTRL_SYNC:
-      res = blkdev_ioctl(vfs_handle->blkdev_js, 3, 0);
+      res = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_SYNC, 0);
       if (res == 0) {
         ret = RES_OK;
       }
       break;
     case GET_SECTOR_COUNT:
-      res = blkdev_ioctl(vfs_handle->blkdev_js, 4, 0);
+      res = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_BLOCK_COUNT, 0);
       *(DWORD *)buff = (DWORD)res;
       ret = RES_OK;
       break;
     case GET_SECTOR_SIZE:
-      res = blkdev_ioctl(vfs_handle->blkdev_js, 5, 0);
-      *(WORD *)buff = (WORD)res;
+      *(WORD *)buff = (WORD)vfs_handle->block_size;
       ret = RES_OK;
       break;
     case GET_BLOCK_SIZE:
@@ -197,10 +211,12 @@ DRESULT disk_ioctl(void *drv, /* [IN] Physical drive nmuber (0..) */
       ret = RES_OK;
       break;
     case IOCTL_INIT:
-      res = blkdev_ioctl(vfs_handle->blkdev_js, 1, 0);
+      res = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_INIT, 0);
       if (res < 0) {
         break;
       }
+      vfs_handle->block_size =
+          blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_BLOCK_SIZE, 0);
       vfs_handle->status &= ~STA_NOINIT;
       *(DSTATUS *)buff = (DSTATUS)vfs_handle->status;
       ret = RES_OK;
@@ -251,8 +267,9 @@ JERRYXX_FUN(vfsfat_ctor_fn) {
       (vfs_fat_handle_t *)malloc(sizeof(vfs_fat_handle_t));
   vfs_fat_handle_init(vfs_handle);
   vfs_fat_handle_add(vfs_handle);
-  vfs_handle->blkdev_js = blkdev;
-  // jerry_value_copy(vfs_handle->blkdev_js);
+  vfs_handle->blkdev_js = jerry_value_copy(blkdev);
+  vfs_handle->blkdev = km_blkdev_get(blkdev);
+  vfs_handle->block_size = 0;
   vfs_handle->fat_fs = (FATFS *)malloc(sizeof(FATFS));
   vfs_handle->fat_fs->drv = (void *)vfs_handle;
   vfs_handle->status = STA_NOINIT;
@@ -269,8 +286,8 @@ JERRYXX_FUN(vfs_fat_mkfs_fn) {
   JERRYXX_GET_NATIVE_HANDLE(vfs_handle, vfs_fat_handle_t, vfs_handle_info);
 
   // initialize block device
-  blkdev_ioctl(vfs_handle->blkdev_js, 1, 0);
-  int32_t buff_size = blkdev_ioctl(vfs_handle->blkdev_js, 5, 0);
+  blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_INIT, 0);
+  int32_t buff_size = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_BLOCK_SIZE, 0);
   BYTE *buff = (BYTE *)malloc(sizeof(BYTE) * buff_size);
   // make fs (format)
   FRESULT ret = f_mkfs(vfs_handle->fat_fs, FM_ANY, 0, buff, buff_size);
@@ -290,7 +307,7 @@ JERRYXX_FUN(vfs_fat_mount_fn) {
   JERRYXX_GET_NATIVE_HANDLE(vfs_handle, vfs_fat_handle_t, vfs_handle_info);
 
   // initialize block device
-  blkdev_ioctl(vfs_handle->blkdev_js, 1, 0);
+  blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_INIT, 0);
 
   FRESULT ret = f_mount(vfs_handle->fat_fs);
   int err = ret_conversion(ret);
@@ -314,7 +331,7 @@ JERRYXX_FUN(vfs_fat_unmount_fn) {
   }
 
   // shutdown block device
-  blkdev_ioctl(vfs_handle->blkdev_js, 2, 0);
+  blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_SHUTDOWN, 0);
   return jerry_undefined();
 }
 
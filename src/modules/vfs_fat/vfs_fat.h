@@ -22,6 +22,7 @@
 #ifndef __VFSFAT_H
 #define __VFSFAT_H
 
+#include "blkdev.h"
 #include "diskio.h"
 #include "ff.h"
 #include "jerryscript.h"
@@ -61,6 +62,8 @@ struct vfs_fat_root_s {
 struct vfs_fat_handle_s {
   km_list_node_t base;
   jerry_value_t blkdev_js;
+  km_blkdev_t *blkdev;  // native block device, NULL if implemented in JS
+  uint32_t block_size;  // sector size, read on disk initialization
   km_list_t file_handles;
   FATFS *fat_fs;
   DSTATUS status;
@@ -23,6 +23,7 @@
 
 #include <stdlib.h>
 
+#include "blkdev.h"
 #include "err.h"
 #include "io.h"
 #include "jerryscript.h"
@@ -45,8 +46,12 @@ static void vfs_handle_freecb(void *handle, struct jerry_object_native_info_t *i
 static const jerry_object_native_info_t vfs_handle_info = {
     .free_cb = vfs_handle_freecb};
 
-static int blkdev_ioctl(jerry_value_t blkdev_js, int op, int arg) {
+static int blkdev_ioctl(vfs_lfs_handle_t *vfs_handle, int op, int arg) {
   // km_tty_printf("blkdev_ioctl(%d, %d)\r\n", op, arg);
+  if (vfs_handle->blkdev != NULL) {
+    return vfs_handle->blkdev->ops->ioctl(vfs_handle->blkdev, op, arg);
+  }
+  jerry_value_t blkdev_js = vfs_handle->blkdev_js;
   jerry_value_t ioctl_js = jerryxx_get_property(blkdev_js, "ioctl");
   jerry_value_t op_js = jerry_number(op);
   jerry_value_t arg_js = jerry_number(arg);
@@ -67,6 +72,12 @@ static int blkdev_ioctl(jerry_value_t blkdev_js, int op, int arg) {
 static int blkdev_read(const struct lfs_config *c, lfs_block_t block,
                        lfs_off_t off, void *buffer, lfs_size_t size) {
   vfs_lfs_handle_t *vfs_handle = (vfs_lfs_handle_t *)c->context;
+  // native block device
+  if (vfs_handle->blkdev != NULL) {
+    int ret = vfs_handle->blkdev->ops->read(vfs_handle->blkdev, block, off,
+                                            (uint8_t *)buffer, size);
+    return (ret < 0) ? LFS_ERR_IO : 0;
+  }
   // call blockdev.read(block, buffer, offset)
   // km_tty_printf("blkdev_read(lfs_config, %d, %d, buffer, %d)\r\n", block,
   // off, size);
@@ -92,6 +103,12 @@ static int blkdev_read(const struct lfs_config *c, lfs_block_t block,
 static int blkdev_prog(const struct lfs_config *c, lfs_block_t block,
                        lfs_off_t off, const void *buffer, lfs_size_t size) {
   vfs_lfs_handle_t *vfs_handle = (vfs_lfs_handle_t *)c->context;
+  // native block device
+  if (vfs_handle->blkdev != NULL) {
+    int ret = vfs_handle->blkdev->ops->write(vfs_handle->blkdev, block, off,
+                                             (const uint8_t *)buffer, size);
+    return (ret < 0) ? LFS_ERR_IO : 0;
+  }
   // call blockdev.write(block, buffer, offset)
   // km_tty_printf("blkdev_prog(lfs_config, %d, %d, buffer, %d)\r\n", block,
   // off, size);
@@ -117,15 +134,15 @@ static int blkdev_prog(const struct lfs_config *c, lfs_block_t block,
 static int blkdev_erase(const struct lfs_config *c, lfs_block_t block) {
   vfs_lfs_handle_t *vfs_handle = (vfs_lfs_handle_t *)c->context;
   // km_tty_printf("blkdev_erase(lfs_config, %d)\r\n", block);
-  blkdev_ioctl(vfs_handle->blkdev_js, 6, block);
-  return 0;
+  int ret = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_BLOCK_ERASE, block);
+  return (ret < 0) ? LFS_ERR_IO : 0;
 }
 
 static int blkdev_sync(const struct lfs_config *c) {
   vfs_lfs_handle_t *vfs_handle = (vfs_lfs_handle_t *)c->context;
   // km_tty_printf("blkdev_sync(lfs_config)\r\n");
-  blkdev_ioctl(vfs_handle->blkdev_js, 3, 0);
-  return 0;
+  int ret = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_SYNC, 0);
+  return (ret < 0) ? LFS_ERR_IO : 0;
 }
 
 /**
@@ -143,16 +160,17 @@ JERRYXX_FUN(vfslfs_ctor_fn) {
       (vfs_lfs_handle_t *)malloc(sizeof(vfs_lfs_handle_t));
   vfs_lfs_handle_init(vfs_handle);
   vfs_lfs_handle_add(vfs_handle);
-  vfs_handle->blkdev_js = blkdev;
-  // jerry_value_copy(vfs_handle->blkdev_js);
+  vfs_handle->blkdev_js = jerry_value_copy(blkdev);
+  vfs_handle->blkdev = km_blkdev_get(blkdev);
   vfs_handle->config.context = vfs_handle;
   vfs_handle->config.read = blkdev_read;
   vfs_handle->config.prog = blkdev_prog;
   vfs_handle->config.erase = blkdev_erase;
   vfs_handle->config.sync = blkdev_sync;
-  int block_count = blkdev_ioctl(vfs_handle->blkdev_js, 4, 0);
-  int block_size = blkdev_ioctl(vfs_handle->blkdev_js, 5, 0);
-  int unit_size = blkdev_ioctl(vfs_handle->blkdev_js, 7, 0);
+  int block_count =
+      blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_BLOCK_COUNT, 0);
+  int block_size = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_BLOCK_SIZE, 0);
+  int unit_size = blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_BUFFER_SIZE, 0);
   vfs_handle->config.read_size = unit_size;
   vfs_handle->config.prog_size = unit_size;
   vfs_handle->config.block_size = block_size;
@@ -182,7 +200,7 @@ JERRYXX_FUN(vfs_lfs_mkfs_fn) {
   JERRYXX_GET_NATIVE_HANDLE(vfs_handle, vfs_lfs_handle_t, vfs_handle_info);
 
   // initialize block device
-  blkdev_ioctl(vfs_handle->blkdev_js, 1, 0);
+  blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_INIT, 0);
 
   // make fs (format)
   int ret = lfs_format(&vfs_handle->lfs, &vfs_handle->config);
@@ -200,7 +218,7 @@ JERRYXX_FUN(vfs_lfs_mount_fn) {
   JERRYXX_GET_NATIVE_HANDLE(vfs_handle, vfs_lfs_handle_t, vfs_handle_info);
 
   // initialize block device
-  blkdev_ioctl(vfs_handle->blkdev_js, 1, 0);
+  blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_INIT, 0);
 
   // mount vfs
   int ret = lfs_mount(&vfs_handle->lfs, &vfs_handle->config);
@@ -224,7 +242,7 @@ JERRYXX_FUN(vfs_lfs_unmount_fn) {
   }
 
   // shutdown block device
-  blkdev_ioctl(vfs_handle->blkdev_js, 2, 0);
+  blkdev_ioctl(vfs_handle, KM_BLKDEV_IOCTL_SHUTDOWN, 0);
   return jerry_undefined();
 }
 
@@ -22,6 +22,7 @@
 #ifndef __VFSLFS_H
 #define __VFSLFS_H
 
+#include "blkdev.h"
 #include "jerryscript.h"
 #include "lfs.h"
 #include "utils.h"
@@ -57,6 +58,7 @@ struct vfs_lfs_handle_s {
   struct lfs_config config;
   km_list_t file_handles;
   jerry_value_t blkdev_js;
+  km_blkdev_t *blkdev;  // native block device, NULL if implemented in JS
 };
 
 struct vfs_lfs_file_handle_s {
@@ -1,10 +1,23 @@
 #include "ringbuffer.h"
 
+#include <string.h>
+
+/**
+ * Wrap a position less than (2 * length) into the buffer
+ */
+static inline uint32_t __wrap(ringbuffer_t *ringbuffer, uint32_t pos) {
+  if (ringbuffer->mask) {
+    return pos & ringbuffer->mask;
+  }
+  return (pos >= ringbuffer->length) ? pos - ringbuffer->length : pos;
+}
+
 void ringbuffer_init(ringbuffer_t *ringbuffer, uint8_t *buf, uint32_t len) {
   ringbuffer->r_ptr = 0;
   ringbuffer->w_ptr = 0;
   ringbuffer->buf = buf;
   ringbuffer->length = len;
+  ringbuffer->mask = (len > 0 && (len & (len - 1)) == 0) ? len - 1 : 0;
 }
 
 uint32_t ringbuffer_size(ringbuffer_t *ringbuffer) {
@@ -12,80 +25,102 @@ uint32_t ringbuffer_size(ringbuffer_t *ringbuffer) {
 }
 
 uint32_t ringbuffer_length(ringbuffer_t *ringbuffer) {
-  uint32_t len;
   uint32_t w_ptr = ringbuffer->w_ptr;
   uint32_t r_ptr = ringbuffer->r_ptr;
-  if (r_ptr <= w_ptr) {
-    len = w_ptr - r_ptr;
-  } else {
-    len = w_ptr - r_ptr + ringbuffer->length;
-  }
-  return len;
+  return __wrap(ringbuffer, w_ptr + ringbuffer->length - r_ptr);
 }
 
 uint32_t ringbuffer_freespace(ringbuffer_t *ringbuffer) {
-  return (ringbuffer->length - ringbuffer_length(ringbuffer));
+  return (ringbuffer->length - ringbuffer_length(ringbuffer) - 1);
 }
 
-void ringbuffer_read(ringbuffer_t *ringbuffer, uint8_t *buf, uint32_t len) {
-  uint32_t k;
-  uint32_t r_ptr;
-  r_ptr = ringbuffer->r_ptr;
-  for (k = 0; k < len; k++) {
-    buf[k] = ringbuffer->buf[r_ptr];
-    r_ptr = (r_ptr + 1) % ringbuffer->length;
+/**
+ * Copy len bytes from the position of the buffer (at most two memcpy)
+ */
+static void __copy_out(ringbuffer_t *ringbuffer, uint32_t pos, uint8_t *buf,
+                       uint32_t len) {
+  uint32_t first = ringbuffer->length - pos;
+  if (first > len) {
+    first = len;
   }
-  ringbuffer->r_ptr = r_ptr;
+  memcpy(buf, ringbuffer->buf + pos, first);
+  memcpy(buf + first, ringbuffer->buf, len - first);
+}
+
+void ringbuffer_read(ringbuffer_t *ringbuffer, uint8_t *buf, uint32_t len) {
+  uint32_t r_ptr = ringbuffer->r_ptr;
+  __copy_out(ringbuffer, r_ptr, buf, len);
+  ringbuffer->r_ptr = __wrap(ringbuffer, r_ptr + len);
 }
 
 void ringbuffer_write(ringbuffer_t *ringbuffer, uint8_t *buf, uint32_t len) {
-  uint32_t k;
-  uint32_t w_ptr;
-  w_ptr = ringbuffer->w_ptr;
-  for (k = 0; k < len; k++) {
-    ringbuffer->buf[w_ptr] = buf[k];
-    w_ptr = (w_ptr + 1) % ringbuffer->length;
+  uint32_t w_ptr = ringbuffer->w_ptr;
+  if (len > ringbuffer->length) {
+    // only the last bytes remain. They fill a whole lap from w_ptr, which
+    // keeps them in the order of a write from any position.
+    buf += len - ringbuffer->length;
+    len = ringbuffer->length;
   }
-  ringbuffer->w_ptr = w_ptr;
+  uint32_t first = ringbuffer->length - w_ptr;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(ringbuffer->buf + w_ptr, buf, first);
+  memcpy(ringbuffer->buf, buf + first, len - first);
+  ringbuffer->w_ptr = __wrap(ringbuffer, w_ptr + len);
 }
 
 uint8_t ringbuffer_look_at(ringbuffer_t *ringbuffer, uint32_t offset) {
-  uint32_t r_ptr;
-  r_ptr = ringbuffer->r_ptr;
-  r_ptr = (r_ptr + offset) % ringbuffer->length;
-  return ringbuffer->buf[r_ptr];
+  return ringbuffer->buf[__wrap(ringbuffer, ringbuffer->r_ptr + offset)];
 }
 
 void ringbuffer_look(ringbuffer_t *ringbuffer, uint8_t *buf, uint32_t len,
                      uint32_t offset) {
-  uint32_t k;
-  uint32_t r_ptr;
-  r_ptr = ringbuffer->r_ptr;
-  r_ptr = (r_ptr + offset) % ringbuffer->length;
-  for (k = 0; k < len; k++) {
-    buf[k] = ringbuffer->buf[r_ptr];
-    r_ptr = (r_ptr + 1) % ringbuffer->length;
-  }
+  __copy_out(ringbuffer, __wrap(ringbuffer, ringbuffer->r_ptr + offset), buf,
+             len);
 }
 
 void ringbuffer_flush(ringbuffer_t *ringbuffer, uint32_t len) {
-  uint32_t r_ptr;
-  r_ptr = ringbuffer->r_ptr;
-  r_ptr = (r_ptr + len) % ringbuffer->length;
-  ringbuffer->r_ptr = r_ptr;
+  ringbuffer->r_ptr = __wrap(ringbuffer, ringbuffer->r_ptr + len);
 }
 
 int ringbuffer_find(ringbuffer_t *ringbuffer, uint8_t ch) {
-  uint32_t pos = -1;
   uint32_t len = ringbuffer_length(ringbuffer);
-  uint32_t r_ptr;
-  r_ptr = ringbuffer->r_ptr % ringbuffer->length;
-  for (int n = 0; n < len; n++) {
-    if (ringbuffer->buf[r_ptr] == ch) {
-      pos = n;
-      break;
-    }
-    r_ptr = (r_ptr + 1) % ringbuffer->length;
+  uint32_t r_ptr = ringbuffer->r_ptr;
+  uint32_t first = ringbuffer->length - r_ptr;
+  if (first > len) {
+    first = len;
   }
-  return pos;
+  uint8_t *p = memchr(ringbuffer->buf + r_ptr, ch, first);
+  if (p != NULL) {
+    return p - (ringbuffer->buf + r_ptr);
+  }
+  p = memchr(ringbuffer->buf, ch, len - first);
+  if (p != NULL) {
+    return first + (p - ringbuffer->buf);
+  }
+  return -1;
+}
+
+uint32_t ringbuffer_peek(ringbuffer_t *ringbuffer, uint8_t **region) {
+  uint32_t r_ptr = ringbuffer->r_ptr;
+  uint32_t w_ptr = ringbuffer->w_ptr;
+  *region = ringbuffer->buf + r_ptr;
+  return (r_ptr <= w_ptr) ? w_ptr - r_ptr : ringbuffer->length - r_ptr;
+}
+
+uint32_t ringbuffer_reserve(ringbuffer_t *ringbuffer, uint8_t **region) {
+  uint32_t r_ptr = ringbuffer->r_ptr;
+  uint32_t w_ptr = ringbuffer->w_ptr;
+  *region = ringbuffer->buf + w_ptr;
+  if (w_ptr < r_ptr) {
+    return r_ptr - w_ptr - 1;
+  }
+  // keep one byte empty when the region reaches the end of buffer and the
+  // read position is at the start
+  return ringbuffer->length - w_ptr - (r_ptr == 0 ? 1 : 0);
+}
+
+void ringbuffer_commit(ringbuffer_t *ringbuffer, uint32_t len) {
+  ringbuffer->w_ptr = __wrap(ringbuffer, ringbuffer->w_ptr + len);
 }
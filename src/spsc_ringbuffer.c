@@ -0,0 +1,142 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "spsc_ringbuffer.h"
+
+#include <string.h>
+
+/*
+ * head and tail are free-running counters. The producer publishes data by
+ * storing head with release order after filling the buffer, and the
+ * consumer releases space by storing tail after copying data out. The
+ * acquire loads on the other side make the buffer contents visible.
+ */
+
+void spsc_ringbuffer_init(spsc_ringbuffer_t *ringbuffer, uint8_t *buf,
+                          uint32_t size) {
+  ringbuffer->buf = buf;
+  ringbuffer->size = size;
+  ringbuffer->mask = size - 1;
+  ringbuffer->head = 0;
+  ringbuffer->tail = 0;
+  ringbuffer->overflow = 0;
+  ringbuffer->high_water = 0;
+}
+
+uint32_t spsc_ringbuffer_length(spsc_ringbuffer_t *ringbuffer) {
+  uint32_t head = __atomic_load_n(&ringbuffer->head, __ATOMIC_ACQUIRE);
+  uint32_t tail = __atomic_load_n(&ringbuffer->tail, __ATOMIC_ACQUIRE);
+  return head - tail;
+}
+
+static void __update_high_water(spsc_ringbuffer_t *ringbuffer,
+                                uint32_t length) {
+  if (length > ringbuffer->high_water) {
+    __atomic_store_n(&ringbuffer->high_water, length, __ATOMIC_RELAXED);
+  }
+}
+
+bool spsc_ringbuffer_put(spsc_ringbuffer_t *ringbuffer, uint8_t ch) {
+  uint32_t head = ringbuffer->head;
+  uint32_t tail = __atomic_load_n(&ringbuffer->tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= ringbuffer->size) {
+    __atomic_store_n(&ringbuffer->overflow, ringbuffer->overflow + 1,
+                     __ATOMIC_RELAXED);
+    return false;
+  }
+  ringbuffer->buf[head & ringbuffer->mask] = ch;
+  __atomic_store_n(&ringbuffer->head, head + 1, __ATOMIC_RELEASE);
+  __update_high_water(ringbuffer, head + 1 - tail);
+  return true;
+}
+
+uint32_t spsc_ringbuffer_write(spsc_ringbuffer_t *ringbuffer,
+                               const uint8_t *buf, uint32_t len) {
+  uint32_t head = ringbuffer->head;
+  uint32_t tail = __atomic_load_n(&ringbuffer->tail, __ATOMIC_ACQUIRE);
+  uint32_t space = ringbuffer->size - (head - tail);
+  uint32_t n = (len < space) ? len : space;
+  if (n < len) {
+    __atomic_store_n(&ringbuffer->overflow, ringbuffer->overflow + (len - n),
+                     __ATOMIC_RELAXED);
+  }
+  uint32_t pos = head & ringbuffer->mask;
+  uint32_t first = ringbuffer->size - pos;
+  if (first > n) {
+    first = n;
+  }
+  memcpy(ringbuffer->buf + pos, buf, first);
+  memcpy(ringbuffer->buf, buf + first, n - first);
+  __atomic_store_n(&ringbuffer->head, head + n, __ATOMIC_RELEASE);
+  __update_high_water(ringbuffer, head + n - tail);
+  return n;
+}
+
+uint32_t spsc_ringbuffer_read(spsc_ringbuffer_t *ringbuffer, uint8_t *buf,
+                              uint32_t len) {
+  uint32_t tail = ringbuffer->tail;
+  uint32_t head = __atomic_load_n(&ringbuffer->head, __ATOMIC_ACQUIRE);
+  uint32_t n = head - tail;
+  if (n > len) {
+    n = len;
+  }
+  uint32_t pos = tail & ringbuffer->mask;
+  uint32_t first = ringbuffer->size - pos;
+  if (first > n) {
+    first = n;
+  }
+  memcpy(buf, ringbuffer->buf + pos, first);
+  memcpy(buf + first, ringbuffer->buf, n - first);
+  __atomic_store_n(&ringbuffer->tail, tail + n, __ATOMIC_RELEASE);
+  return n;
+}
+
+uint32_t spsc_ringbuffer_peek(spsc_ringbuffer_t *ringbuffer,
+                              uint8_t **region) {
+  uint32_t tail = ringbuffer->tail;
+  uint32_t head = __atomic_load_n(&ringbuffer->head, __ATOMIC_ACQUIRE);
+  uint32_t pos = tail & ringbuffer->mask;
+  uint32_t n = head - tail;
+  if (n > ringbuffer->size - pos) {
+    n = ringbuffer->size - pos;
+  }
+  *region = ringbuffer->buf + pos;
+  return n;
+}
+
+void spsc_ringbuffer_flush(spsc_ringbuffer_t *ringbuffer, uint32_t len) {
+  __atomic_store_n(&ringbuffer->tail, ringbuffer->tail + len,
+                   __ATOMIC_RELEASE);
+}
+
+uint32_t spsc_ringbuffer_overflow(spsc_ringbuffer_t *ringbuffer) {
+  return __atomic_load_n(&ringbuffer->overflow, __ATOMIC_RELAXED);
+}
+
+uint32_t spsc_ringbuffer_high_water(spsc_ringbuffer_t *ringbuffer) {
+  return __atomic_load_n(&ringbuffer->high_water, __ATOMIC_RELAXED);
+}
+
+void spsc_ringbuffer_reset_stats(spsc_ringbuffer_t *ringbuffer) {
+  __atomic_store_n(&ringbuffer->overflow, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&ringbuffer->high_water, spsc_ringbuffer_length(ringbuffer),
+                   __ATOMIC_RELAXED);
+}
@@ -0,0 +1,363 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * Micro-benchmark of the graphics primitives. Compares the pixel-at-a-time
+ * drawing (as before the span kernels) with the 16-bit and 1-bit kernels in
+ * src/modules/graphics, and checks both produce the same buffer in all
+ * rotations. Also checks a recorded frame drawn strip by strip (strip mode)
+ * gives the same pixels as drawn into the whole buffer.
+ *
+ *   $ cmake .. -DTARGET=linux
+ *   $ make graphics_bench && ./graphics_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gc.h"
+#include "gc_16bit_prims.h"
+#include "gc_dlist.h"
+#include "gc_1bit_prims.h"
+
+#define BENCH_TOTAL (256 * 1024 * 1024)  // pixels to draw per case
+
+/* pixel-at-a-time implementations for comparison */
+
+static void legacy_16bit_fill_rect(gc_handle_t *handle, int16_t x, int16_t y,
+                                   int16_t w, int16_t h, uint16_t color) {
+  for (int16_t i = x; i < x + w; i++) {
+    for (int16_t j = y; j < y + h; j++) {
+      gc_prim_16bit_set_pixel(handle, i, j, color);
+    }
+  }
+}
+
+static void legacy_1bit_fill_rect(gc_handle_t *handle, int16_t x, int16_t y,
+                                  int16_t w, int16_t h, uint16_t color) {
+  for (int16_t i = x; i < x + w; i++) {
+    for (int16_t j = y; j < y + h; j++) {
+      gc_prim_1bit_set_pixel(handle, i, j, color);
+    }
+  }
+}
+
+typedef void (*bench_fill_t)(gc_handle_t *, int16_t, int16_t, int16_t,
+                             int16_t, uint16_t);
+
+static double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* set up a handle as the GraphicsContext constructor does */
+static void init_handle(gc_handle_t *handle, uint8_t *buffer, uint8_t bpp,
+                        int16_t width, int16_t height, uint8_t rotation,
+                        bool legacy) {
+  memset(handle, 0, sizeof(gc_handle_t));
+  handle->device_width = width;
+  handle->device_height = height;
+  handle->bpp = bpp;
+  handle->buffer = buffer;
+  handle->font_scale_x = 1;
+  handle->font_scale_y = 1;
+  handle->buffer_height = height;
+  if (bpp == 1) {
+    handle->buffer_size = width * height / 8;
+    handle->set_pixel_cb = gc_prim_1bit_set_pixel;
+    handle->fill_rect_cb =
+        legacy ? legacy_1bit_fill_rect : gc_prim_1bit_fill_rect;
+    handle->draw_bits_cb = legacy ? NULL : gc_prim_1bit_draw_bits;
+  } else {
+    handle->buffer_size = width * height * 2;
+    handle->set_pixel_cb = gc_prim_16bit_set_pixel;
+    handle->fill_rect_cb =
+        legacy ? legacy_16bit_fill_rect : gc_prim_16bit_fill_rect;
+  }
+  gc_set_rotation(handle, rotation);
+}
+
+static size_t buffer_size(uint8_t bpp, int16_t width, int16_t height) {
+  return bpp == 1 ? width * height / 8 : width * height * 2;
+}
+
+static double bench_fill(uint8_t bpp, int16_t width, int16_t height,
+                         bool legacy, uint8_t rotation, int16_t w, int16_t h) {
+  uint8_t *buffer = malloc(buffer_size(bpp, width, height));
+  gc_handle_t handle;
+  init_handle(&handle, buffer, bpp, width, height, rotation, legacy);
+  uint64_t total = 0;
+  uint16_t color = 0;
+  double start = now_sec();
+  while (total < BENCH_TOTAL) {
+    handle.fill_rect_cb(&handle, 3, 5, w, h, color++);
+    total += (uint64_t)w * h;
+  }
+  double elapsed = now_sec() - start;
+  free(buffer);
+  return total / elapsed;
+}
+
+static double bench_text(bool legacy, uint8_t rotation) {
+  uint8_t *buffer = malloc(128 * 64 / 8);
+  gc_handle_t handle;
+  init_handle(&handle, buffer, 1, 128, 64, rotation, legacy);
+  const char *text = "Hello, world! 0123456789";
+  uint64_t total = 0;
+  uint16_t color = 0;
+  double start = now_sec();
+  while (total < BENCH_TOTAL / 16) {
+    handle.font_color = color++ & 1;
+    gc_draw_text(&handle, 1, 3, text);
+    total += strlen(text) * 6 * 8;
+  }
+  double elapsed = now_sec() - start;
+  free(buffer);
+  return total / elapsed;
+}
+
+static double bench_bitmap(bool legacy, uint8_t rotation) {
+  uint8_t *buffer = malloc(128 * 64 / 8);
+  gc_handle_t handle;
+  init_handle(&handle, buffer, 1, 128, 64, rotation, legacy);
+  uint8_t bitmap[6 * 48 + 1];  // 48x48, 1 spare byte after the last row
+  for (int i = 0; i < (int)sizeof(bitmap); i++) {
+    bitmap[i] = rand();
+  }
+  uint64_t total = 0;
+  uint16_t color = 0;
+  double start = now_sec();
+  while (total < BENCH_TOTAL / 16) {
+    gc_draw_bitmap(&handle, 5, 3, bitmap, 48, 48, 1, color++ & 1, false, 0,
+                   1, 1, false, false);
+    total += 48 * 48;
+  }
+  double elapsed = now_sec() - start;
+  free(buffer);
+  return total / elapsed;
+}
+
+/* draw random shapes, partly off-screen, with both implementations */
+static int check(uint8_t bpp, int16_t width, int16_t height,
+                 uint8_t rotation) {
+  size_t size = buffer_size(bpp, width, height);
+  uint8_t *a = calloc(1, size + 1);
+  uint8_t *b = calloc(1, size + 1);
+  gc_handle_t ha, hb;
+  init_handle(&ha, a, bpp, width, height, rotation, true);
+  init_handle(&hb, b + 1, bpp, width, height, rotation, false);  // unaligned
+  uint8_t bitmap[26 * 95 + 1];  // 11x13 glyphs, 1 spare byte after the last
+  gc_font_t font = {bitmap, NULL, 32, 126, 11, 13, 12, 14};
+  srand(rotation + bpp);
+  for (int i = 0; i < (int)sizeof(bitmap); i++) {
+    bitmap[i] = rand();
+  }
+  for (int n = 0; n < 2000; n++) {
+    int16_t x = rand() % (width + 160) - 80;
+    int16_t y = rand() % (height + 160) - 80;
+    int16_t w = rand() % (width + 60) - 10;
+    int16_t h = rand() % (height + 60) - 10;
+    uint16_t color = rand();
+    switch (n % 6) {
+      case 0:
+        ha.fill_rect_cb(&ha, x, y, w, 1, color);
+        hb.fill_rect_cb(&hb, x, y, w, 1, color);
+        break;
+      case 1:
+        ha.fill_rect_cb(&ha, x, y, 1, h, color);
+        hb.fill_rect_cb(&hb, x, y, 1, h, color);
+        break;
+      case 2:
+        ha.fill_rect_cb(&ha, x, y, w, h, color);
+        hb.fill_rect_cb(&hb, x, y, w, h, color);
+        break;
+      case 3:
+        w = rand() % 40 + 1;
+        h = rand() % 100 + 1;
+        gc_draw_bitmap(&ha, x, y, bitmap, w, h, 1, color & 1, false, 0, 1, 1,
+                       false, false);
+        gc_draw_bitmap(&hb, x, y, bitmap, w, h, 1, color & 1, false, 0, 1, 1,
+                       false, false);
+        break;
+      case 4:
+        ha.font_color = hb.font_color = color & 1;
+        gc_draw_text(&ha, x, y, "Kaluma 1.3");
+        gc_draw_text(&hb, x, y, "Kaluma 1.3");
+        break;
+      case 5:
+        ha.font = hb.font = &font;
+        gc_draw_char(&ha, x, y, 32 + color % 95);
+        gc_draw_char(&hb, x, y, 32 + color % 95);
+        ha.font = hb.font = NULL;
+        break;
+    }
+  }
+  int ok = memcmp(a, b + 1, size) == 0;
+  free(a);
+  free(b);
+  return ok;
+}
+
+/* record random drawing calls, then draw them into the whole buffer and
+   strip by strip */
+static int check_strips(uint8_t bpp, int16_t width, int16_t height,
+                        uint8_t rotation, int16_t rows) {
+  size_t size = buffer_size(bpp, width, height);
+  size_t strip_size = buffer_size(bpp, width, rows);
+  uint8_t *a = calloc(1, size);
+  uint8_t *b = calloc(1, strip_size);
+  gc_handle_t ha, hb;
+  init_handle(&ha, a, bpp, width, height, rotation, false);
+  init_handle(&hb, b, bpp, width, height, rotation, false);
+  hb.buffer_size = strip_size;
+  gc_handle_t *handles[] = {&ha, &hb};
+  for (int i = 0; i < 2; i++) {
+    gc_handle_t *handle = handles[i];
+    handle->get_pixel_cb =
+        bpp == 1 ? gc_prim_1bit_get_pixel : gc_prim_16bit_get_pixel;
+    handle->draw_hline_cb =
+        bpp == 1 ? gc_prim_1bit_draw_hline : gc_prim_16bit_draw_hline;
+    handle->draw_vline_cb =
+        bpp == 1 ? gc_prim_1bit_draw_vline : gc_prim_16bit_draw_vline;
+    handle->fill_screen_cb =
+        bpp == 1 ? gc_prim_1bit_fill_screen : gc_prim_16bit_fill_screen;
+  }
+  uint8_t bitmap[40 * 100];
+  uint8_t *bitmap_p = bitmap;
+  srand(rotation + bpp + rows);
+  for (int i = 0; i < (int)sizeof(bitmap); i++) {
+    bitmap[i] = rand();
+  }
+  gc_dlist_t *dlist = gc_dlist_new(&ha);
+  int16_t fill[] = {0x1234};
+  gc_dlist_push(dlist, GC_OP_FILL_SCREEN, fill, 1, NULL, 0);
+  for (int n = 0; n < 500; n++) {
+    int16_t a[GC_DLIST_MAX_ARGS];
+    for (int i = 0; i < GC_DLIST_MAX_ARGS; i++) {
+      a[i] = rand() % (width + height) - 40;
+    }
+    uint16_t color = rand();
+    switch (n % 8) {
+      case 0:
+        a[0] = color;
+        gc_dlist_push(dlist, GC_OP_SET_COLOR, a, 1, NULL, 0);
+        gc_dlist_push(dlist, GC_OP_SET_FILL_COLOR, a, 1, NULL, 0);
+        gc_dlist_push(dlist, GC_OP_FILL_RECT, a + 2, 4, NULL, 0);
+        break;
+      case 1:
+        gc_dlist_push(dlist, GC_OP_DRAW_LINE, a, 4, NULL, 0);
+        break;
+      case 2:
+        a[2] %= 60;
+        gc_dlist_push(dlist, GC_OP_FILL_CIRCLE, a, 3, NULL, 0);
+        break;
+      case 3:
+        a[4] %= 20;
+        gc_dlist_push(dlist, GC_OP_DRAW_ROUNDRECT, a, 5, NULL, 0);
+        break;
+      case 4:
+        a[2] = color;
+        gc_dlist_push(dlist, GC_OP_SET_PIXEL, a, 3, NULL, 0);
+        break;
+      case 5:
+        a[0] = color;
+        gc_dlist_push(dlist, GC_OP_SET_FONT_COLOR, a, 1, NULL, 0);
+        gc_dlist_push(dlist, GC_OP_DRAW_TEXT, a + 1, 2, "Kaluma 1.3", 11);
+        break;
+      case 6: {
+        int16_t b[] = {a[0], a[1], rand() % 40 + 1, rand() % 100 + 1, 1,
+                       (int16_t)(color & 1), 0, 0, 1, 1, 0, 0};
+        gc_dlist_push(dlist, GC_OP_DRAW_BITMAP, b, 12, &bitmap_p,
+                      sizeof(bitmap_p));
+        break;
+      }
+      case 7:
+        a[0] = n / 8 % 4;
+        gc_dlist_push(dlist, GC_OP_SET_ROTATION, a, 1, NULL, 0);
+        break;
+    }
+  }
+  int ok = 1;
+  gc_dlist_replay(dlist, &ha);
+  for (int16_t y = 0; y < height; y += rows) {
+    hb.buffer_y = y;
+    hb.buffer_height = rows < height - y ? rows : height - y;
+    memset(b, 0, strip_size);
+    gc_dlist_replay(dlist, &hb);
+    size_t offset = buffer_size(bpp, width, y);
+    size_t length = buffer_size(bpp, width, hb.buffer_height);
+    ok = ok && memcmp(a + offset, b, length) == 0;
+  }
+  ok = ok && ha.color == hb.color && ha.rotation == hb.rotation;
+  gc_dlist_free(dlist);
+  free(a);
+  free(b);
+  return ok;
+}
+
+static void report(const char *name, double before, double after) {
+  printf("%-26s %10.1f Mpx/s %10.1f Mpx/s %6.1fx\n", name, before / 1e6,
+         after / 1e6, after / before);
+}
+
+int main() {
+  for (uint8_t r = 0; r < 4; r++) {
+    if (!check(16, 240, 320, r) || !check(1, 128, 64, r)) {
+      printf("rotation %d: buffers differ\n", r);
+      return 1;
+    }
+    if (!check_strips(16, 240, 320, r, 16) || !check_strips(16, 240, 320, r, 7) ||
+        !check_strips(1, 128, 64, r, 8) || !check_strips(1, 128, 64, r, 24)) {
+      printf("rotation %d: strips differ\n", r);
+      return 1;
+    }
+  }
+  printf("%-26s %17s %17s %7s\n", "", "pixel-at-a-time", "kernel", "");
+  report("16-bit fillScreen", bench_fill(16, 240, 320, true, 0, 240, 320),
+         bench_fill(16, 240, 320, false, 0, 240, 320));
+  report("16-bit fillRect 100x100", bench_fill(16, 240, 320, true, 0, 100, 100),
+         bench_fill(16, 240, 320, false, 0, 100, 100));
+  report("16-bit fillRect rot 1",
+         bench_fill(16, 240, 320, true, 1, 100, 100),
+         bench_fill(16, 240, 320, false, 1, 100, 100));
+  report("16-bit hline 200", bench_fill(16, 240, 320, true, 0, 200, 1),
+         bench_fill(16, 240, 320, false, 0, 200, 1));
+  report("16-bit vline 200", bench_fill(16, 240, 320, true, 0, 1, 200),
+         bench_fill(16, 240, 320, false, 0, 1, 200));
+  report("1-bit fillScreen", bench_fill(1, 128, 64, true, 0, 128, 64),
+         bench_fill(1, 128, 64, false, 0, 128, 64));
+  report("1-bit fillRect 50x30", bench_fill(1, 128, 64, true, 0, 50, 30),
+         bench_fill(1, 128, 64, false, 0, 50, 30));
+  report("1-bit fillRect rot 1", bench_fill(1, 128, 64, true, 1, 50, 30),
+         bench_fill(1, 128, 64, false, 1, 50, 30));
+  report("1-bit hline 100", bench_fill(1, 128, 64, true, 0, 100, 1),
+         bench_fill(1, 128, 64, false, 0, 100, 1));
+  report("1-bit drawBitmap 48x48", bench_bitmap(true, 0),
+         bench_bitmap(false, 0));
+  report("1-bit drawBitmap rot 1", bench_bitmap(true, 1),
+         bench_bitmap(false, 1));
+  report("1-bit text", bench_text(true, 0), bench_text(false, 0));
+  report("1-bit text rot 1", bench_text(true, 1), bench_text(false, 1));
+  return 0;
+}
@@ -0,0 +1,138 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * Micro-benchmark of the ring buffer. Compares the byte-at-a-time
+ * implementation (as before the memcpy rework) with src/ringbuffer.c.
+ *
+ *   $ cmake .. -DTARGET=linux
+ *   $ make ringbuffer_bench && ./ringbuffer_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+
+#define BENCH_TOTAL (64 * 1024 * 1024)
+
+/* byte-at-a-time implementation for comparison */
+
+static void legacy_read(ringbuffer_t *rb, uint8_t *buf, uint32_t len) {
+  uint32_t r_ptr = rb->r_ptr;
+  for (uint32_t k = 0; k < len; k++) {
+    buf[k] = rb->buf[r_ptr];
+    r_ptr = (r_ptr + 1) % rb->length;
+  }
+  rb->r_ptr = r_ptr;
+}
+
+static void legacy_write(ringbuffer_t *rb, uint8_t *buf, uint32_t len) {
+  uint32_t w_ptr = rb->w_ptr;
+  for (uint32_t k = 0; k < len; k++) {
+    rb->buf[w_ptr] = buf[k];
+    w_ptr = (w_ptr + 1) % rb->length;
+  }
+  rb->w_ptr = w_ptr;
+}
+
+static int legacy_find(ringbuffer_t *rb, uint8_t ch) {
+  uint32_t len = ringbuffer_length(rb);
+  uint32_t r_ptr = rb->r_ptr;
+  for (uint32_t n = 0; n < len; n++) {
+    if (rb->buf[r_ptr] == ch) {
+      return n;
+    }
+    r_ptr = (r_ptr + 1) % rb->length;
+  }
+  return -1;
+}
+
+typedef void (*bench_rw_t)(ringbuffer_t *, uint8_t *, uint32_t);
+typedef int (*bench_find_t)(ringbuffer_t *, uint8_t);
+
+static double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static volatile int sink;
+
+static double bench_rw(bench_rw_t wr, bench_rw_t rd, uint32_t size,
+                       uint32_t chunk) {
+  uint8_t *mem = malloc(size);
+  uint8_t src[chunk], dst[chunk];
+  memset(src, 0x55, chunk);
+  ringbuffer_t rb;
+  ringbuffer_init(&rb, mem, size);
+  double start = now_sec();
+  for (uint32_t n = 0; n < BENCH_TOTAL; n += chunk) {
+    wr(&rb, src, chunk);
+    rd(&rb, dst, chunk);
+    sink += dst[0];
+  }
+  double elapsed = now_sec() - start;
+  free(mem);
+  return BENCH_TOTAL / elapsed;
+}
+
+static double bench_find(bench_find_t find, uint32_t size) {
+  uint8_t *mem = malloc(size);
+  uint8_t data[size];
+  memset(data, 'a', size);
+  data[size - 2] = '\n';
+  ringbuffer_t rb;
+  ringbuffer_init(&rb, mem, size);
+  ringbuffer_write(&rb, data, size / 2);
+  ringbuffer_read(&rb, data, size / 2);
+  ringbuffer_write(&rb, data, size - 1);  // wrapped around
+  double start = now_sec();
+  uint64_t total = 0;
+  while (total < BENCH_TOTAL) {
+    int pos = find(&rb, '\n');
+    sink += pos;
+    total += pos + 1;
+  }
+  double elapsed = now_sec() - start;
+  free(mem);
+  return total / elapsed;
+}
+
+static void report(const char *name, double before, double after) {
+  printf("%-24s %10.1f MB/s %10.1f MB/s %6.1fx\n", name, before / 1e6,
+         after / 1e6, after / before);
+}
+
+int main() {
+  printf("%-24s %15s %15s %7s\n", "", "byte-at-a-time", "memcpy", "");
+  report("rw 2048/64", bench_rw(legacy_write, legacy_read, 2048, 64),
+         bench_rw(ringbuffer_write, ringbuffer_read, 2048, 64));
+  report("rw 2048/512", bench_rw(legacy_write, legacy_read, 2048, 512),
+         bench_rw(ringbuffer_write, ringbuffer_read, 2048, 512));
+  report("rw 2000/512 (no mask)", bench_rw(legacy_write, legacy_read, 2000, 512),
+         bench_rw(ringbuffer_write, ringbuffer_read, 2000, 512));
+  report("find 2048", bench_find(legacy_find, 2048),
+         bench_find(ringbuffer_find, 2048));
+  return 0;
+}
@@ -21,7 +21,35 @@
 
 #include "adc.h"
 
-#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "err.h"
+
+#define ADC_CAPTURE_MAX_RATE 500000
+#define ADC_CAPTURE_WAVE_HZ 1000
+#define ADC_CAPTURE_MAX 4095
+
+/**
+ * Free-running capture stand-in. A thread fills a buffer every block period
+ * with synthetic waveforms of ADC_CAPTURE_WAVE_HZ: channel 0 is a sine,
+ * 1 a square, 2 a triangle, 3 a sawtooth and 4 (temperature) a constant.
+ */
+typedef struct {
+  bool running;  // accessed atomically
+  pthread_t thread;
+  uint8_t channels[5];
+  uint8_t count;
+  uint32_t rate;
+  size_t block_size;
+  uint16_t *buf[2];
+  km_adc_capture_cb capture_cb;
+  void *arg;
+} __adc_capture_t;
+
+static __adc_capture_t __adc_capture = {.running = false};
 
 /**
  * Get ADC index
@@ -47,7 +75,7 @@ void km_adc_init() {}
 /**
  * Cleanup all ADC channels when system cleanup
  */
-void km_adc_cleanup() {}
+void km_adc_cleanup() { km_adc_capture_stop(); }
 
 /**
  * Read value from the ADC channel
@@ -57,6 +85,106 @@ void km_adc_cleanup() {}
  */
 double km_adc_read(uint8_t adcIndex) { return 0.0; }
 
-int km_adc_setup(uint8_t pin) { return 0; }
+uint16_t km_adc_read_u16(uint8_t adcIndex) { return 0; }
+
+/**
+ * Any pin is accepted as before. GPIO 26-30 are mapped to channels 0-4 as
+ * rp2 for the capture waveforms, other pins are channel 0.
+ */
+int km_adc_setup(uint8_t pin) {
+  if ((pin >= 26) && (pin <= 30)) {
+    return pin - 26;
+  }
+  return 0;
+}
 
 int km_adc_close(uint8_t pin) { return 0; }
+
+static uint16_t __adc_capture_wave(uint8_t channel, uint64_t frame,
+                                   uint32_t rate) {
+  double phase = fmod((double)frame * ADC_CAPTURE_WAVE_HZ / rate, 1.0);
+  switch (channel) {
+    case 0:
+      return (uint16_t)((sin(2 * M_PI * phase) + 1) / 2 * ADC_CAPTURE_MAX);
+    case 1:
+      return phase < 0.5 ? ADC_CAPTURE_MAX : 0;
+    case 2:
+      return (uint16_t)((phase < 0.5 ? phase * 2 : 2 - phase * 2) *
+                        ADC_CAPTURE_MAX);
+    case 3:
+      return (uint16_t)(phase * ADC_CAPTURE_MAX);
+    default:
+      return 876;  // 0.706V at 27 degrees
+  }
+}
+
+static void *__adc_capture_thread(void *data) {
+  __adc_capture_t *capture = (__adc_capture_t *)data;
+  size_t frames = capture->block_size / capture->count;
+  uint64_t period_ns = (uint64_t)frames * 1000000000 / capture->rate;
+  uint64_t frame = 0;
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  while (__atomic_load_n(&capture->running, __ATOMIC_ACQUIRE)) {
+    uint64_t nsec = next.tv_nsec + period_ns;
+    next.tv_sec += nsec / 1000000000;
+    next.tv_nsec = nsec % 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    if (!__atomic_load_n(&capture->running, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    uint16_t *filled = capture->buf[0];
+    if (filled != NULL) {
+      uint16_t *p = filled;
+      for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < capture->count; c++) {
+          *p++ = __adc_capture_wave(capture->channels[c], frame + i,
+                                    capture->rate);
+        }
+      }
+    }
+    frame += frames;
+    capture->buf[0] = capture->buf[1];
+    capture->buf[1] = capture->capture_cb(filled, capture->arg);
+  }
+  return NULL;
+}
+
+int km_adc_capture_start(const uint8_t *channels, uint8_t count, uint32_t rate,
+                         size_t block_size, uint16_t *buf0, uint16_t *buf1,
+                         km_adc_capture_cb capture_cb, void *arg) {
+  if (__adc_capture.running) {
+    return EBUSY;
+  }
+  if (count == 0 || count > 5 || rate == 0 || block_size == 0 ||
+      block_size % count != 0 ||
+      (uint64_t)rate * count > ADC_CAPTURE_MAX_RATE) {
+    return EINVAL;
+  }
+  for (int i = 0; i < count; i++) {
+    __adc_capture.channels[i] = channels[i];
+  }
+  __adc_capture.count = count;
+  __adc_capture.rate = rate;
+  __adc_capture.block_size = block_size;
+  __adc_capture.buf[0] = buf0;
+  __adc_capture.buf[1] = buf1;
+  __adc_capture.capture_cb = capture_cb;
+  __adc_capture.arg = arg;
+  __adc_capture.running = true;
+  if (pthread_create(&__adc_capture.thread, NULL, __adc_capture_thread,
+                     &__adc_capture) != 0) {
+    __adc_capture.running = false;
+    return ENOMEM;
+  }
+  return 0;
+}
+
+int km_adc_capture_stop() {
+  if (!__adc_capture.running) {
+    return 0;
+  }
+  __atomic_store_n(&__adc_capture.running, false, __ATOMIC_RELEASE);
+  pthread_join(__adc_capture.thread, NULL);
+  return 0;
+}
@@ -21,26 +21,80 @@
 
 #include "gpio.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
+#define GPIO_NUM 64
+#define GPIO_IRQ_FALLING 4  // as KM_IO_WATCH_MODE_FALLING
+#define GPIO_IRQ_RISING 8   // as KM_IO_WATCH_MODE_RISING
+
+/**
+ * There are no real pins. A written level is kept and read back, and a level
+ * change calls the irq callback of the pin as an edge interrupt, so edge
+ * watches and interrupts can be tested by writing the pin.
+ */
+static uint8_t __gpio_levels[GPIO_NUM];
+static uint8_t __gpio_irq_events[GPIO_NUM];
+static km_gpio_irq_callback_t __gpio_irq_cb = NULL;
+static bool __gpio_irq_enabled = false;
+
 void km_gpio_init() {}
 
-void km_gpio_cleanup() {}
+void km_gpio_cleanup() {
+  for (int i = 0; i < GPIO_NUM; i++) {
+    __gpio_levels[i] = KM_GPIO_LOW;
+    __gpio_irq_events[i] = 0;
+  }
+  __gpio_irq_enabled = false;
+}
 
 int km_gpio_set_io_mode(uint8_t pin, km_gpio_io_mode_t mode) { return 0; }
 
-int km_gpio_write(uint8_t pin, uint8_t value) { return 0; }
+int km_gpio_write(uint8_t pin, uint8_t value) {
+  if (pin >= GPIO_NUM) {
+    return 0;
+  }
+  uint8_t level = value ? KM_GPIO_HIGH : KM_GPIO_LOW;
+  if (__gpio_levels[pin] == level) {
+    return 0;
+  }
+  __gpio_levels[pin] = level;
+  uint8_t events = __gpio_irq_events[pin] &
+                   (level == KM_GPIO_HIGH ? GPIO_IRQ_RISING : GPIO_IRQ_FALLING);
+  if (events && __gpio_irq_enabled && __gpio_irq_cb != NULL) {
+    __gpio_irq_cb(pin, (km_gpio_io_mode_t)events);
+  }
+  return 0;
+}
 
-int km_gpio_read(uint8_t pin) { return 0; }
+int km_gpio_read(uint8_t pin) {
+  if (pin >= GPIO_NUM) {
+    return KM_GPIO_LOW;
+  }
+  return __gpio_levels[pin];
+}
 
-int km_gpio_toggle(uint8_t pin) { return 0; }
+int km_gpio_toggle(uint8_t pin) {
+  return km_gpio_write(pin, km_gpio_read(pin) == KM_GPIO_LOW);
+}
 
-void km_gpio_irq_set_callback(km_gpio_irq_callback_t cb) {}
+void km_gpio_irq_set_callback(km_gpio_irq_callback_t cb) { __gpio_irq_cb = cb; }
 
-int km_gpio_irq_attach(uint8_t pin, uint8_t events) { return 0; }
+int km_gpio_irq_attach(uint8_t pin, uint8_t events) {
+  if (pin < GPIO_NUM) {
+    __gpio_irq_events[pin] = events;
+    __gpio_irq_enabled = true;  // as the SDK enables the bank irq on attach
+  }
+  return 0;
+}
 
-int km_gpio_irq_detach(uint8_t pin) { return 0; }
+int km_gpio_irq_detach(uint8_t pin) {
+  if (pin < GPIO_NUM) {
+    __gpio_irq_events[pin] = 0;
+  }
+  return 0;
+}
 
-void km_gpio_irq_enable() {}
+void km_gpio_irq_enable() { __gpio_irq_enabled = true; }
 
-void km_gpio_irq_disable() {}
+void km_gpio_irq_disable() { __gpio_irq_enabled = false; }
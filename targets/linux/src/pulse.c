@@ -0,0 +1,226 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pulse.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "err.h"
+
+#define PULSE_NUM KM_PULSE_MAX
+#define PULSE_SLEEP_MAX_NS 10000000  // to check for stop while waiting
+
+/**
+ * Timer-thread stand-in for the pulse engines. There are no real pins, so
+ * the levels written by generators are kept here, and captures on the same
+ * pin see the edges timestamped at their exact deadlines.
+ */
+typedef struct {
+  bool used;
+  bool capture;
+  bool running;  // generator thread, accessed atomically
+  bool done;
+  bool started;  // capture reached the start state
+  uint8_t pin;
+  uint8_t start_state;
+  uint32_t *buf;
+  size_t length;
+  size_t count;
+  uint32_t timeout;
+  uint64_t last;  // usec of the last edge
+  pthread_t thread;
+} __pulse_t;
+
+static __pulse_t __pulse[PULSE_NUM];
+static pthread_mutex_t __pulse_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t __pulse_levels = 0;  // a bit for each pin
+
+static uint64_t __pulse_gettime() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static uint8_t __pulse_get_level(uint8_t pin) {
+  return (__pulse_levels >> (pin % 64)) & 1;
+}
+
+/**
+ * Set the level of a pin and record the edge to the captures on the pin.
+ * Called with the mutex locked.
+ */
+static void __pulse_set_level(uint8_t pin, uint8_t level, uint64_t time) {
+  if (__pulse_get_level(pin) == level) {
+    return;
+  }
+  __pulse_levels ^= (1ULL << (pin % 64));
+  for (int i = 0; i < PULSE_NUM; i++) {
+    __pulse_t *pulse = &__pulse[i];
+    if (!pulse->used || !pulse->capture || pulse->done || pulse->pin != pin) {
+      continue;
+    }
+    if (!pulse->started) {
+      pulse->started = (level == pulse->start_state);
+    } else {
+      pulse->buf[pulse->count++] = (uint32_t)(time - pulse->last);
+      pulse->done = (pulse->count == pulse->length);
+    }
+    pulse->last = time;
+  }
+}
+
+static void *__pulse_generate_thread(void *data) {
+  __pulse_t *pulse = (__pulse_t *)data;
+  uint64_t deadline = __pulse_gettime();
+  pthread_mutex_lock(&__pulse_mutex);
+  __pulse_set_level(pulse->pin, pulse->start_state ? 1 : 0, deadline);
+  pthread_mutex_unlock(&__pulse_mutex);
+  for (size_t i = 0; i < pulse->length; i++) {
+    deadline += pulse->buf[i];
+    uint64_t now = __pulse_gettime();
+    while (now < deadline &&
+           __atomic_load_n(&pulse->running, __ATOMIC_ACQUIRE)) {
+      uint64_t wait_ns = (deadline - now) * 1000;
+      struct timespec ts = {0, (long)(wait_ns < PULSE_SLEEP_MAX_NS
+                                          ? wait_ns
+                                          : PULSE_SLEEP_MAX_NS)};
+      nanosleep(&ts, NULL);
+      now = __pulse_gettime();
+    }
+    pthread_mutex_lock(&__pulse_mutex);
+    if (!__atomic_load_n(&pulse->running, __ATOMIC_ACQUIRE)) {
+      pthread_mutex_unlock(&__pulse_mutex);
+      return NULL;
+    }
+    __pulse_set_level(pulse->pin, !__pulse_get_level(pulse->pin), deadline);
+    pulse->count = i + 1;
+    pthread_mutex_unlock(&__pulse_mutex);
+  }
+  pthread_mutex_lock(&__pulse_mutex);
+  pulse->done = true;
+  pthread_mutex_unlock(&__pulse_mutex);
+  return NULL;
+}
+
+void km_pulse_init() {
+  for (int i = 0; i < PULSE_NUM; i++) {
+    __pulse[i].used = false;
+    __pulse[i].running = false;
+  }
+  __pulse_levels = 0;
+}
+
+void km_pulse_cleanup() {
+  for (int i = 0; i < PULSE_NUM; i++) {
+    km_pulse_stop(i);
+  }
+}
+
+static __pulse_t *__pulse_alloc(bool capture, uint8_t pin,
+                                uint8_t start_state, uint32_t *buf,
+                                size_t length) {
+  for (int i = 0; i < PULSE_NUM; i++) {
+    __pulse_t *pulse = &__pulse[i];
+    if (!pulse->used) {
+      pulse->capture = capture;
+      pulse->done = false;
+      pulse->pin = pin;
+      pulse->start_state = start_state;
+      pulse->buf = buf;
+      pulse->length = length;
+      pulse->count = 0;
+      pulse->used = true;
+      return pulse;
+    }
+  }
+  return NULL;
+}
+
+int km_pulse_capture_start(uint8_t pin, uint8_t start_state, uint32_t *buf,
+                           size_t length, uint32_t timeout) {
+  if (length == 0 || timeout == 0) {
+    return EINVAL;
+  }
+  pthread_mutex_lock(&__pulse_mutex);
+  __pulse_t *pulse = __pulse_alloc(true, pin, start_state, buf, length);
+  if (pulse != NULL) {
+    pulse->timeout = timeout;
+    pulse->started = (start_state == KM_PULSE_NO_STATE ||
+                      start_state == __pulse_get_level(pin));
+    pulse->last = __pulse_gettime();
+  }
+  pthread_mutex_unlock(&__pulse_mutex);
+  return (pulse != NULL) ? pulse - __pulse : EBUSY;
+}
+
+int km_pulse_generate_start(uint8_t pin, uint8_t start_state,
+                            const uint32_t *buf, size_t length) {
+  if (length == 0) {
+    return EINVAL;
+  }
+  pthread_mutex_lock(&__pulse_mutex);
+  __pulse_t *pulse =
+      __pulse_alloc(false, pin, start_state, (uint32_t *)buf, length);
+  pthread_mutex_unlock(&__pulse_mutex);
+  if (pulse == NULL) {
+    return EBUSY;
+  }
+  __atomic_store_n(&pulse->running, true, __ATOMIC_RELEASE);
+  if (pthread_create(&pulse->thread, NULL, __pulse_generate_thread, pulse) !=
+      0) {
+    pulse->running = false;
+    pulse->used = false;
+    return EBUSY;
+  }
+  return pulse - __pulse;
+}
+
+int km_pulse_status(uint8_t id) {
+  if (id >= PULSE_NUM || !__pulse[id].used) {
+    return EINVAL;
+  }
+  __pulse_t *pulse = &__pulse[id];
+  pthread_mutex_lock(&__pulse_mutex);
+  if (pulse->capture && !pulse->done &&
+      __pulse_gettime() - pulse->last > pulse->timeout) {
+    pulse->done = true;
+  }
+  int ret = pulse->done ? (int)pulse->count : EBUSY;
+  pthread_mutex_unlock(&__pulse_mutex);
+  return ret;
+}
+
+int km_pulse_stop(uint8_t id) {
+  if (id >= PULSE_NUM || !__pulse[id].used) {
+    return EINVAL;
+  }
+  __pulse_t *pulse = &__pulse[id];
+  if (!pulse->capture) {
+    __atomic_store_n(&pulse->running, false, __ATOMIC_RELEASE);
+    pthread_join(pulse->thread, NULL);
+  }
+  pthread_mutex_lock(&__pulse_mutex);
+  pulse->used = false;
+  pthread_mutex_unlock(&__pulse_mutex);
+  return 0;
+}
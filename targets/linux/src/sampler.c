@@ -0,0 +1,119 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sampler.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "err.h"
+
+#define SAMPLER_NUM 4
+
+/**
+ * Each sampling timer is a thread sleeping until absolute deadlines, so the
+ * period does not drift with the time spent in the tick callback.
+ */
+typedef struct {
+  bool used;
+  bool running;  // accessed atomically
+  pthread_t thread;
+  uint32_t period_us;
+  km_sampler_tick_cb tick_cb;
+  void *arg;
+} __sampler_status_t;
+
+static __sampler_status_t __sampler_status[SAMPLER_NUM];
+
+static void *__sampler_thread(void *data) {
+  __sampler_status_t *status = (__sampler_status_t *)data;
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  while (__atomic_load_n(&status->running, __ATOMIC_ACQUIRE)) {
+    next.tv_nsec += (long)status->period_us * 1000;
+    while (next.tv_nsec >= 1000000000) {
+      next.tv_nsec -= 1000000000;
+      next.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    if (!__atomic_load_n(&status->running, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    status->tick_cb(status->arg);
+  }
+  return NULL;
+}
+
+/**
+ * Initialize all sampling timers when system started
+ */
+void km_sampler_init() {
+  for (int i = 0; i < SAMPLER_NUM; i++) {
+    __sampler_status[i].used = false;
+    __sampler_status[i].running = false;
+  }
+}
+
+/**
+ * Stop all sampling timers when system cleanup
+ */
+void km_sampler_cleanup() {
+  for (int i = 0; i < SAMPLER_NUM; i++) {
+    if (__sampler_status[i].used) {
+      km_sampler_stop(i);
+    }
+  }
+}
+
+int km_sampler_start(uint32_t period_us, km_sampler_tick_cb tick_cb,
+                     void *arg) {
+  if (period_us == 0 || tick_cb == NULL) {
+    return EINVAL;
+  }
+  for (int i = 0; i < SAMPLER_NUM; i++) {
+    __sampler_status_t *status = &__sampler_status[i];
+    if (!status->used) {
+      status->period_us = period_us;
+      status->tick_cb = tick_cb;
+      status->arg = arg;
+      status->running = true;
+      if (pthread_create(&status->thread, NULL, __sampler_thread, status) !=
+          0) {
+        status->running = false;
+        return ENOMEM;
+      }
+      status->used = true;
+      return i;
+    }
+  }
+  return EBUSY;
+}
+
+int km_sampler_stop(uint8_t id) {
+  if (id >= SAMPLER_NUM || !__sampler_status[id].used) {
+    return EINVAL;
+  }
+  __atomic_store_n(&__sampler_status[id].running, false, __ATOMIC_RELEASE);
+  pthread_join(__sampler_status[id].thread, NULL);
+  __sampler_status[id].used = false;
+  return 0;
+}
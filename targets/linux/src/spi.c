@@ -21,8 +21,45 @@
 
 #include "spi.h"
 
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "err.h"
 #include "gpio.h"
 
+#define SPI_NUM 2
+
+/**
+ * Background transfers are completed by a worker thread after the time the
+ * transfer would take on the bus. There is no device attached, so MISO is
+ * looped back to MOSI.
+ */
+typedef struct {
+  uint32_t baudrate;
+  const uint8_t *tx_buf;
+  uint8_t *rx_buf;
+  size_t len;
+  bool busy;  // accessed atomically, cleared by the worker thread
+} __spi_transfer_t;
+
+static __spi_transfer_t __spi_transfer[SPI_NUM];
+
+static void *__spi_transfer_worker(void *arg) {
+  __spi_transfer_t *transfer = (__spi_transfer_t *)arg;
+  uint32_t baudrate = transfer->baudrate > 0 ? transfer->baudrate : 1000000;
+  usleep((useconds_t)(((uint64_t)transfer->len * 8 * 1000000) / baudrate));
+  if (transfer->rx_buf != NULL) {
+    if (transfer->tx_buf != NULL) {
+      memmove(transfer->rx_buf, transfer->tx_buf, transfer->len);
+    } else {
+      memset(transfer->rx_buf, 0xFF, transfer->len);
+    }
+  }
+  __atomic_store_n(&transfer->busy, false, __ATOMIC_RELEASE);
+  return NULL;
+}
+
 /**
  * Return default SPI pins. -1 means there is no default value on that pin.
  */
@@ -48,6 +85,9 @@ void km_spi_cleanup() {}
 int km_spi_setup(uint8_t bus, km_spi_mode_t mode, uint32_t baudrate,
                  km_spi_bitorder_t bitorder, km_spi_pins_t pins,
                  km_spi_pullup_t data_pullup) {
+  if (bus < SPI_NUM) {
+    __spi_transfer[bus].baudrate = baudrate;
+  }
   return 0;
 }
 
@@ -65,6 +105,40 @@ int km_spi_recv(uint8_t bus, uint8_t send_byte, uint8_t *buf, size_t len,
   return 0;
 }
 
-int km_set_spi_baudrate(uint8_t bus, uint32_t baudrate) { return 0; }
+int km_spi_transfer_async(uint8_t bus, const uint8_t *tx_buf, uint8_t *rx_buf,
+                          size_t len) {
+  if (bus >= SPI_NUM) {
+    return ENODEV;
+  }
+  __spi_transfer_t *transfer = &__spi_transfer[bus];
+  if (km_spi_transfer_busy(bus)) {
+    return EBUSY;
+  }
+  transfer->tx_buf = tx_buf;
+  transfer->rx_buf = rx_buf;
+  transfer->len = len;
+  __atomic_store_n(&transfer->busy, true, __ATOMIC_RELEASE);
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, __spi_transfer_worker, transfer) != 0) {
+    __atomic_store_n(&transfer->busy, false, __ATOMIC_RELEASE);
+    return EAGAIN;
+  }
+  pthread_detach(thread);
+  return 0;
+}
+
+bool km_spi_transfer_busy(uint8_t bus) {
+  if (bus >= SPI_NUM) {
+    return false;
+  }
+  return __atomic_load_n(&__spi_transfer[bus].busy, __ATOMIC_ACQUIRE);
+}
+
+int km_set_spi_baudrate(uint8_t bus, uint32_t baudrate) {
+  if (bus < SPI_NUM) {
+    __spi_transfer[bus].baudrate = baudrate;
+  }
+  return 0;
+}
 
 int km_spi_close(uint8_t bus) { return 0; }
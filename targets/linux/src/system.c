@@ -19,16 +19,21 @@
  * SOFTWARE.
  */
 
+#define _GNU_SOURCE
 #include "system.h"
 
+#include <poll.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "adc.h"
 #include "flash.h"
 #include "gpio.h"
 #include "i2c.h"
+#include "pulse.h"
 #include "pwm.h"
 #include "rtc.h"
+#include "sampler.h"
 #include "spi.h"
 #include "tty.h"
 #include "uart.h"
@@ -78,6 +83,16 @@ uint64_t km_micro_gettime() {
  */
 void km_micro_delay(uint32_t usec) {}
 
+/**
+ * Wait for input on stdin or until the timeout elapsed
+ */
+void km_wait_for_event(uint32_t timeout) {
+  struct pollfd fds[1] = {{.fd = STDIN_FILENO, .events = POLLIN}};
+  struct timespec tval = {.tv_sec = timeout / 1000,
+                          .tv_nsec = (timeout % 1000) * 1000000};
+  ppoll(fds, 1, &tval, NULL);
+}
+
 /**
  * Kaluma Hardware System Initializations
  */
@@ -90,9 +105,13 @@ void km_system_init() {
   km_uart_init();
   km_rtc_init();
   km_flash_init();
+  km_sampler_init();
+  km_pulse_init();
 }
 
 void km_system_cleanup() {
+  km_pulse_cleanup();
+  km_sampler_cleanup();
   km_adc_cleanup();
   km_pwm_cleanup();
   km_i2c_cleanup();
@@ -48,11 +48,16 @@ void km_tty_init() {
 }
 
 uint32_t km_tty_available() {
-  unsigned char ch[1];
-  int sz = read(STDIN_FILENO, ch, 1);
-  // printf("sz=%d\r\n", sz);
-  while (sz > 0) {
-    ringbuffer_write(&__tty_rx_ringbuffer, ch, 1);
+  // read stdin directly into the free space of the ring buffer
+  uint8_t *region;
+  uint32_t len = ringbuffer_reserve(&__tty_rx_ringbuffer, &region);
+  while (len > 0) {
+    int sz = read(STDIN_FILENO, region, len);
+    if (sz <= 0) {
+      break;
+    }
+    ringbuffer_commit(&__tty_rx_ringbuffer, sz);
+    len = ringbuffer_reserve(&__tty_rx_ringbuffer, &region);
   }
   return ringbuffer_length(&__tty_rx_ringbuffer);
 }
@@ -56,8 +56,26 @@ int km_uart_setup(uint8_t port, uint32_t baudrate, uint8_t bits,
 
 int km_uart_write(uint8_t port, uint8_t *buf, size_t len) { return 0; }
 
+int km_uart_write_async(uint8_t port, uint8_t *buf, size_t len) {
+  int ret = km_uart_write(port, buf, len);  // completed synchronously
+  if (ret < 0) {
+    return ret;
+  }
+  return 0;
+}
+
+bool km_uart_write_busy(uint8_t port) { return false; }
+
 uint32_t km_uart_available(uint8_t port) { return 0; }
 
 uint32_t km_uart_read(uint8_t port, uint8_t *buf, size_t len) { return 0; }
 
+int km_uart_get_stats(uint8_t port, km_uart_stats_t *stats, bool reset) {
+  stats->size = 0;
+  stats->length = 0;
+  stats->high_water = 0;
+  stats->overflow = 0;
+  return 0;
+}
+
 int km_uart_close(uint8_t port) { return 0; }
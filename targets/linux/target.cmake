@@ -25,6 +25,8 @@ if(NOT MODULES)
     i2c
     spi
     uart
+    sampler
+    pulse
     graphics
     at
     storage
@@ -63,6 +65,8 @@ set(SOURCES
   ${TARGET_SRC_DIR}/i2c.c
   ${TARGET_SRC_DIR}/spi.c
   ${TARGET_SRC_DIR}/rtc.c
+  ${TARGET_SRC_DIR}/sampler.c
+  ${TARGET_SRC_DIR}/pulse.c
   ${TARGET_SRC_DIR}/main.c
   ${BOARD_DIR}/board.c)
 
@@ -85,7 +89,7 @@ set(CMAKE_CXX_COMPILER ${PREFIX}g++)
 set(CMAKE_LINKER ${PREFIX}ld)
 set(CMAKE_OBJCOPY ${PREFIX}objcopy)
 
-set(TARGET_LIBS c m)
+set(TARGET_LIBS c m pthread)
 # set(CMAKE_EXE_LINKER_FLAGS "-u -Wl")
 
 include(${CMAKE_SOURCE_DIR}/tools/kaluma.cmake)
@@ -99,3 +103,17 @@ target_link_libraries(${OUTPUT_TARGET} ${JERRY_LIBS} ${TARGET_LIBS})
 #   DEPENDS ${OUTPUT_TARGET}.elf)
 
 # add_custom_target(kaluma ALL DEPENDS ${OUTPUT_TARGET}.hex ${OUTPUT_TARGET}.bin)
+
+# micro-benchmarks (not built by default)
+add_executable(ringbuffer_bench EXCLUDE_FROM_ALL
+  ${CMAKE_CURRENT_LIST_DIR}/bench/ringbuffer_bench.c
+  ${CMAKE_SOURCE_DIR}/src/ringbuffer.c)
+add_executable(graphics_bench EXCLUDE_FROM_ALL
+  ${CMAKE_CURRENT_LIST_DIR}/bench/graphics_bench.c
+  ${CMAKE_SOURCE_DIR}/src/modules/graphics/gc.c
+  ${CMAKE_SOURCE_DIR}/src/modules/graphics/gc_dlist.c
+  ${CMAKE_SOURCE_DIR}/src/modules/graphics/gc_16bit_prims.c
+  ${CMAKE_SOURCE_DIR}/src/modules/graphics/gc_1bit_prims.c
+  ${CMAKE_SOURCE_DIR}/src/modules/graphics/font_default.c)
+target_include_directories(graphics_bench PRIVATE
+  ${CMAKE_SOURCE_DIR}/src/modules/graphics)
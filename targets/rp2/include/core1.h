@@ -0,0 +1,72 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __RP2_CORE1_H
+#define __RP2_CORE1_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spsc_ringbuffer.h"
+
+/**
+ * Dual-core mode (built with -DDUAL_CORE=ON). Core 1 polls the USB CDC tty
+ * and the UART ports into lock-free ring buffers, and notifies core 0
+ * running the JS loop through the inter-core FIFO.
+ */
+
+#define KM_CORE1_EVENT_TTY 0x01
+#define KM_CORE1_EVENT_UART(port) (0x02 << (port))
+
+void km_core1_init();
+bool km_core1_is_running();
+
+/**
+ * Start or stop polling a UART port on core 1. Detaching waits until core 1
+ * is out of the polling of the port.
+ */
+void km_core1_uart_attach(uint8_t port);
+void km_core1_uart_detach(uint8_t port);
+
+/**
+ * Drain the inter-core FIFO into the events pending on core 0
+ */
+void km_core1_take_events();
+
+/**
+ * Return the length of the ring buffer fed by core 1 if its event is
+ * pending, or 0. The event is consumed when the ring is found empty, so
+ * core 0 reads a ring only after core 1 notified it.
+ */
+uint32_t km_core1_ring_available(uint32_t event, spsc_ringbuffer_t *ring);
+
+/**
+ * Pause core 1 while writing the flash memory
+ */
+void km_core1_lockout_start();
+void km_core1_lockout_end();
+
+/* polling functions run on core 1 */
+
+bool km_tty_poll();
+bool km_uart_poll(uint8_t port);
+
+#endif /* __RP2_CORE1_H */
@@ -0,0 +1,69 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __RP2_PIO_DMA_H
+#define __RP2_PIO_DMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * DMA transfers between memory and the FIFOs of the PIO state machines.
+ * A transfer moves one block of 32-bit words, or streams continuously
+ * through blocks with two DMA channels chained to each other.
+ */
+
+/**
+ * Called from the DMA interrupt when a block is done. In continuous mode it
+ * returns the block the channel is re-armed with: the next block to send or
+ * fill, or NULL to send zeros (TX) or discard the words (RX).
+ *
+ * @param done The block that was done, NULL if zeros were sent or the words
+ * were discarded.
+ */
+typedef uint32_t *(*km_pio_dma_cb)(uint32_t *done, void *arg);
+
+/**
+ * Start a DMA transfer to the TX FIFO (tx = true) or from the RX FIFO of a
+ * state machine.
+ *
+ * @param buf0 The block to transfer first.
+ * @param buf1 The block to transfer next in continuous mode, NULL for a
+ * single transfer of buf0.
+ * @return 0 on success, EBUSY if a transfer in the direction is running or
+ * no DMA channel is free, or EINVAL.
+ */
+int km_pio_dma_start(uint8_t pio, uint8_t sm, bool tx, size_t block_size,
+                     uint32_t *buf0, uint32_t *buf1, km_pio_dma_cb dma_cb,
+                     void *arg);
+
+/**
+ * Abort the transfer and release the DMA channels.
+ */
+int km_pio_dma_stop(uint8_t pio, uint8_t sm, bool tx);
+
+/**
+ * Abort all transfers when system cleanup
+ */
+void km_pio_dma_cleanup();
+
+#endif /* __RP2_PIO_DMA_H */
@@ -26,9 +26,34 @@
 #include "board.h"
 #include "err.h"
 #include "hardware/adc.h"
+#include "hardware/dma.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "pico/stdlib.h"
 
+#define ADC_CLOCK_HZ 48000000
+#define ADC_CONVERSION_CYCLES 96
+#define ADC_CAPTURE_DMA_IRQ 1  // DMA_IRQ_1
+
+/**
+ * Free-running capture. Two DMA channels chained to each other fill the
+ * buffers alternately from the ADC FIFO, and each is re-armed with the
+ * next buffer in the DMA interrupt while the other one is running.
+ */
+typedef struct {
+  bool running;
+  int dma[2];
+  uint16_t *buf[2];  // buffer being filled by each DMA, NULL to discard
+  uint8_t next;      // DMA expected to complete next
+  size_t block_size;
+  km_adc_capture_cb capture_cb;
+  void *arg;
+} __adc_capture_t;
+
+static __adc_capture_t __adc_capture = {.running = false};
+static uint16_t __adc_capture_discard;
+
 /**
  * Get ADC index
  *
@@ -51,6 +76,7 @@ void km_adc_init() { adc_init(); }
  * Cleanup all ADC channels when system cleanup
  */
 void km_adc_cleanup() {
+  km_adc_capture_stop();
   // adc pins will be reset at the GPIO cleanup function.
 }
 
@@ -61,23 +87,34 @@ void km_adc_cleanup() {
  * @return {double}
  */
 double km_adc_read(uint8_t adcIndex) {
-  return (double)adc_read() / (1 << ADC_RESOLUTION_BIT);
+  return (double)km_adc_read_u16(adcIndex) / (1 << 16);
 }
 
-int km_adc_setup(uint8_t pin) {
-
+uint16_t km_adc_read_u16(uint8_t adcIndex) {
+  if (__adc_capture.running) {
+    return 0;  // the ADC is free-running
+  }
+  // the input is shared with the sampler interrupt
+  uint32_t irq = save_and_disable_interrupts();
+  adc_select_input(adcIndex);
+  uint16_t value = adc_read();
+  restore_interrupts(irq);
+  return value << (16 - ADC_RESOLUTION_BIT);
+}
 
-  
+int km_adc_setup(uint8_t pin) {
   int ch = __get_adc_index(pin);
   if (ch < 0) {
     return EINVPIN;
+  } else if (__adc_capture.running) {
+    return EBUSY;
   } else if (ch == 4) {
     adc_set_temp_sensor_enabled(true);
   } else {
     adc_gpio_init(pin);
   }
   adc_select_input(ch);
-  return 0;
+  return ch;
 }
 
 int km_adc_close(uint8_t pin) {
@@ -89,3 +126,111 @@ int km_adc_close(uint8_t pin) {
   }
   return 0;
 }
+
+static void __adc_capture_arm(uint8_t i, uint16_t *buf) {
+  int ch = __adc_capture.dma[i];
+  __adc_capture.buf[i] = buf;
+  dma_channel_config config = dma_channel_get_default_config(ch);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+  channel_config_set_dreq(&config, DREQ_ADC);
+  channel_config_set_read_increment(&config, false);
+  channel_config_set_write_increment(&config, buf != NULL);
+  channel_config_set_chain_to(&config, __adc_capture.dma[1 - i]);
+  dma_channel_configure(ch, &config,
+                        buf != NULL ? buf : &__adc_capture_discard,
+                        &adc_hw->fifo, __adc_capture.block_size, false);
+}
+
+static void __adc_capture_irq_handler() {
+  // handle in the order of completion, even if both have completed
+  for (int n = 0; n < 2; n++) {
+    uint8_t i = __adc_capture.next;
+    int ch = __adc_capture.dma[i];
+    if (!dma_irqn_get_channel_status(ADC_CAPTURE_DMA_IRQ, ch)) {
+      break;
+    }
+    dma_irqn_acknowledge_channel(ADC_CAPTURE_DMA_IRQ, ch);
+    uint16_t *buf =
+        __adc_capture.capture_cb(__adc_capture.buf[i], __adc_capture.arg);
+    __adc_capture_arm(i, buf);
+    __adc_capture.next = 1 - i;
+  }
+}
+
+int km_adc_capture_start(const uint8_t *channels, uint8_t count, uint32_t rate,
+                         size_t block_size, uint16_t *buf0, uint16_t *buf1,
+                         km_adc_capture_cb capture_cb, void *arg) {
+  if (__adc_capture.running) {
+    return EBUSY;
+  }
+  uint64_t total_rate = (uint64_t)rate * count;
+  if (count == 0 || rate == 0 || block_size == 0 || block_size % count != 0 ||
+      total_rate > ADC_CLOCK_HZ / ADC_CONVERSION_CYCLES) {
+    return EINVAL;
+  }
+  uint16_t mask = 0;
+  for (int i = 0; i < count; i++) {
+    mask |= (1 << channels[i]);
+  }
+  __adc_capture.dma[0] = dma_claim_unused_channel(false);
+  __adc_capture.dma[1] = dma_claim_unused_channel(false);
+  if (__adc_capture.dma[0] < 0 || __adc_capture.dma[1] < 0) {
+    for (int i = 0; i < 2; i++) {
+      if (__adc_capture.dma[i] >= 0) {
+        dma_channel_unclaim(__adc_capture.dma[i]);
+      }
+    }
+    return EBUSY;
+  }
+  __adc_capture.block_size = block_size;
+  __adc_capture.capture_cb = capture_cb;
+  __adc_capture.arg = arg;
+  __adc_capture.next = 0;
+
+  // the ADC converts channels in ascending order from the selected input
+  adc_run(false);
+  adc_select_input(channels[0]);
+  adc_set_round_robin(count > 1 ? mask : 0);
+  adc_fifo_setup(true, true, 1, false, false);
+  adc_fifo_drain();
+  adc_set_clkdiv((float)ADC_CLOCK_HZ / total_rate - 1);
+
+  __adc_capture_arm(0, buf0);
+  __adc_capture_arm(1, buf1);
+  for (int i = 0; i < 2; i++) {
+    dma_irqn_acknowledge_channel(ADC_CAPTURE_DMA_IRQ, __adc_capture.dma[i]);
+    dma_irqn_set_channel_enabled(ADC_CAPTURE_DMA_IRQ, __adc_capture.dma[i],
+                                 true);
+  }
+  irq_add_shared_handler(DMA_IRQ_1, __adc_capture_irq_handler,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+  __adc_capture.running = true;
+  dma_channel_start(__adc_capture.dma[0]);
+  adc_run(true);
+  return 0;
+}
+
+int km_adc_capture_stop() {
+  if (!__adc_capture.running) {
+    return 0;
+  }
+  adc_run(false);
+  for (int i = 0; i < 2; i++) {
+    dma_irqn_set_channel_enabled(ADC_CAPTURE_DMA_IRQ, __adc_capture.dma[i],
+                                 false);
+  }
+  // no transfer completes (and chains) without the ADC running
+  for (int i = 0; i < 2; i++) {
+    dma_channel_abort(__adc_capture.dma[i]);
+    dma_irqn_acknowledge_channel(ADC_CAPTURE_DMA_IRQ, __adc_capture.dma[i]);
+    dma_channel_unclaim(__adc_capture.dma[i]);
+  }
+  irq_remove_handler(DMA_IRQ_1, __adc_capture_irq_handler);
+  adc_fifo_setup(false, false, 0, false, false);
+  adc_fifo_drain();
+  adc_set_round_robin(0);
+  adc_set_clkdiv(0);
+  __adc_capture.running = false;
+  return 0;
+}
@@ -0,0 +1,115 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "core1.h"
+
+#include "board.h"
+#include "pico/multicore.h"
+#include "pico/stdlib.h"
+
+#define CORE1_IDLE_TIME_US 100
+
+static volatile bool __core1_running = false;
+static volatile uint32_t __core1_uart_ports = 0;  // bitmask of ports to poll
+static volatile uint32_t __core1_pass = 0;        // loop count of core 1
+static uint32_t __core1_events = 0;  // events taken by core 0, not consumed
+
+static void __core1_entry() {
+  multicore_lockout_victim_init();
+  __core1_running = true;
+  uint32_t events = 0;  // not pushed yet
+  while (true) {
+    if (km_tty_poll()) {
+      events |= KM_CORE1_EVENT_TTY;
+    }
+    uint32_t ports = __atomic_load_n(&__core1_uart_ports, __ATOMIC_ACQUIRE);
+    for (uint8_t port = 0; port < KALUMA_UART_NUM; port++) {
+      if ((ports & (1 << port)) && km_uart_poll(port)) {
+        events |= KM_CORE1_EVENT_UART(port);
+      }
+    }
+    __atomic_store_n(&__core1_pass, __core1_pass + 1, __ATOMIC_RELEASE);
+    if (events) {
+      // while the FIFO is full, the events are kept and pushed later
+      if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(events);  // also wakes up core 0 (SEV)
+        events = 0;
+      }
+    } else {
+      best_effort_wfe_or_timeout(make_timeout_time_us(CORE1_IDLE_TIME_US));
+    }
+  }
+}
+
+void km_core1_init() {
+  if (!__core1_running) {
+    multicore_launch_core1(__core1_entry);
+  }
+}
+
+bool km_core1_is_running() { return __core1_running; }
+
+void km_core1_uart_attach(uint8_t port) {
+  __atomic_store_n(&__core1_uart_ports, __core1_uart_ports | (1 << port),
+                   __ATOMIC_RELEASE);
+}
+
+void km_core1_uart_detach(uint8_t port) {
+  __atomic_store_n(&__core1_uart_ports, __core1_uart_ports & ~(1 << port),
+                   __ATOMIC_RELEASE);
+  if (__core1_running) {
+    // wait for a full pass so core 1 does not touch the port anymore
+    uint32_t pass = __atomic_load_n(&__core1_pass, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&__core1_pass, __ATOMIC_ACQUIRE) - pass < 2) {
+      tight_loop_contents();
+    }
+  }
+}
+
+void km_core1_take_events() {
+  while (multicore_fifo_rvalid()) {
+    __core1_events |= multicore_fifo_pop_blocking();
+  }
+}
+
+uint32_t km_core1_ring_available(uint32_t event, spsc_ringbuffer_t *ring) {
+  km_core1_take_events();
+  if ((__core1_events & event) == 0) {
+    return 0;
+  }
+  uint32_t length = spsc_ringbuffer_length(ring);
+  if (length == 0) {
+    __core1_events &= ~event;  // all the notified data are consumed
+  }
+  return length;
+}
+
+void km_core1_lockout_start() {
+  if (__core1_running) {
+    multicore_lockout_start_blocking();
+  }
+}
+
+void km_core1_lockout_end() {
+  if (__core1_running) {
+    multicore_lockout_end_blocking();
+  }
+}
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "board.h"
+#include "core1.h"
 #include "hardware/flash.h"
 #include "hardware/sync.h"
 #include "pico/stdlib.h"
@@ -51,9 +52,11 @@ int km_flash_program(uint32_t sector, uint32_t offset, uint8_t *buffer,
     return -22;  // EINVAL
   }
 
+  km_core1_lockout_start();  // core 1 must not run from flash meanwhile
   uint32_t saved_irq = save_and_disable_interrupts();
   flash_range_program(_base, buffer, size);
   restore_interrupts(saved_irq);
+  km_core1_lockout_end();
   return 0;
 }
 
@@ -72,8 +75,10 @@ int km_flash_erase(uint32_t sector, size_t count) {
     return -22;  // EINVAL
   }
 
+  km_core1_lockout_start();  // core 1 must not run from flash meanwhile
   uint32_t saved_irq = save_and_disable_interrupts();
   flash_range_erase(_base, _size);
   restore_interrupts(saved_irq);
+  km_core1_lockout_end();
   return 0;
 }
@@ -19,6 +19,7 @@
  * SOFTWARE.
  */
 #include "board.h"
+#include "core1.h"
 #include "gpio.h"
 #include "io.h"
 #include "repl.h"
@@ -31,6 +32,9 @@ int main(void) {
   km_system_init();
   load = km_running_script_check();
   km_tty_init();
+#ifdef KALUMA_DUAL_CORE
+  km_core1_init();
+#endif
   km_io_init();
   km_repl_init(true);
   km_runtime_init(load, true);
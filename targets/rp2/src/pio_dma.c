@@ -0,0 +1,206 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pio_dma.h"
+
+#include "board.h"
+#include "err.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+
+#define PIO_DMA_IRQ 1  // DMA_IRQ_1, shared with the ADC capture
+#define PIO_DMA_NUM (KALUMA_PIO_NUM * KALUMA_PIO_SM_NUM * 2)
+
+/**
+ * A transfer of a state machine in one direction. In continuous mode two
+ * DMA channels chained to each other transfer the blocks alternately, and
+ * each is re-armed with the next block in the DMA interrupt while the other
+ * one is running.
+ */
+typedef struct {
+  bool running;
+  bool continuous;
+  bool tx;
+  PIO pio;
+  uint8_t sm;
+  int dma[2];        // the second channel is -1 for a single transfer
+  uint32_t *buf[2];  // block being transferred by each DMA, NULL if none
+  uint8_t next;      // DMA expected to complete next
+  size_t block_size;
+  km_pio_dma_cb dma_cb;
+  void *arg;
+} __pio_dma_t;
+
+static __pio_dma_t __pio_dma[PIO_DMA_NUM];
+static uint8_t __pio_dma_running = 0;  // transfers using the DMA interrupt
+static const uint32_t __pio_dma_zero = 0;  // sent when TX has no block
+static uint32_t __pio_dma_discard;         // written when RX has no block
+
+static PIO __pio(uint8_t pio) { return pio == 0 ? pio0 : pio1; }
+
+static __pio_dma_t *__pio_dma_get(uint8_t pio, uint8_t sm, bool tx) {
+  if (pio >= KALUMA_PIO_NUM || sm >= KALUMA_PIO_SM_NUM) {
+    return NULL;
+  }
+  return &__pio_dma[(pio * KALUMA_PIO_SM_NUM + sm) * 2 + (tx ? 1 : 0)];
+}
+
+static void __pio_dma_arm(__pio_dma_t *dma, uint8_t i, uint32_t *buf) {
+  int ch = dma->dma[i];
+  dma->buf[i] = buf;
+  dma_channel_config config = dma_channel_get_default_config(ch);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+  channel_config_set_dreq(&config, pio_get_dreq(dma->pio, dma->sm, dma->tx));
+  if (dma->continuous) {
+    channel_config_set_chain_to(&config, dma->dma[1 - i]);
+  }
+  if (dma->tx) {
+    channel_config_set_read_increment(&config, buf != NULL);
+    channel_config_set_write_increment(&config, false);
+    dma_channel_configure(ch, &config, &dma->pio->txf[dma->sm],
+                          buf != NULL ? buf : &__pio_dma_zero,
+                          dma->block_size, false);
+  } else {
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, buf != NULL);
+    dma_channel_configure(ch, &config,
+                          buf != NULL ? buf : &__pio_dma_discard,
+                          &dma->pio->rxf[dma->sm], dma->block_size, false);
+  }
+}
+
+static void __pio_dma_irq_handler() {
+  for (int k = 0; k < PIO_DMA_NUM; k++) {
+    __pio_dma_t *dma = &__pio_dma[k];
+    if (!dma->running) {
+      continue;
+    }
+    // handle in the order of completion, even if both have completed
+    for (int n = 0; n < 2; n++) {
+      uint8_t i = dma->next;
+      int ch = dma->dma[i];
+      if (ch < 0 || !dma_irqn_get_channel_status(PIO_DMA_IRQ, ch)) {
+        break;
+      }
+      dma_irqn_acknowledge_channel(PIO_DMA_IRQ, ch);
+      uint32_t *buf = dma->dma_cb(dma->buf[i], dma->arg);
+      if (!dma->continuous) {
+        break;
+      }
+      __pio_dma_arm(dma, i, buf);
+      dma->next = 1 - i;
+    }
+  }
+}
+
+int km_pio_dma_start(uint8_t pio, uint8_t sm, bool tx, size_t block_size,
+                     uint32_t *buf0, uint32_t *buf1, km_pio_dma_cb dma_cb,
+                     void *arg) {
+  __pio_dma_t *dma = __pio_dma_get(pio, sm, tx);
+  if (dma == NULL || block_size == 0 || buf0 == NULL) {
+    return EINVAL;
+  } else if (dma->running) {
+    return EBUSY;
+  }
+  dma->continuous = (buf1 != NULL);
+  dma->dma[0] = dma_claim_unused_channel(false);
+  dma->dma[1] = dma->continuous ? dma_claim_unused_channel(false) : -1;
+  if (dma->dma[0] < 0 || (dma->continuous && dma->dma[1] < 0)) {
+    for (int i = 0; i < 2; i++) {
+      if (dma->dma[i] >= 0) {
+        dma_channel_unclaim(dma->dma[i]);
+      }
+    }
+    return EBUSY;
+  }
+  dma->tx = tx;
+  dma->pio = __pio(pio);
+  dma->sm = sm;
+  dma->next = 0;
+  dma->block_size = block_size;
+  dma->dma_cb = dma_cb;
+  dma->arg = arg;
+  __pio_dma_arm(dma, 0, buf0);
+  if (dma->continuous) {
+    __pio_dma_arm(dma, 1, buf1);
+  }
+  for (int i = 0; i < 2; i++) {
+    if (dma->dma[i] >= 0) {
+      dma_irqn_acknowledge_channel(PIO_DMA_IRQ, dma->dma[i]);
+      dma_irqn_set_channel_enabled(PIO_DMA_IRQ, dma->dma[i], true);
+    }
+  }
+  if (__pio_dma_running == 0) {
+    irq_add_shared_handler(DMA_IRQ_1, __pio_dma_irq_handler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+  }
+  __pio_dma_running++;
+  dma->running = true;
+  dma_channel_start(dma->dma[0]);
+  return 0;
+}
+
+int km_pio_dma_stop(uint8_t pio, uint8_t sm, bool tx) {
+  __pio_dma_t *dma = __pio_dma_get(pio, sm, tx);
+  if (dma == NULL) {
+    return EINVAL;
+  } else if (!dma->running) {
+    return 0;
+  }
+  for (int i = 0; i < 2; i++) {
+    if (dma->dma[i] >= 0) {
+      dma_irqn_set_channel_enabled(PIO_DMA_IRQ, dma->dma[i], false);
+    }
+  }
+  // disable both first, so the other one is not triggered by the chain
+  for (int i = 0; i < 2; i++) {
+    if (dma->dma[i] >= 0) {
+      hw_clear_bits(&dma_hw->ch[dma->dma[i]].al1_ctrl,
+                    DMA_CH0_CTRL_TRIG_EN_BITS);
+    }
+  }
+  for (int i = 0; i < 2; i++) {
+    if (dma->dma[i] >= 0) {
+      dma_channel_abort(dma->dma[i]);
+      dma_irqn_acknowledge_channel(PIO_DMA_IRQ, dma->dma[i]);
+      dma_channel_unclaim(dma->dma[i]);
+      dma->dma[i] = -1;
+    }
+  }
+  dma->running = false;
+  __pio_dma_running--;
+  if (__pio_dma_running == 0) {
+    irq_remove_handler(DMA_IRQ_1, __pio_dma_irq_handler);
+  }
+  return 0;
+}
+
+void km_pio_dma_cleanup() {
+  for (uint8_t pio = 0; pio < KALUMA_PIO_NUM; pio++) {
+    for (uint8_t sm = 0; sm < KALUMA_PIO_SM_NUM; sm++) {
+      km_pio_dma_stop(pio, sm, true);
+      km_pio_dma_stop(pio, sm, false);
+    }
+  }
+}
@@ -0,0 +1,360 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pulse.h"
+
+#include <stdbool.h>
+
+#include "err.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+
+/**
+ * Each engine runs a state machine of PIO1, taken from the last one, with
+ * a DMA channel moving the durations between the FIFO and the buffer.
+ */
+#define PULSE_PIO pio1
+#define PULSE_NUM 2
+
+/**
+ * Capture program, running at 16 MHz. X counts down from Y (the timeout)
+ * every 2 cycles while the level lasts, and is pushed at the edge. A level
+ * lasts 2 * (Y - X) + 4 cycles. When X reaches 0, it halts at TIMEOUT.
+ */
+#define PULSE_CAPTURE_FREQ 16000000
+#define PULSE_CAPTURE_TICKS_PER_US 8
+#define PULSE_CAPTURE_HIGH 0  // entry to capture from high level
+#define PULSE_CAPTURE_LOW 7   // entry to capture from low level
+#define PULSE_CAPTURE_TIMEOUT 13
+
+/**
+ * Generate program, running at 8 MHz. Each duration of d usec takes
+ * exactly 8 * d cycles: 4 to pull and set up, 8 * (d - 1) to delay and 4
+ * to toggle the pin.
+ */
+#define PULSE_GENERATE_FREQ 8000000
+#define PULSE_GENERATE_MIN 2
+
+typedef struct {
+  bool used;
+  bool capture;
+  bool done;
+  uint8_t pin;
+  uint8_t start_state;
+  uint sm;
+  int dma;
+  uint32_t *buf;
+  size_t length;
+  uint32_t ticks;  // timeout in ticks of the capture program
+  uint32_t timeout;
+  uint64_t start_time;
+  int count;
+} __pulse_t;
+
+static __pulse_t __pulse[PULSE_NUM];
+
+static uint16_t __capture_instructions[14];
+static uint16_t __generate_instructions[6];
+static pio_program_t __capture_program = {
+    .instructions = __capture_instructions,
+    .length = 14,
+    .origin = -1,
+};
+static pio_program_t __generate_program = {
+    .instructions = __generate_instructions,
+    .length = 6,
+    .origin = -1,
+};
+static int __capture_offset = -1;
+static int __generate_offset = -1;
+static uint8_t __capture_users = 0;
+static uint8_t __generate_users = 0;
+
+void km_pulse_init() {
+  uint16_t *c = __capture_instructions;
+  c[0] = pio_encode_wait_pin(true, 0);  // HIGH
+  c[1] = pio_encode_mov(pio_x, pio_y);
+  c[2] = pio_encode_jmp_pin(4);
+  c[3] = pio_encode_jmp(6);
+  c[4] = pio_encode_jmp_x_dec(2);
+  c[5] = pio_encode_jmp(PULSE_CAPTURE_TIMEOUT);
+  c[6] = pio_encode_in(pio_x, 32);
+  c[7] = pio_encode_wait_pin(false, 0);  // LOW
+  c[8] = pio_encode_mov(pio_x, pio_y);
+  c[9] = pio_encode_jmp_pin(12);
+  c[10] = pio_encode_jmp_x_dec(9);
+  c[11] = pio_encode_jmp(PULSE_CAPTURE_TIMEOUT);
+  c[12] = pio_encode_in(pio_x, 32);  // wrap to HIGH
+  c[13] = pio_encode_jmp(PULSE_CAPTURE_TIMEOUT);
+  uint16_t *g = __generate_instructions;
+  g[0] = pio_encode_pull(false, true);
+  g[1] = pio_encode_out(pio_x, 32);
+  g[2] = pio_encode_jmp_x_dec(3);
+  g[3] = pio_encode_jmp_x_dec(4);
+  g[4] = pio_encode_jmp_x_dec(4) | pio_encode_delay(7);
+  g[5] = pio_encode_mov_not(pio_pins, pio_pins) | pio_encode_delay(3);
+  for (int i = 0; i < PULSE_NUM; i++) {
+    __pulse[i].used = false;
+  }
+}
+
+void km_pulse_cleanup() {
+  for (int i = 0; i < PULSE_NUM; i++) {
+    km_pulse_stop(i);
+  }
+}
+
+/**
+ * Claim a state machine from the last one, a DMA channel and the program.
+ */
+static __pulse_t *__pulse_alloc(bool capture) {
+  int id = -1;
+  for (int i = 0; i < PULSE_NUM; i++) {
+    if (!__pulse[i].used) {
+      id = i;
+      break;
+    }
+  }
+  if (id < 0) {
+    return NULL;
+  }
+  __pulse_t *pulse = &__pulse[id];
+  int sm = -1;
+  for (int i = NUM_PIO_STATE_MACHINES - 1; i >= 0; i--) {
+    if (!pio_sm_is_claimed(PULSE_PIO, i)) {
+      sm = i;
+      break;
+    }
+  }
+  if (sm < 0) {
+    return NULL;
+  }
+  pio_program_t *program = capture ? &__capture_program : &__generate_program;
+  int *offset = capture ? &__capture_offset : &__generate_offset;
+  uint8_t *users = capture ? &__capture_users : &__generate_users;
+  if (*users == 0) {
+    if (!pio_can_add_program(PULSE_PIO, program)) {
+      return NULL;
+    }
+    *offset = pio_add_program(PULSE_PIO, program);
+  }
+  pulse->dma = dma_claim_unused_channel(false);
+  if (pulse->dma < 0) {
+    if (*users == 0) {
+      pio_remove_program(PULSE_PIO, program, *offset);
+    }
+    return NULL;
+  }
+  (*users)++;
+  pio_sm_claim(PULSE_PIO, sm);
+  pulse->sm = sm;
+  pulse->capture = capture;
+  pulse->done = false;
+  pulse->count = 0;
+  pulse->used = true;
+  return pulse;
+}
+
+static void __pulse_free(__pulse_t *pulse) {
+  pio_sm_set_enabled(PULSE_PIO, pulse->sm, false);
+  dma_channel_abort(pulse->dma);
+  dma_channel_unclaim(pulse->dma);
+  pio_sm_unclaim(PULSE_PIO, pulse->sm);
+  pio_program_t *program =
+      pulse->capture ? &__capture_program : &__generate_program;
+  int *offset = pulse->capture ? &__capture_offset : &__generate_offset;
+  uint8_t *users = pulse->capture ? &__capture_users : &__generate_users;
+  (*users)--;
+  if (*users == 0) {
+    pio_remove_program(PULSE_PIO, program, *offset);
+  }
+  pulse->used = false;
+}
+
+int km_pulse_capture_start(uint8_t pin, uint8_t start_state, uint32_t *buf,
+                           size_t length, uint32_t timeout) {
+  if (pin >= NUM_BANK0_GPIOS || length == 0 || timeout == 0) {
+    return EINVAL;
+  }
+  __pulse_t *pulse = __pulse_alloc(true);
+  if (pulse == NULL) {
+    return EBUSY;
+  }
+  pulse->pin = pin;
+  pulse->start_state = start_state;
+  pulse->buf = buf;
+  pulse->length = length;
+  pulse->timeout = timeout;
+  uint64_t ticks = (uint64_t)timeout * PULSE_CAPTURE_TICKS_PER_US;
+  pulse->ticks = ticks > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)ticks;
+  gpio_set_input_enabled(pin, true);
+
+  uint sm = pulse->sm;
+  pio_sm_config config = pio_get_default_sm_config();
+  sm_config_set_in_pins(&config, pin);
+  sm_config_set_jmp_pin(&config, pin);
+  sm_config_set_in_shift(&config, false, true, 32);
+  sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_RX);
+  sm_config_set_wrap(&config, __capture_offset + PULSE_CAPTURE_HIGH,
+                     __capture_offset + PULSE_CAPTURE_TIMEOUT - 1);
+  sm_config_set_clkdiv(&config,
+                       (float)clock_get_hz(clk_sys) / PULSE_CAPTURE_FREQ);
+  // wait for the start state, or start with the current level
+  bool high = (start_state == KM_PULSE_NO_STATE) ? gpio_get(pin)
+                                                  : (start_state != 0);
+  pio_sm_init(PULSE_PIO, sm,
+              __capture_offset + (high ? PULSE_CAPTURE_HIGH : PULSE_CAPTURE_LOW),
+              &config);
+  // Y = timeout
+  pio_sm_put(PULSE_PIO, sm, pulse->ticks);
+  pio_sm_exec(PULSE_PIO, sm, pio_encode_pull(false, false));
+  pio_sm_exec(PULSE_PIO, sm, pio_encode_mov(pio_y, pio_osr));
+
+  dma_channel_config dma_config = dma_channel_get_default_config(pulse->dma);
+  channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_32);
+  channel_config_set_read_increment(&dma_config, false);
+  channel_config_set_write_increment(&dma_config, true);
+  channel_config_set_dreq(&dma_config, pio_get_dreq(PULSE_PIO, sm, false));
+  dma_channel_configure(pulse->dma, &dma_config, buf, &PULSE_PIO->rxf[sm],
+                        length, true);
+  pulse->start_time = time_us_64();
+  pio_sm_set_enabled(PULSE_PIO, sm, true);
+  return pulse - __pulse;
+}
+
+int km_pulse_generate_start(uint8_t pin, uint8_t start_state,
+                            const uint32_t *buf, size_t length) {
+  if (pin >= NUM_BANK0_GPIOS || length == 0) {
+    return EINVAL;
+  }
+  // shorter durations would underflow the delay loop
+  for (size_t i = 0; i < length; i++) {
+    if (buf[i] < PULSE_GENERATE_MIN) {
+      return EINVAL;
+    }
+  }
+  __pulse_t *pulse = __pulse_alloc(false);
+  if (pulse == NULL) {
+    return EBUSY;
+  }
+  pulse->pin = pin;
+  pulse->start_state = start_state;
+  pulse->buf = (uint32_t *)buf;
+  pulse->length = length;
+
+  uint sm = pulse->sm;
+  pio_sm_config config = pio_get_default_sm_config();
+  sm_config_set_out_pins(&config, pin, 1);
+  sm_config_set_in_pins(&config, pin);
+  sm_config_set_out_shift(&config, true, false, 32);
+  sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_TX);
+  sm_config_set_wrap(&config, __generate_offset,
+                     __generate_offset + __generate_program.length - 1);
+  sm_config_set_clkdiv(&config,
+                       (float)clock_get_hz(clk_sys) / PULSE_GENERATE_FREQ);
+  pio_sm_init(PULSE_PIO, sm, __generate_offset, &config);
+  pio_sm_set_pins_with_mask(PULSE_PIO, sm, (start_state ? 1u : 0u) << pin,
+                            1u << pin);
+  pio_sm_set_pindirs_with_mask(PULSE_PIO, sm, 1u << pin, 1u << pin);
+  pio_gpio_init(PULSE_PIO, pin);
+
+  dma_channel_config dma_config = dma_channel_get_default_config(pulse->dma);
+  channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_32);
+  channel_config_set_read_increment(&dma_config, true);
+  channel_config_set_write_increment(&dma_config, false);
+  channel_config_set_dreq(&dma_config, pio_get_dreq(PULSE_PIO, sm, true));
+  dma_channel_configure(pulse->dma, &dma_config, &PULSE_PIO->txf[sm], buf,
+                        length, true);
+  // the TX stall flag tells the end, so clear it after the FIFO is filled
+  while (pio_sm_is_tx_fifo_empty(PULSE_PIO, sm)) {
+    tight_loop_contents();
+  }
+  PULSE_PIO->fdebug = 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+  pulse->start_time = time_us_64();
+  pio_sm_set_enabled(PULSE_PIO, sm, true);
+  return pulse - __pulse;
+}
+
+/**
+ * Convert the captured counters to durations
+ */
+static void __pulse_capture_done(__pulse_t *pulse, size_t count) {
+  pio_sm_set_enabled(PULSE_PIO, pulse->sm, false);
+  dma_channel_abort(pulse->dma);
+  for (size_t i = 0; i < count; i++) {
+    uint64_t cycles = (uint64_t)(pulse->ticks - pulse->buf[i]) * 2 + 4;
+    pulse->buf[i] = (uint32_t)((cycles + PULSE_CAPTURE_TICKS_PER_US) /
+                               (PULSE_CAPTURE_TICKS_PER_US * 2));
+  }
+  pulse->count = count;
+  pulse->done = true;
+}
+
+int km_pulse_status(uint8_t id) {
+  if (id >= PULSE_NUM || !__pulse[id].used) {
+    return EINVAL;
+  }
+  __pulse_t *pulse = &__pulse[id];
+  if (pulse->done) {
+    return pulse->count;
+  }
+  uint sm = pulse->sm;
+  size_t remain = dma_channel_hw_addr(pulse->dma)->transfer_count;
+  if (pulse->capture) {
+    uint pc = pio_sm_get_pc(PULSE_PIO, sm) - __capture_offset;
+    if (!dma_channel_is_busy(pulse->dma)) {
+      __pulse_capture_done(pulse, pulse->length);
+    } else if (pc == PULSE_CAPTURE_TIMEOUT &&
+               pio_sm_is_rx_fifo_empty(PULSE_PIO, sm)) {
+      __pulse_capture_done(pulse, pulse->length - remain);
+    } else if (remain == pulse->length &&
+               (pc == PULSE_CAPTURE_HIGH || pc == PULSE_CAPTURE_LOW) &&
+               time_us_64() - pulse->start_time > pulse->timeout) {
+      __pulse_capture_done(pulse, 0);  // the start state never came
+    }
+  } else if (!dma_channel_is_busy(pulse->dma) &&
+             pio_sm_is_tx_fifo_empty(PULSE_PIO, sm) &&
+             (PULSE_PIO->fdebug & (1u << (PIO_FDEBUG_TXSTALL_LSB + sm)))) {
+    pulse->count = pulse->length;
+    pulse->done = true;
+  }
+  return pulse->done ? pulse->count : EBUSY;
+}
+
+int km_pulse_stop(uint8_t id) {
+  if (id >= PULSE_NUM || !__pulse[id].used) {
+    return EINVAL;
+  }
+  __pulse_t *pulse = &__pulse[id];
+  if (!pulse->capture) {
+    // hand the pin back to SIO at its current level
+    bool level = gpio_get(pulse->pin);
+    pio_sm_set_enabled(PULSE_PIO, pulse->sm, false);
+    gpio_put(pulse->pin, level);
+    gpio_set_dir(pulse->pin, GPIO_OUT);
+    gpio_set_function(pulse->pin, GPIO_FUNC_SIO);
+  }
+  __pulse_free(pulse);
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2017 Kaluma
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sampler.h"
+
+#include <stdbool.h>
+
+#include "err.h"
+#include "pico/time.h"
+
+#define SAMPLER_NUM 4
+
+/**
+ * Sampling timers are repeating timers of the default alarm pool, so the
+ * tick callbacks run in the timer interrupt.
+ */
+typedef struct {
+  bool used;
+  repeating_timer_t timer;
+  km_sampler_tick_cb tick_cb;
+  void *arg;
+} __sampler_status_t;
+
+static __sampler_status_t __sampler_status[SAMPLER_NUM];
+
+static bool __sampler_timer_cb(repeating_timer_t *rt) {
+  __sampler_status_t *status = (__sampler_status_t *)rt->user_data;
+  status->tick_cb(status->arg);
+  return true;
+}
+
+/**
+ * Initialize all sampling timers when system started
+ */
+void km_sampler_init() {
+  for (int i = 0; i < SAMPLER_NUM; i++) {
+    __sampler_status[i].used = false;
+  }
+}
+
+/**
+ * Stop all sampling timers when system cleanup
+ */
+void km_sampler_cleanup() {
+  for (int i = 0; i < SAMPLER_NUM; i++) {
+    if (__sampler_status[i].used) {
+      km_sampler_stop(i);
+    }
+  }
+}
+
+int km_sampler_start(uint32_t period_us, km_sampler_tick_cb tick_cb,
+                     void *arg) {
+  if (period_us == 0 || tick_cb == NULL) {
+    return EINVAL;
+  }
+  for (int i = 0; i < SAMPLER_NUM; i++) {
+    __sampler_status_t *status = &__sampler_status[i];
+    if (!status->used) {
+      status->tick_cb = tick_cb;
+      status->arg = arg;
+      // negative delay keeps the period between the starts of callbacks
+      if (!add_repeating_timer_us(-(int64_t)period_us, __sampler_timer_cb,
+                                  status, &status->timer)) {
+        return ENOMEM;
+      }
+      status->used = true;
+      return i;
+    }
+  }
+  return EBUSY;
+}
+
+int km_sampler_stop(uint8_t id) {
+  if (id >= SAMPLER_NUM || !__sampler_status[id].used) {
+    return EINVAL;
+  }
+  cancel_repeating_timer(&__sampler_status[id].timer);
+  __sampler_status[id].used = false;
+  return 0;
+}
@@ -23,13 +23,19 @@
 
 #include "board.h"
 #include "err.h"
+#include "hardware/dma.h"
 #include "hardware/spi.h"
 #include "pico/stdlib.h"
 
 struct __spi_status_s {
   bool enabled;
+  int tx_dma;  // DMA channels for background transfers, -1 if not available
+  int rx_dma;
 } __spi_status[KALUMA_SPI_NUM];
 
+static const uint8_t __dma_tx_fill = 0xFF;
+static uint8_t __dma_rx_discard;
+
 static bool __check_spi_pins(uint8_t bus, km_spi_pins_t pins) {
   if (bus == 0) {
     if ((pins.miso >= 0) && (pins.miso != 0) && (pins.miso != 4) &&
@@ -97,6 +103,29 @@ static spi_inst_t *__get_spi_no(uint8_t bus) {
 void km_spi_init() {
   for (int i = 0; i < KALUMA_SPI_NUM; i++) {
     __spi_status[i].enabled = false;
+    __spi_status[i].tx_dma = -1;
+    __spi_status[i].rx_dma = -1;
+  }
+}
+
+static void __spi_release_dma(uint8_t bus) {
+  int channels[2] = {__spi_status[bus].tx_dma, __spi_status[bus].rx_dma};
+  for (int i = 0; i < 2; i++) {
+    if (channels[i] >= 0) {
+      dma_channel_abort(channels[i]);
+      dma_channel_unclaim(channels[i]);
+    }
+  }
+  __spi_status[bus].tx_dma = -1;
+  __spi_status[bus].rx_dma = -1;
+}
+
+/**
+ * Wait for the background transfer before accessing the bus directly
+ */
+static void __spi_wait_dma(uint8_t bus) {
+  while (km_spi_transfer_busy(bus)) {
+    tight_loop_contents();
   }
 }
 
@@ -104,6 +133,9 @@ void km_spi_init() {
  * Cleanup all SPI when system cleanup
  */
 void km_spi_cleanup() {
+  for (int i = 0; i < KALUMA_SPI_NUM; i++) {
+    __spi_release_dma(i);
+  }
   spi_deinit(spi0);
   spi_deinit(spi1);
   km_spi_init();
@@ -167,6 +199,14 @@ int km_spi_setup(uint8_t bus, km_spi_mode_t mode, uint32_t baudrate,
     gpio_set_function(pins.sck, GPIO_FUNC_SPI);
     gpio_set_pulls(pins.sck, false, false);
   }
+  // claimed once per bus and kept until km_spi_close()
+  if (__spi_status[bus].tx_dma < 0) {
+    __spi_status[bus].tx_dma = dma_claim_unused_channel(false);
+    __spi_status[bus].rx_dma = dma_claim_unused_channel(false);
+    if ((__spi_status[bus].tx_dma < 0) || (__spi_status[bus].rx_dma < 0)) {
+      __spi_release_dma(bus);  // fallback to blocking transfers
+    }
+  }
   __spi_status[bus].enabled = true;
   return 0;
 }
@@ -178,6 +218,7 @@ int km_spi_sendrecv(uint8_t bus, uint8_t *tx_buf, uint8_t *rx_buf, size_t len,
     return EDEVREAD;
   }
   (void)timeout;  // timeout is not supported.
+  __spi_wait_dma(bus);
   return spi_write_read_blocking(spi, tx_buf, rx_buf, len);
 }
 
@@ -187,6 +228,7 @@ int km_spi_send(uint8_t bus, uint8_t *buf, size_t len, uint32_t timeout) {
     return EDEVWRITE;
   }
   (void)timeout;  // timeout is not supported.
+  __spi_wait_dma(bus);
   return spi_write_blocking(spi, buf, len);
 }
 
@@ -197,9 +239,65 @@ int km_spi_recv(uint8_t bus, uint8_t send_byte, uint8_t *buf, size_t len,
     return EDEVREAD;
   }
   (void)timeout;  // timeout is not supported.
+  __spi_wait_dma(bus);
   return spi_read_blocking(spi, send_byte, buf, len);
 }
 
+int km_spi_transfer_async(uint8_t bus, const uint8_t *tx_buf, uint8_t *rx_buf,
+                          size_t len) {
+  spi_inst_t *spi = __get_spi_no(bus);
+  if ((spi == NULL) || (__spi_status[bus].enabled == false)) {
+    return EDEVWRITE;
+  }
+  int tx_ch = __spi_status[bus].tx_dma;
+  int rx_ch = __spi_status[bus].rx_dma;
+  if (tx_ch < 0) {  // no DMA channels
+    if (tx_buf == NULL) {
+      spi_read_blocking(spi, 0xFF, rx_buf, len);
+    } else if (rx_buf == NULL) {
+      spi_write_blocking(spi, tx_buf, len);
+    } else {
+      spi_write_read_blocking(spi, tx_buf, rx_buf, len);
+    }
+    return 0;
+  }
+  if (dma_channel_is_busy(rx_ch)) {
+    return EBUSY;
+  }
+  // drop stale data in the RX FIFO
+  while (spi_is_readable(spi)) {
+    (void)spi_get_hw(spi)->dr;
+  }
+  // TX channel feeds the data register, RX channel always drains it so the
+  // transfer ends when the last byte is clocked in.
+  dma_channel_config config = dma_channel_get_default_config(tx_ch);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_dreq(&config, spi_get_dreq(spi, true));
+  channel_config_set_read_increment(&config, tx_buf != NULL);
+  channel_config_set_write_increment(&config, false);
+  dma_channel_configure(tx_ch, &config, &spi_get_hw(spi)->dr,
+                        (tx_buf != NULL) ? tx_buf : &__dma_tx_fill, len,
+                        false);
+  config = dma_channel_get_default_config(rx_ch);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_dreq(&config, spi_get_dreq(spi, false));
+  channel_config_set_read_increment(&config, false);
+  channel_config_set_write_increment(&config, rx_buf != NULL);
+  dma_channel_configure(rx_ch, &config,
+                        (rx_buf != NULL) ? rx_buf : &__dma_rx_discard,
+                        &spi_get_hw(spi)->dr, len, false);
+  dma_start_channel_mask((1u << tx_ch) | (1u << rx_ch));
+  return 0;
+}
+
+bool km_spi_transfer_busy(uint8_t bus) {
+  if (bus >= KALUMA_SPI_NUM) {
+    return false;
+  }
+  int ch = __spi_status[bus].rx_dma;
+  return (ch >= 0) && dma_channel_is_busy(ch);
+}
+
 int km_set_spi_baudrate(uint8_t bus, uint32_t baudrate) {
   spi_inst_t *spi = __get_spi_no(bus);
   if ((spi == NULL) || (__spi_status[bus].enabled == false)) {
@@ -214,6 +312,7 @@ int km_spi_close(uint8_t bus) {
   if ((spi == NULL) || (__spi_status[bus].enabled == false)) {
     return EDEVINIT;
   }
+  __spi_release_dma(bus);
   spi_deinit(spi);
   __spi_status[bus].enabled = false;
   return 0;
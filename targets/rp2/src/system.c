@@ -23,6 +23,7 @@
 
 #include "adc.h"
 #include "board.h"
+#include "core1.h"
 #include "flash.h"
 #include "gpio.h"
 #include "hardware/clocks.h"
@@ -35,8 +36,11 @@
 #include "io.h"
 #include "pico/stdlib.h"
 #include "pico/unique_id.h"
+#include "pio_dma.h"
+#include "pulse.h"
 #include "pwm.h"
 #include "rtc.h"
+#include "sampler.h"
 #include "spi.h"
 #include "tty.h"
 #include "tusb.h"
@@ -86,6 +90,19 @@ uint64_t km_micro_gettime() { return get_absolute_time()._private_us_since_boot;
  */
 void km_micro_delay(uint32_t usec) { sleep_us(usec); }
 
+/**
+ * Sleep until an interrupt (USB, UART, GPIO, ...) or the timeout
+ */
+void km_wait_for_event(uint32_t timeout) {
+  absolute_time_t until = make_timeout_time_ms(timeout);
+#ifdef PICO_CYW43
+  if (km_cyw43_wait_for_work(until)) {
+    return;
+  }
+#endif
+  best_effort_wfe_or_timeout(until);
+}
+
 static void km_uid_init() {
   pico_get_unique_board_id_string(serial, sizeof(serial));
 }
@@ -116,12 +133,17 @@ void km_system_init() {
   km_uart_init();
   km_rtc_init();
   km_flash_init();
+  km_sampler_init();
+  km_pulse_init();
 }
 
 void km_system_cleanup() {
 #ifdef PICO_CYW43
   km_cyw43_deinit();
 #endif
+  km_pulse_cleanup();
+  km_sampler_cleanup();
+  km_pio_dma_cleanup();
   km_adc_cleanup();
   km_pwm_cleanup();
   km_i2c_cleanup();
@@ -141,6 +163,9 @@ uint8_t km_running_script_check() {
 }
 
 void km_custom_infinite_loop() {
+#ifdef KALUMA_DUAL_CORE
+  km_core1_take_events();  // keep the FIFO open for core 1 to wake this core
+#endif
 #ifdef PICO_CYW43
   km_cyw43_infinite_loop();
 #endif
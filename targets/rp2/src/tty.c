@@ -24,20 +24,22 @@
 
 #include "hardware/timer.h"
 #include "pico/stdlib.h"
+#include "core1.h"
 #include "repl.h"
-#include "ringbuffer.h"
 #include "runtime.h"
+#include "spsc_ringbuffer.h"
 #include "system.h"
 #include "tusb.h"
 
-#define TTY_RX_RINGBUFFER_SIZE 2048
+#define TTY_RX_RINGBUFFER_SIZE 2048  // must be power of 2
 #define ETX 0x03  // Ctrl + C, SIGINT
 static unsigned char __tty_rx_buffer[TTY_RX_RINGBUFFER_SIZE];
-static ringbuffer_t __tty_rx_ringbuffer;
+static spsc_ringbuffer_t __tty_rx_ringbuffer;
+static uint32_t __tty_rx_count = 0;  // total received at the last check
 
 void km_tty_init() {
-  ringbuffer_init(&__tty_rx_ringbuffer, __tty_rx_buffer,
-                  sizeof(__tty_rx_buffer));
+  spsc_ringbuffer_init(&__tty_rx_ringbuffer, __tty_rx_buffer,
+                       sizeof(__tty_rx_buffer));
   tud_cdc_set_wanted_char(ETX);  // Crtl + C
 }
 
@@ -51,19 +53,44 @@ TU_ATTR_WEAK void tud_cdc_rx_wanted_cb(uint8_t itf, char wanted_char) {
   }
 }
 
+/**
+ * Move received characters into the ring buffer. This is the only producer
+ * of the ring buffer, called on core 1 in dual-core mode.
+ */
+bool km_tty_poll() {
+  spsc_ringbuffer_t *ringbuffer = &__tty_rx_ringbuffer;
+  bool received = false;
+  while (spsc_ringbuffer_length(ringbuffer) < ringbuffer->size) {
+    int ch = getchar_timeout_us(0);
+    if (ch < 0) {
+      break;
+    }
+    spsc_ringbuffer_put(ringbuffer, (uint8_t)ch);
+    received = true;
+  }
+  return received;
+}
+
 uint32_t km_tty_available() {
-  int ch = getchar_timeout_us(0);
-  while (ch >= 0) {
-    ringbuffer_write(&__tty_rx_ringbuffer, (uint8_t *)&ch, 1);
-    ch = getchar_timeout_us(0);
+#ifndef KALUMA_DUAL_CORE
+  km_tty_poll();
+#endif
+  uint32_t count =
+      __atomic_load_n(&__tty_rx_ringbuffer.head, __ATOMIC_ACQUIRE);
+  if (count != __tty_rx_count) {  // new characters received
+    __tty_rx_count = count;
     km_runtime_set_vm_stop(0);
   }
-  return ringbuffer_length(&__tty_rx_ringbuffer);
+#ifdef KALUMA_DUAL_CORE
+  return km_core1_ring_available(KM_CORE1_EVENT_TTY, &__tty_rx_ringbuffer);
+#else
+  return spsc_ringbuffer_length(&__tty_rx_ringbuffer);
+#endif
 }
 
 uint32_t km_tty_read(uint8_t *buf, size_t len) {
   if (km_tty_available() >= len) {
-    ringbuffer_read(&__tty_rx_ringbuffer, buf, len);
+    spsc_ringbuffer_read(&__tty_rx_ringbuffer, buf, len);
     return len;
   } else {
     return 0;
@@ -81,7 +108,7 @@ uint32_t km_tty_read_sync(uint8_t *buf, size_t len, uint32_t timeout) {
   } while ((get_absolute_time()._private_us_since_boot < timeout_ms._private_us_since_boot) && (sz < len));
 #endif
   if (sz >= len) {
-    ringbuffer_read(&__tty_rx_ringbuffer, buf, len);
+    spsc_ringbuffer_read(&__tty_rx_ringbuffer, buf, len);
     return len;
   } else {
     return 0;
@@ -91,7 +118,7 @@ uint32_t km_tty_read_sync(uint8_t *buf, size_t len, uint32_t timeout) {
 uint8_t km_tty_getc() {
   uint8_t c = 0;
   if (km_tty_available()) {
-    ringbuffer_read(&__tty_rx_ringbuffer, &c, 1);
+    spsc_ringbuffer_read(&__tty_rx_ringbuffer, &c, 1);
   }
   return c;
 }
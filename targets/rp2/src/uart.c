@@ -23,16 +23,19 @@
 #include <stdlib.h>
 
 #include "board.h"
+#include "core1.h"
 #include "err.h"
+#include "hardware/dma.h"
 #include "hardware/irq.h"
 #include "hardware/uart.h"
 #include "pico/stdlib.h"
-#include "ringbuffer.h"
+#include "spsc_ringbuffer.h"
 
-static ringbuffer_t __uart_rx_ringbuffer[KALUMA_UART_NUM];
+static spsc_ringbuffer_t __uart_rx_ringbuffer[KALUMA_UART_NUM];
 static uint8_t *__read_buffer[KALUMA_UART_NUM];
 static struct __uart_status_s {
   bool enabled;
+  int tx_dma;  // DMA channel for transmit, -1 if not available
 } __uart_status[KALUMA_UART_NUM];
 
 static uart_inst_t *__get_uart_no(uint8_t bus) {
@@ -46,16 +49,26 @@ static uart_inst_t *__get_uart_no(uint8_t bus) {
 }
 
 /**
- * This function called by IRQ Handler
+ * This function called by IRQ Handler. This is the only producer of the read
+ * buffer (RX and RX timeout interrupts cover all received bytes).
  */
 
 static void __uart_fill_ringbuffer(uart_inst_t *uart, uint8_t port) {
   while (uart_is_readable(uart)) {
     uint8_t ch = uart_getc(uart);
-    ringbuffer_write(&__uart_rx_ringbuffer[port], &ch, sizeof(ch));
+    spsc_ringbuffer_put(&__uart_rx_ringbuffer[port], ch);
   }
 }
 
+/**
+ * Poll the port on core 1 in dual-core mode instead of the IRQ handler
+ */
+bool km_uart_poll(uint8_t port) {
+  uint32_t length = spsc_ringbuffer_length(&__uart_rx_ringbuffer[port]);
+  __uart_fill_ringbuffer(__get_uart_no(port), port);
+  return spsc_ringbuffer_length(&__uart_rx_ringbuffer[port]) != length;
+}
+
 void __uart_irq_handler_0(void) { __uart_fill_ringbuffer(uart0, 0); }
 
 void __uart_irq_handler_1(void) { __uart_fill_ringbuffer(uart1, 1); }
@@ -122,6 +135,7 @@ km_uart_pins_t km_uart_get_default_pins(uint8_t port) {
 void km_uart_init() {
   for (int i = 0; i < KALUMA_UART_NUM; i++) {
     __uart_status[i].enabled = false;
+    __uart_status[i].tx_dma = -1;
     __read_buffer[i] = NULL;
   }
 }
@@ -168,12 +182,16 @@ int km_uart_setup(uint8_t port, uint32_t baudrate, uint8_t bits,
     pt = UART_PARITY_ODD;
   }
   uart_set_format(uart, bits, stop, pt);
-  __read_buffer[port] = (uint8_t *)malloc(buffer_size);
+  size_t size = 1;
+  while (size < buffer_size) {  // must be a power of 2
+    size <<= 1;
+  }
+  __read_buffer[port] = (uint8_t *)malloc(size);
   if (__read_buffer[port] == NULL) {
     return EDEVINIT;
   } else {
-    ringbuffer_init(&__uart_rx_ringbuffer[port], __read_buffer[port],
-                    buffer_size);
+    spsc_ringbuffer_init(&__uart_rx_ringbuffer[port], __read_buffer[port],
+                         size);
   }
   uart_set_fifo_enabled(uart, true);
   if (pins.tx >= 0) {
@@ -184,6 +202,9 @@ int km_uart_setup(uint8_t port, uint32_t baudrate, uint8_t bits,
     gpio_set_function(pins.rx, GPIO_FUNC_UART);
     gpio_set_pulls(pins.rx, false, false);
   }
+#ifdef KALUMA_DUAL_CORE
+  km_core1_uart_attach(port);
+#else
   if (port == 0) {
     irq_set_exclusive_handler(UART0_IRQ, __uart_irq_handler_0);
     irq_set_enabled(UART0_IRQ, true);
@@ -192,6 +213,8 @@ int km_uart_setup(uint8_t port, uint32_t baudrate, uint8_t bits,
     irq_set_enabled(UART1_IRQ, true);
   }
   uart_set_irq_enables(uart, true, false);
+#endif
+  __uart_status[port].tx_dma = dma_claim_unused_channel(false);
   __uart_status[port].enabled = true;
   return 0;
 }
@@ -201,17 +224,55 @@ int km_uart_write(uint8_t port, uint8_t *buf, size_t len) {
   if ((uart == NULL) || (__uart_status[port].enabled == false)) {
     return EDEVWRITE;
   }
+  int ch = __uart_status[port].tx_dma;
+  if (ch >= 0) {
+    dma_channel_wait_for_finish_blocking(ch);
+  }
   uart_write_blocking(uart, (const uint8_t *)buf, len);
   return len;
 }
 
+int km_uart_write_async(uint8_t port, uint8_t *buf, size_t len) {
+  uart_inst_t *uart = __get_uart_no(port);
+  if ((uart == NULL) || (__uart_status[port].enabled == false)) {
+    return EDEVWRITE;
+  }
+  int ch = __uart_status[port].tx_dma;
+  if (ch < 0) {  // no DMA channel left
+    uart_write_blocking(uart, (const uint8_t *)buf, len);
+    return 0;
+  }
+  if (dma_channel_is_busy(ch)) {
+    return EBUSY;
+  }
+  dma_channel_config config = dma_channel_get_default_config(ch);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_read_increment(&config, true);
+  channel_config_set_write_increment(&config, false);
+  channel_config_set_dreq(&config, uart_get_dreq(uart, true));
+  dma_channel_configure(ch, &config, &uart_get_hw(uart)->dr, buf, len, true);
+  return 0;
+}
+
+bool km_uart_write_busy(uint8_t port) {
+  if ((port >= KALUMA_UART_NUM) || (__uart_status[port].enabled == false)) {
+    return false;
+  }
+  int ch = __uart_status[port].tx_dma;
+  return (ch >= 0) && dma_channel_is_busy(ch);
+}
+
 uint32_t km_uart_available(uint8_t port) {
   uart_inst_t *uart = __get_uart_no(port);
   if ((uart == NULL) || (__uart_status[port].enabled == false)) {
     return ENOPHRPL;
   }
-  __uart_fill_ringbuffer(uart, port);
-  return ringbuffer_length(&__uart_rx_ringbuffer[port]);
+#ifdef KALUMA_DUAL_CORE
+  return km_core1_ring_available(KM_CORE1_EVENT_UART(port),
+                                 &__uart_rx_ringbuffer[port]);
+#else
+  return spsc_ringbuffer_length(&__uart_rx_ringbuffer[port]);
+#endif
 }
 
 uint32_t km_uart_read(uint8_t port, uint8_t *buf, size_t len) {
@@ -219,12 +280,23 @@ uint32_t km_uart_read(uint8_t port, uint8_t *buf, size_t len) {
   if ((uart == NULL) || (__uart_status[port].enabled == false)) {
     return EDEVREAD;
   }
-  uint32_t n = ringbuffer_length(&__uart_rx_ringbuffer[port]);
-  if (n > len) {
-    n = len;
+  return spsc_ringbuffer_read(&__uart_rx_ringbuffer[port], buf, len);
+}
+
+int km_uart_get_stats(uint8_t port, km_uart_stats_t *stats, bool reset) {
+  uart_inst_t *uart = __get_uart_no(port);
+  if ((uart == NULL) || (__uart_status[port].enabled == false)) {
+    return EDEVINIT;
   }
-  ringbuffer_read(&__uart_rx_ringbuffer[port], buf, n);
-  return n;
+  spsc_ringbuffer_t *ringbuffer = &__uart_rx_ringbuffer[port];
+  stats->size = ringbuffer->size;
+  stats->length = spsc_ringbuffer_length(ringbuffer);
+  stats->high_water = spsc_ringbuffer_high_water(ringbuffer);
+  stats->overflow = spsc_ringbuffer_overflow(ringbuffer);
+  if (reset) {
+    spsc_ringbuffer_reset_stats(ringbuffer);
+  }
+  return 0;
 }
 
 int km_uart_close(uint8_t port) {
@@ -232,6 +304,19 @@ int km_uart_close(uint8_t port) {
   if ((uart == NULL) || (__uart_status[port].enabled == false)) {
     return EDEVINIT;
   }
+  int ch = __uart_status[port].tx_dma;
+  if (ch >= 0) {
+    dma_channel_abort(ch);
+    dma_channel_unclaim(ch);
+    __uart_status[port].tx_dma = -1;
+  }
+  // stop the producer before freeing the read buffer
+#ifdef KALUMA_DUAL_CORE
+  km_core1_uart_detach(port);
+#else
+  uart_set_irq_enables(uart, false, false);
+  irq_set_enabled((port == 0) ? UART0_IRQ : UART1_IRQ, false);
+#endif
   if (__read_buffer[port]) {
     free(__read_buffer[port]);
     __read_buffer[port] = (uint8_t *)NULL;
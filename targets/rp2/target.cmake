@@ -39,6 +39,8 @@ if(NOT MODULES)
     i2c
     spi
     uart
+    sampler
+    pulse
     graphics
     at
     storage
@@ -87,7 +89,11 @@ set(SOURCES
   ${TARGET_SRC_DIR}/i2c.c
   ${TARGET_SRC_DIR}/spi.c
   ${TARGET_SRC_DIR}/rtc.c
+  ${TARGET_SRC_DIR}/sampler.c
+  ${TARGET_SRC_DIR}/pulse.c
+  ${TARGET_SRC_DIR}/pio_dma.c
   ${TARGET_SRC_DIR}/wdt.c
+  ${TARGET_SRC_DIR}/core1.c
   ${TARGET_SRC_DIR}/main.c
   ${BOARD_DIR}/board.c)
 
@@ -126,14 +132,21 @@ set(TARGET_LIBS c nosys m
   hardware_i2c
   hardware_spi
   hardware_uart
+  hardware_dma
   hardware_pio
   hardware_flash
   pico_aon_timer
   pico_rand
   hardware_watchdog
-  hardware_sync)
+  hardware_sync
+  pico_multicore)
 set(CMAKE_EXE_LINKER_FLAGS "-specs=nano.specs -u _printf_float -Wl,-Map=${OUTPUT_TARGET}.map,--cref,--gc-sections")
 
+# Dual-core mode: core 1 polls the tty and UART ports (-DDUAL_CORE=ON)
+if(DUAL_CORE)
+  add_compile_definitions(KALUMA_DUAL_CORE)
+endif()
+
 # For the pico-w board
 if(BOARD STREQUAL "pico-w" OR BOARD STREQUAL "pico2-w")
   # modules for pico-w
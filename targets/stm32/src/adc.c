@@ -152,6 +152,10 @@ double km_adc_read(uint8_t adcIndex) {
   return (double)adc_buf[adcIndex] / (1 << ADC_RESOLUTION_BIT);
 }
 
+uint16_t km_adc_read_u16(uint8_t adcIndex) {
+  return (uint16_t)(km_adc_read(adcIndex) * 65535);
+}
+
 int km_adc_setup(uint8_t pin) {
   int n = get_adc_index(pin);
   if (n < 0) return ENOPHRPL;
@@ -195,3 +199,11 @@ int km_adc_close(uint8_t pin) {
   }
   return n;
 }
+
+int km_adc_capture_start(const uint8_t *channels, uint8_t count, uint32_t rate,
+                         size_t block_size, uint16_t *buf0, uint16_t *buf1,
+                         km_adc_capture_cb capture_cb, void *arg) {
+  return ENOSYS;
+}
+
+int km_adc_capture_stop() { return 0; }
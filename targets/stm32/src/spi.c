@@ -188,6 +188,21 @@ int km_spi_recv(uint8_t bus, uint8_t send_byte, uint8_t *buf, size_t len,
   return ENOPHRPL;
 }
 
+int km_spi_transfer_async(uint8_t bus, const uint8_t *tx_buf, uint8_t *rx_buf,
+                          size_t len) {
+  int ret;  // no DMA support yet
+  if (tx_buf == NULL) {
+    ret = km_spi_recv(bus, 0xFF, rx_buf, len, 5000);
+  } else if (rx_buf == NULL) {
+    ret = km_spi_send(bus, (uint8_t *)tx_buf, len, 5000);
+  } else {
+    ret = km_spi_sendrecv(bus, (uint8_t *)tx_buf, rx_buf, len, 5000);
+  }
+  return (ret < 0) ? ret : 0;
+}
+
+bool km_spi_transfer_busy(uint8_t bus) { return false; }
+
 int km_set_spi_baudrate(uint8_t bus, uint32_t baudrate) {
   // Need to implement to support SDcard module
   return 0;
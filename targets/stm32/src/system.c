@@ -244,4 +244,9 @@ uint8_t km_running_script_check() {
     return true;
 }
 
+/**
+ * Sleep until an interrupt. SysTick wakes up the core every 1 msec.
+ */
+void km_wait_for_event(uint32_t timeout) { __WFI(); }
+
 void km_custom_infinite_loop() {}
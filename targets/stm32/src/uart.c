@@ -24,7 +24,7 @@
 
 #include "board.h"
 #include "err.h"
-#include "ringbuffer.h"
+#include "spsc_ringbuffer.h"
 
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart2;
@@ -37,7 +37,7 @@ static const uint32_t uart_parity[] = {UART_PARITY_NONE, UART_PARITY_ODD,
 static const uint32_t uart_hw_control[] = {
     UART_HWCONTROL_NONE, UART_HWCONTROL_RTS, UART_HWCONTROL_CTS,
     UART_HWCONTROL_RTS_CTS};
-static ringbuffer_t uart_rx_ringbuffer[KALUMA_UART_NUM];
+static spsc_ringbuffer_t uart_rx_ringbuffer[KALUMA_UART_NUM];
 static uint8_t *read_buffer[] = {NULL, NULL};
 
 /**
@@ -64,7 +64,7 @@ km_uart_pins_t km_uart_get_default_pins(uint8_t port) {
  * This function called by IRQ Handler
  */
 void uart_fill_ringbuffer(uint8_t port, uint8_t ch) {
-  ringbuffer_write(&uart_rx_ringbuffer[port], &ch, sizeof(ch));
+  spsc_ringbuffer_put(&uart_rx_ringbuffer[port], ch);
 }
 
 /**
@@ -99,11 +99,15 @@ int km_uart_setup(uint8_t port, uint32_t baudrate, uint8_t bits,
   puart->Init.Mode = UART_MODE_TX_RX;
   puart->Init.OverSampling = UART_OVERSAMPLING_16;
 
-  read_buffer[port] = (uint8_t *)malloc(buffer_size);
+  size_t size = 1;
+  while (size < buffer_size) {  // must be a power of 2
+    size <<= 1;
+  }
+  read_buffer[port] = (uint8_t *)malloc(size);
   if (read_buffer[port] == NULL) {
     return ENOPHRPL;
   } else {
-    ringbuffer_init(&uart_rx_ringbuffer[port], read_buffer[port], buffer_size);
+    spsc_ringbuffer_init(&uart_rx_ringbuffer[port], read_buffer[port], size);
   }
 
   HAL_StatusTypeDef hal_status = HAL_UART_Init(puart);
@@ -124,19 +128,34 @@ int km_uart_write(uint8_t port, uint8_t *buf, size_t len) {
   return ENOPHRPL;
 }
 
+int km_uart_write_async(uint8_t port, uint8_t *buf, size_t len) {
+  int ret = km_uart_write(port, buf, len);  // no DMA support yet
+  return (ret < 0) ? ret : 0;
+}
+
+bool km_uart_write_busy(uint8_t port) { return false; }
+
 uint32_t km_uart_available(uint8_t port) {
   if ((port != 0) && (port != 1)) return 0;
-  return ringbuffer_length(&uart_rx_ringbuffer[port]);
+  return spsc_ringbuffer_length(&uart_rx_ringbuffer[port]);
 }
 
 uint32_t km_uart_read(uint8_t port, uint8_t *buf, size_t len) {
   if ((port != 0) && (port != 1)) return 0;
-  uint32_t n = ringbuffer_length(&uart_rx_ringbuffer[port]);
-  if (n > len) {
-    n = len;
+  return spsc_ringbuffer_read(&uart_rx_ringbuffer[port], buf, len);
+}
+
+int km_uart_get_stats(uint8_t port, km_uart_stats_t *stats, bool reset) {
+  if ((port != 0) && (port != 1)) return ENOPHRPL;
+  spsc_ringbuffer_t *ringbuffer = &uart_rx_ringbuffer[port];
+  stats->size = ringbuffer->size;
+  stats->length = spsc_ringbuffer_length(ringbuffer);
+  stats->high_water = spsc_ringbuffer_high_water(ringbuffer);
+  stats->overflow = spsc_ringbuffer_overflow(ringbuffer);
+  if (reset) {
+    spsc_ringbuffer_reset_stats(ringbuffer);
   }
-  ringbuffer_read(&uart_rx_ringbuffer[port], buf, n);
-  return n;
+  return 0;
 }
 
 int km_uart_close(uint8_t port) {
@@ -0,0 +1,39 @@
+const { test, start, expect } = require("__ujest");
+const { ADCCapture } = require("adc");
+
+test("[adc] ADCCapture delivers blocks in round-robin order", (done) => {
+  // linux target: pin 27 (channel 1) is a square, pin 29 (channel 3) a sawtooth
+  const capture = new ADCCapture([29, 27], { rate: 10000, blockSize: 100 });
+  expect(capture.pins.join(",")).toBe("27,29");
+  expect(capture.bits).toBe(12);
+  expect(capture.buffer.length).toBe(2 * 100 * capture.blocks);
+  let count = 0;
+  capture.on("data", (data, index) => {
+    expect(data.length).toBe(200);
+    expect(index).toBe(count % capture.blocks);
+    for (let i = 0; i < data.length; i += 2) {
+      expect(data[i] === 0 || data[i] === 4095).toBeTruthy();
+      expect(data[i + 1]).toBeLessThanOrEqual(4095);
+    }
+    count++;
+    if (count === 4) {
+      capture.close();
+      done();
+    }
+  });
+  capture.start();
+});
+
+test("[adc] ADCCapture rejects invalid pins", () => {
+  expect(() => {
+    new ADCCapture([26, 26]);
+  }).toThrow();
+  expect(() => {
+    new ADCCapture([5]);
+  }).toThrow();
+  expect(() => {
+    new ADCCapture([26], { blocks: 2 });
+  }).toThrow();
+});
+
+start(); // start to test
@@ -0,0 +1,99 @@
+// Sequential read/write of a 256 KB file on VFSLittleFS over the on-board
+// flash, through the native block device interface of `Flash` and through
+// a block device implemented in JS (the path taken before the native fast
+// path existed). Run with `kaluma blkdev.bench.js` or upload to a board.
+//
+// WARNING: this erases the filesystem mounted on "/" (all files are lost).
+// The bench runs on the flash blocks of the filesystem, the only area that
+// is safe to overwrite, and formats it again when done.
+//
+// Results (write / read of the 256 KB file):
+//
+//   board    js blkdev              native blkdev
+//   -------  ---------------------  ---------------------
+//   (none)   not measured           not measured
+//
+// No numbers are recorded yet: the tree this bench was written in had
+// neither the JerryScript nor the littlefs sources in lib/, so kaluma
+// could not be built for linux, and no board was at hand. Add a row per
+// board from the two lines printed by this bench.
+const fs = require("fs");
+const { Flash } = require("flash");
+const { VFSLittleFS } = require("vfs_lfs");
+
+const VFS_FLAG_READ = 1;
+const VFS_FLAG_WRITE = 2;
+const VFS_FLAG_CREATE = 4;
+
+const FILE_SIZE = 256 * 1024;
+const CHUNK_SIZE = 4096;
+// filesystem area of each board (see board.js), after storage and program
+const FS_BLOCKS = {
+  linux: [132, 128],
+  pico: [132, 128],
+  "pico-w": [132, 128],
+  pico2: [400, 384],
+  "pico2-w": [384, 384],
+};
+const fs_blocks = FS_BLOCKS[board.name];
+if (!fs_blocks) {
+  throw new Error(`No filesystem area known for board "${board.name}"`);
+}
+const BLOCK_BASE = fs_blocks[0];
+const BLOCK_COUNT = Math.min(fs_blocks[1], 128);
+
+// delegates to Flash from JS, so VFS calls it through jerry_call()
+class JSFlash {
+  constructor(flash) {
+    this.flash = flash;
+  }
+  read(block, buffer, offset) {
+    this.flash.read(block, buffer, offset);
+  }
+  write(block, buffer, offset) {
+    this.flash.write(block, buffer, offset);
+  }
+  ioctl(op, arg) {
+    return this.flash.ioctl(op, arg);
+  }
+}
+
+function bench(name, blkdev) {
+  const vfs = new VFSLittleFS(blkdev);
+  vfs.mkfs();
+  vfs.mount();
+  const chunk = new Uint8Array(CHUNK_SIZE);
+  for (let i = 0; i < chunk.length; i++) chunk[i] = i & 0xff;
+
+  let t = millis();
+  let fd = vfs.open("/bench.bin", VFS_FLAG_WRITE | VFS_FLAG_CREATE, 0);
+  for (let pos = 0; pos < FILE_SIZE; pos += CHUNK_SIZE) {
+    vfs.write(fd, chunk, 0, CHUNK_SIZE, pos);
+  }
+  vfs.close(fd);
+  const write_ms = millis() - t;
+
+  t = millis();
+  fd = vfs.open("/bench.bin", VFS_FLAG_READ, 0);
+  for (let pos = 0; pos < FILE_SIZE; pos += CHUNK_SIZE) {
+    vfs.read(fd, chunk, 0, CHUNK_SIZE, pos);
+  }
+  vfs.close(fd);
+  const read_ms = millis() - t;
+
+  vfs.unlink("/bench.bin");
+  vfs.unmount();
+  console.log(`${name}: write ${write_ms} ms, read ${read_ms} ms`);
+}
+
+console.log(
+  `WARNING: erasing the filesystem on "/" (flash blocks ${BLOCK_BASE}..` +
+    `${BLOCK_BASE + BLOCK_COUNT - 1}), all files are lost`
+);
+fs.unmount("/");
+bench("js blkdev", new JSFlash(new Flash(BLOCK_BASE, BLOCK_COUNT)));
+bench("native blkdev", new Flash(BLOCK_BASE, BLOCK_COUNT));
+// an empty filesystem over the whole area again
+const bd = new Flash(fs_blocks[0], fs_blocks[1]);
+fs.mkfs(bd, "lfs");
+fs.mount("/", bd, "lfs", true);
@@ -62,4 +62,21 @@ test("[flash] ioctl(6) - erase block", (done) => {
   done();
 });
 
+test("[flash] read() into a subarray", (done) => {
+  const flash = new Flash(BLOCK_BASE, BLOCK_COUNT);
+  let buf1 = new Uint8Array(16);
+  buf1.fill(33);
+  flash.ioctl(6, 0);
+  flash.write(0, buf1);
+
+  // only the view should be filled
+  let buf2 = new Uint8Array(32);
+  flash.read(0, buf2.subarray(8, 24));
+  expect(buf2[7]).toBe(0);
+  expect(buf2[8]).toBe(33);
+  expect(buf2[23]).toBe(33);
+  expect(buf2[24]).toBe(0);
+  done();
+});
+
 start(); // start to test
@@ -0,0 +1,146 @@
+const { test, start, expect } = require("__ujest");
+const { BufferedGraphicsContext } = require("graphics");
+
+function create(bpp, rotation) {
+  const regions = [];
+  const gc = new BufferedGraphicsContext(128, 64, {
+    rotation: rotation,
+    bpp: bpp,
+    display: (buffer, region) => {
+      regions.push(region);
+    },
+  });
+  return { gc, regions };
+}
+
+test("[graphics] the first display() sends the whole screen", () => {
+  const { gc, regions } = create(16, 0);
+  gc.display();
+  expect(regions[0].x).toBe(0);
+  expect(regions[0].y).toBe(0);
+  expect(regions[0].width).toBe(128);
+  expect(regions[0].height).toBe(64);
+  expect(regions[0].offset).toBe(0);
+  expect(regions[0].stride).toBe(256);
+});
+
+test("[graphics] display() sends only the changed region", () => {
+  const { gc, regions } = create(16, 0);
+  gc.display();
+  gc.display();
+  expect(regions[1].width).toBe(0);
+  expect(regions[1].height).toBe(0);
+  gc.setPixel(10, 20, 0xffff);
+  gc.fillRect(30, 5, 4, 3);
+  gc.display();
+  expect(regions[2].x).toBe(10);
+  expect(regions[2].y).toBe(5);
+  expect(regions[2].width).toBe(24);
+  expect(regions[2].height).toBe(16);
+  expect(regions[2].offset).toBe((5 * 128 + 10) * 2);
+});
+
+test("[graphics] 1-bit regions cover whole pages in device coordinates", () => {
+  const { gc, regions } = create(1, 1);
+  gc.display();
+  gc.drawLine(3, 100, 3, 101); // device (26..27, 3)
+  gc.display();
+  expect(regions[1].x).toBe(26);
+  expect(regions[1].y).toBe(0);
+  expect(regions[1].width).toBe(2);
+  expect(regions[1].height).toBe(8);
+  expect(regions[1].offset).toBe(26);
+  expect(regions[1].stride).toBe(128);
+});
+
+test("[graphics] buffers larger than 64KB, in native memory", () => {
+  const gc = new BufferedGraphicsContext(240, 240, {
+    bpp: 16,
+    nativeBuffer: true,
+  });
+  const buffer = gc.buffer;
+  expect(buffer.length).toBe(240 * 240 * 2);
+  gc.fillScreen(0x1234);
+  expect(buffer[0]).toBe(0x12);
+  expect(buffer[buffer.length - 1]).toBe(0x34);
+  gc.setPixel(239, 239, 0xabcd);
+  expect(gc.getPixel(239, 239)).toBe(0xabcd);
+  expect(buffer[buffer.length - 2]).toBe(0xab);
+});
+
+test("[graphics] strip mode draws the frame a strip at a time", () => {
+  const strips = [];
+  const gc = new BufferedGraphicsContext(240, 320, {
+    bpp: 16,
+    stripHeight: 16,
+    display: (buffer, region) => {
+      strips.push({ region, first: buffer[0], pixel: buffer[12 * 480] });
+    },
+  });
+  expect(gc.buffer.length).toBe(240 * 16 * 2);
+  gc.fillScreen(0x1234);
+  gc.setPixel(0, 300, 0xabcd);
+  gc.display();
+  expect(strips.length).toBe(20);
+  expect(strips[18].region.x).toBe(0);
+  expect(strips[18].region.y).toBe(288);
+  expect(strips[18].region.width).toBe(240);
+  expect(strips[18].region.height).toBe(16);
+  expect(strips[18].region.offset).toBe(0);
+  expect(strips[18].region.stride).toBe(480);
+  expect(strips[0].first).toBe(0x12);
+  expect(strips[17].pixel).toBe(0x12);
+  expect(strips[18].pixel).toBe(0xab);
+  // the next frame starts cleared
+  gc.display();
+  expect(strips.length).toBe(40);
+  expect(strips[20].first).toBe(0);
+});
+
+test("[graphics] strip mode draws small bitmaps as at the call", () => {
+  const pixels = [];
+  const gc = new BufferedGraphicsContext(240, 320, {
+    bpp: 16,
+    stripHeight: 16,
+    display: (buffer, region) => {
+      if (region.y === 0) pixels.push(buffer[0], buffer[1]);
+    },
+  });
+  const data = new Uint8Array([0xab, 0xcd]);
+  gc.drawBitmap(0, 0, { width: 1, height: 1, bpp: 16, data });
+  data[0] = 0;
+  data[1] = 0;
+  gc.display();
+  expect(pixels[0]).toBe(0xab);
+  expect(pixels[1]).toBe(0xcd);
+});
+
+test("[graphics] getPixel is not supported in strip mode", () => {
+  const gc = new BufferedGraphicsContext(240, 320, {
+    bpp: 16,
+    stripHeight: 16,
+    display: () => {},
+  });
+  gc.setPixel(0, 0, 0xabcd);
+  expect(() => {
+    gc.getPixel(0, 0);
+  }).toThrow();
+});
+
+test("[graphics] 1-bit strips are whole pages", () => {
+  const regions = [];
+  const gc = new BufferedGraphicsContext(128, 64, {
+    bpp: 1,
+    stripHeight: 5,
+    display: (buffer, region) => {
+      regions.push(region);
+    },
+  });
+  expect(gc.buffer.length).toBe(128);
+  gc.display();
+  expect(regions.length).toBe(8);
+  expect(regions[7].y).toBe(56);
+  expect(regions[7].height).toBe(8);
+});
+
+start(); // start to test
@@ -0,0 +1,50 @@
+const { test, start, expect } = require("__ujest");
+const { I2C } = require("i2c");
+
+const BUS = 0;
+const ADDR = 0x68;
+
+test("[i2c] transaction() returns the number of bytes read", () => {
+  const i2c = new I2C(BUS);
+  const buffer = new Uint8Array(20);
+  const ops = [
+    { address: ADDR, write: 0x3b },
+    { address: ADDR, read: 6 },
+    { address: ADDR, memAddress: 0x43, read: 6 },
+    { address: ADDR, memAddress: 0x6b, write: new Uint8Array([0]) },
+    { address: ADDR, memAddress: 0x75, read: 1, offset: 19 },
+  ];
+  expect(i2c.transaction(ops, buffer)).toBe(13);
+  i2c.close();
+});
+
+test("[i2c] transaction() reads into a subarray", () => {
+  const i2c = new I2C(BUS);
+  const buffer = new Uint8Array(16);
+  const ops = [{ address: ADDR, read: 8 }];
+  expect(i2c.transaction(ops, buffer.subarray(8))).toBe(8);
+  expect(() => {
+    i2c.transaction(ops, buffer.subarray(12));
+  }).toThrow();
+  i2c.close();
+});
+
+test("[i2c] transaction() rejects invalid operations", () => {
+  const i2c = new I2C(BUS);
+  const buffer = new Uint8Array(4);
+  expect(() => {
+    i2c.transaction([{ address: ADDR }], buffer);
+  }).toThrow();
+  expect(() => {
+    i2c.transaction([{ address: ADDR, read: 1 }], new Uint16Array(4));
+  }).toThrow();
+  expect(() => {
+    i2c.transaction([{ address: ADDR, read: -1 }], buffer);
+  }).toThrow();
+  expect(() => {
+    i2c.transaction([{ address: ADDR, read: 2, offset: -1 }], buffer);
+  }).toThrow();
+  i2c.close();
+});
+
+start(); // start to test
@@ -0,0 +1,70 @@
+const { test, start, expect } = require("__ujest");
+
+test("[interrupt] attach and detach a per-event callback", () => {
+  attachInterrupt(2, (pin, mode, time) => {}, RISING);
+  expect(interruptOverflow(2)).toBe(0);
+  detachInterrupt(2);
+});
+
+test("[interrupt] attach and detach a batch callback", () => {
+  attachInterrupt(3, (pin, modes, times) => {}, CHANGE, { batch: true });
+  attachInterrupt(3, (pin, modes, times) => {}, FALLING, { batch: true });
+  detachInterrupt(3);
+});
+
+test("[interrupt] a level change calls the callback", (done) => {
+  // linux target: writing a pin changes its level like an external signal
+  const modes = [];
+  pinMode(4, OUTPUT);
+  attachInterrupt(
+    4,
+    (pin, mode, time) => {
+      expect(pin).toBe(4);
+      modes.push(mode);
+      if (modes.length === 2) {
+        expect(modes[0]).toBe(RISING);
+        expect(modes[1]).toBe(FALLING);
+        detachInterrupt(4);
+        done();
+      }
+    },
+    CHANGE
+  );
+  digitalWrite(4, HIGH);
+  digitalWrite(4, LOW);
+});
+
+test("[interrupt] an edge watch is called for each edge", (done) => {
+  let count = 0;
+  pinMode(5, OUTPUT);
+  const id = setWatch(
+    (pin) => {
+      expect(pin).toBe(5);
+      count++;
+      if (count === 2) {
+        clearWatch(id);
+        done();
+      }
+    },
+    5,
+    RISING
+  );
+  digitalWrite(5, HIGH);
+  digitalWrite(5, LOW);
+  digitalWrite(5, HIGH);
+  digitalWrite(5, LOW);
+});
+
+test("[interrupt] rejects invalid arguments", () => {
+  expect(() => {
+    attachInterrupt(2, () => {}, LOW_LEVEL);
+  }).toThrow();
+  expect(() => {
+    attachInterrupt(2, () => {}, CHANGE, true);
+  }).toThrow();
+  expect(() => {
+    attachInterrupt(200, () => {}, CHANGE);
+  }).toThrow();
+});
+
+start(); // start to test
@@ -0,0 +1,38 @@
+const { test, start, expect } = require("__ujest");
+const pulse = require("pulse");
+
+test("[pulse] capture records a generated waveform", (done) => {
+  // linux target: captures see the levels of generators on the same pin
+  const pin = 2;
+  const waveform = new Uint32Array([3000, 1000, 2000, 1000, 4000]);
+  const data = new Uint32Array(16);
+  pulse.capture(pin, data, { startState: HIGH, timeout: 20000 }, (d, count) => {
+    expect(count).toBe(waveform.length);
+    expect(d.length).toBe(waveform.length);
+    for (let i = 0; i < count; i++) {
+      expect(d[i]).toBe(waveform[i]);
+    }
+    done();
+  });
+  pulse.generate(pin, waveform, { startState: HIGH }, (count) => {
+    expect(count).toBe(waveform.length);
+  });
+});
+
+test("[pulse] stop aborts a generation", (done) => {
+  const id = pulse.generate(3, new Uint32Array([1000000]), {}, () => {
+    throw new Error("should not be called");
+  });
+  setTimeout(() => {
+    pulse.stop(id);
+    done();
+  }, 10);
+});
+
+test("[pulse] rejects non-Uint32Array data", () => {
+  expect(() => {
+    pulse.capture(2, [1, 2, 3], {}, () => {});
+  }).toThrow();
+});
+
+start(); // start to test
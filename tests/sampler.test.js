@@ -0,0 +1,60 @@
+const { test, start, expect } = require("__ujest");
+const { Sampler } = require("sampler");
+
+test("[sampler] emits 'data' for each filled block", (done) => {
+  const sampler = new Sampler({ adc: [26], gpio: [0], rate: 1000, blockSize: 10 });
+  expect(sampler.channels).toBe(2);
+  expect(sampler.buffer.length).toBe(2 * 10 * sampler.blocks);
+  let count = 0;
+  sampler.on("data", (data, index) => {
+    expect(data.length).toBe(20);
+    expect(index).toBe(count % sampler.blocks);
+    count++;
+    if (count === 3) {
+      sampler.stop();
+      expect(sampler.stats().blocks).toBeGreaterThanOrEqual(3);
+      expect(sampler.stats().overflow).toBe(0);
+      sampler.close();
+      done();
+    }
+  });
+  sampler.start();
+});
+
+test("[sampler] can be restarted in the 'data' callback", (done) => {
+  const sampler = new Sampler({ adc: [26], rate: 1000, blockSize: 10 });
+  let restarted = false;
+  let count = 0;
+  sampler.on("data", (data, index) => {
+    if (!restarted) {
+      restarted = true;
+      sampler.stop();
+      sampler.start();
+      return;
+    }
+    // delivery starts over from the first block
+    expect(index).toBe(count % sampler.blocks);
+    count++;
+    if (count === 3) {
+      sampler.stop();
+      expect(sampler.stats().overflow).toBe(0);
+      sampler.close();
+      done();
+    }
+  });
+  sampler.start();
+});
+
+test("[sampler] rejects invalid options", () => {
+  expect(() => {
+    new Sampler({});
+  }).toThrow();
+  expect(() => {
+    new Sampler({ adc: [26], rate: 0 });
+  }).toThrow();
+  expect(() => {
+    new Sampler({ adc: [26], blocks: 1 });
+  }).toThrow();
+});
+
+start(); // start to test
@@ -0,0 +1,64 @@
+const { test, start, expect } = require("__ujest");
+const { SPI } = require("spi");
+
+const BUS = 0;
+
+test("[spi] transferAsync() resolves with received data", (done) => {
+  const spi = new SPI(BUS);
+  const data = new Uint8Array([1, 2, 3, 4, 5, 6, 7, 8]);
+  spi.transferAsync(data).then((received) => {
+    // linux target loops MISO back to MOSI
+    expect(received.length).toBe(data.length);
+    expect(received.join(",")).toBe(data.join(","));
+    spi.close();
+    done();
+  });
+});
+
+test("[spi] sendAsync() resolves with the number of bytes", (done) => {
+  const spi = new SPI(BUS);
+  spi.sendAsync("hello").then((n) => {
+    expect(n).toBe(5);
+    spi.close();
+    done();
+  });
+});
+
+test("[spi] queued requests complete in order", (done) => {
+  const spi = new SPI(BUS);
+  const order = [];
+  spi.sendAsync(new Uint8Array(256)).then(() => order.push(1));
+  spi.recvAsync(4).then((received) => {
+    order.push(2);
+    expect(received.join(",")).toBe("255,255,255,255");
+  });
+  spi.transferAsync(new Uint8Array([9])).then(() => {
+    order.push(3);
+    expect(order.join(",")).toBe("1,2,3");
+    spi.close();
+    done();
+  });
+});
+
+test("[spi] close() rejects the queued requests", (done) => {
+  const spi = new SPI(BUS);
+  let sent = false;
+  spi.sendAsync(new Uint8Array(256)).then(() => {
+    sent = true;
+  });
+  spi.recvAsync(4).then(
+    () => {
+      throw new Error("should not be resolved");
+    },
+    (err) => {
+      expect(err.errno).toBe(-125); // ECANCELED
+      setTimeout(() => {
+        expect(sent).toBeTruthy();
+        done();
+      }, 10);
+    }
+  );
+  spi.close();
+});
+
+start(); // start to test
@@ -12,3 +12,10 @@ cmd("../build/kaluma", ["flash.test.js"]);
 cmd("../build/kaluma", ["vfs_lfs.test.js"]);
 cmd("../build/kaluma", ["vfs_fat.test.js"]);
 cmd("../build/kaluma", ["fs.test.js"]);
+cmd("../build/kaluma", ["spi.test.js"]);
+cmd("../build/kaluma", ["i2c.test.js"]);
+cmd("../build/kaluma", ["sampler.test.js"]);
+cmd("../build/kaluma", ["adc.test.js"]);
+cmd("../build/kaluma", ["pulse.test.js"]);
+cmd("../build/kaluma", ["interrupt.test.js"]);
+cmd("../build/kaluma", ["graphics.test.js"]);
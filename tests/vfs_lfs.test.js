@@ -1,6 +1,7 @@
 const { test, start, expect } = require("__ujest");
 const { RAMBlockDev } = require("__test_utils");
 const { VFSLittleFS } = require("vfs_lfs");
+const { Flash } = require("flash");
 
 // constants for flags
 const VFS_FLAG_READ = 1;
@@ -301,4 +302,29 @@ test("[vfs_lfs] rename()", (done) => {
   done();
 });
 
+test("[vfs_lfs] native block device (Flash)", (done) => {
+  const vfs = new VFSLittleFS(new Flash(0, 64));
+  vfs.mkfs();
+  vfs.mount();
+  const fname = "/native.bin";
+
+  // file write (spans several blocks)
+  let buf = new Uint8Array(10000);
+  for (let i = 0; i < buf.length; i++) buf[i] = i & 0xff;
+  let fd = vfs.open(fname, VFS_FLAG_WRITE | VFS_FLAG_CREATE, 0);
+  vfs.write(fd, buf, 0, buf.length, 0);
+  vfs.close(fd);
+
+  // file read
+  let buf2 = new Uint8Array(buf.length);
+  let fd2 = vfs.open(fname, VFS_FLAG_READ, 0);
+  vfs.read(fd2, buf2, 0, buf2.length, 0);
+  vfs.close(fd2);
+  expect(buf.join(",")).toBe(buf2.join(","));
+
+  vfs.unlink(fname);
+  vfs.unmount();
+  done();
+});
+
 start();
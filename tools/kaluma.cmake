@@ -81,6 +81,8 @@ list(APPEND SOURCES
   ${SRC_DIR}/prog.c
   ${SRC_DIR}/ymodem.c
   ${SRC_DIR}/ringbuffer.c
+  ${SRC_DIR}/spsc_ringbuffer.c
+  ${SRC_DIR}/blkdev.c
   ${KALUMA_GENERATED_C})
 
 FOREACH(MOD ${MODULES})